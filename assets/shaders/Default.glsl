@@ -3,7 +3,11 @@
 
 layout(location = 0) in vec3 a_Position;
 
-uniform mat4 u_ViewProjection;
+layout(std140, binding = 0) uniform Camera
+{
+	mat4 u_ViewProjection;
+};
+
 uniform mat4 u_Transform;
 uniform vec4 u_Color;
 
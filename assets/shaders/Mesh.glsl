@@ -1,13 +1,31 @@
 #type vertex
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout(location = 0) in vec3 a_Position;
-layout(location = 1) in vec3 a_Normal;
+// Floats, octahedral snorm16 x2 or snorm 10:10:10:2, see NormalEncoding
+layout(location = 1) in vec4 a_Normal;
+layout(location = 2) in vec4 a_Color;
 
-uniform mat4 u_ViewProjection;
-uniform mat4 u_Transform;
-uniform vec4 u_Color;
-uniform int u_EntityID;
+layout(std140, binding = 0) uniform Camera
+{
+	mat4 u_ViewProjection;
+};
+
+// Filled once per frame by Renderer::EndScene, one per instance
+struct DrawData
+{
+	mat4 Transform;
+	vec4 Color;
+	int EntityID;
+	// 0 float, 1 octahedral, 2 packed 10:10:10:2
+	int NormalEncoding;
+};
+
+layout(std430, binding = 1) readonly buffer Draws
+{
+	DrawData u_Draws[];
+};
 
 struct VertexOutput
 {
@@ -19,10 +37,12 @@ layout (location = 1) out flat int v_EntityID;
 
 void main()
 {
-	Output.Color = u_Color;
-	v_EntityID = u_EntityID;
+	DrawData draw = u_Draws[gl_BaseInstanceARB + gl_InstanceID];
+
+	Output.Color = draw.Color * a_Color;
+	v_EntityID = draw.EntityID;
 
-	gl_Position = u_ViewProjection * u_Transform * vec4(a_Position, 1.0);
+	gl_Position = u_ViewProjection * draw.Transform * vec4(a_Position, 1.0);
 }
 
 #type fragment
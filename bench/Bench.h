@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Base.h"
+
+#include <chrono>
+
+namespace GLMV {
+
+    class BenchTimer
+    {
+        public:
+            BenchTimer() { Reset(); }
+
+            void Reset() { m_Start = std::chrono::high_resolution_clock::now(); }
+
+            double ElapsedSeconds() const
+            {
+                return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - m_Start).count();
+            }
+
+            double ElapsedMillis() const { return ElapsedSeconds() * 1000.0; }
+        private:
+            std::chrono::time_point<std::chrono::high_resolution_clock> m_Start;
+    };
+
+    // Every benchmark takes the command line arguments after its name
+    // and returns the process exit code.
+    using BenchFn = int(*)(const std::vector<std::string>& args);
+
+    int ObjParserBench(const std::vector<std::string>& args);
+    int NormalBench(const std::vector<std::string>& args);
+    int ObjBackendBench(const std::vector<std::string>& args);
+    int RenderQueueBench(const std::vector<std::string>& args);
+
+}
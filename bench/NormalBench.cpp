@@ -0,0 +1,156 @@
+#include "Bench.h"
+
+#include "Core/Geometry/NormalGenerator.h"
+#include "Core/Loaders/MappedFile.h"
+#include "Core/Loaders/ObjParser.h"
+#include "Core/ThreadPool.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace GLMV {
+
+    // The scatter loop ObjLoader ran before NormalGenerator, kept here as
+    // the baseline: unit face normals added with bounds checked at().
+    static void GenerateLegacy(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indexes, std::vector<glm::vec3>& normals)
+    {
+        normals.assign(vertices.size(), glm::vec3());
+        for (size_t idx = 0; idx + 2 < indexes.size(); idx += 3)
+        {
+            int ix = indexes.at(idx), iy = indexes.at(idx + 1), iz = indexes.at(idx + 2);
+            glm::vec3 vx = vertices.at(ix), vy = vertices.at(iy), vz = vertices.at(iz);
+            glm::vec3 normal = glm::normalize(glm::cross(vy - vx, vz - vx));
+            normals.at(ix) += normal;
+            normals.at(iy) += normal;
+            normals.at(iz) += normal;
+        }
+        for (auto& normal : normals)
+            normal = glm::normalize(normal);
+    }
+
+    // Regular grid of width x width vertices on a wavy surface
+    static void GenerateGrid(uint32_t width, std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indexes)
+    {
+        vertices.clear();
+        indexes.clear();
+        vertices.reserve((size_t)width * width);
+        indexes.reserve((size_t)(width - 1) * (width - 1) * 6);
+
+        for (uint32_t z = 0; z < width; ++z)
+            for (uint32_t x = 0; x < width; ++x)
+                vertices.push_back(glm::vec3(x * 0.01f, 0.25f * sinf(x * 0.05f) * cosf(z * 0.05f), z * 0.01f));
+
+        for (uint32_t z = 0; z + 1 < width; ++z)
+        {
+            for (uint32_t x = 0; x + 1 < width; ++x)
+            {
+                uint32_t a = z * width + x, b = a + 1, c = a + width + 1, d = a + width;
+                uint32_t quad[6] = { a, b, c, a, c, d };
+                indexes.insert(indexes.end(), quad, quad + 6);
+            }
+        }
+    }
+
+    template<typename Fn>
+    static double Best(int repeat, const Fn& fn)
+    {
+        double best = 0;
+        for (int i = 0; i < repeat; ++i)
+        {
+            BenchTimer timer;
+            fn();
+            double seconds = timer.ElapsedSeconds();
+            best = i == 0 ? seconds : std::min(best, seconds);
+        }
+        return best;
+    }
+
+    // Largest angle in degrees between matching normals
+    static double MaxAngle(const std::vector<glm::vec3>& a, const std::vector<glm::vec3>& b)
+    {
+        double worst = 0;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            float cosine = glm::dot(a[i], b[i]);
+            if (std::isfinite(cosine))
+                worst = std::max(worst, (double)glm::degrees(std::acos(glm::clamp(cosine, -1.0f, 1.0f))));
+        }
+        return worst;
+    }
+
+    int NormalBench(const std::vector<std::string>& args)
+    {
+        int repeat = 3;
+        uint32_t grid = 2048;
+        uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::string path;
+
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            if (args[i] == "--repeat" && i + 1 < args.size())
+                repeat = std::max(1, atoi(args[++i].c_str()));
+            else if (args[i] == "--grid" && i + 1 < args.size())
+                grid = std::max(2, atoi(args[++i].c_str()));
+            else if (args[i] == "--threads" && i + 1 < args.size())
+                maxThreads = std::max(1, atoi(args[++i].c_str()));
+            else
+                path = args[i];
+        }
+
+        std::vector<glm::vec3> vertices;
+        std::vector<uint32_t> indexes;
+        if (path.empty())
+        {
+            GenerateGrid(grid, vertices, indexes);
+            path = std::to_string(grid) + "x" + std::to_string(grid) + " grid";
+        }
+        else
+        {
+            Ref<MappedFile> file = MappedFile::Create(path);
+            ObjData data;
+            if (!file->IsValid() || !ObjParser::Parse(file->begin(), file->end(), data, &ThreadPool::Get()))
+            {
+                LOG_ERROR("Could not open '%s'", path.c_str());
+                return 1;
+            }
+
+            vertices = std::move(data.Positions);
+            for (const auto& group : data.Groups)
+                indexes.insert(indexes.end(), group.Indexes.begin(), group.Indexes.end());
+        }
+
+        LOG_INFO("%s: %zu vertices, %zu triangles", path.c_str(), vertices.size(), indexes.size() / 3);
+
+        std::vector<glm::vec3> legacy, area, angle;
+        double legacyTime = Best(repeat, [&]() { GenerateLegacy(vertices, indexes, legacy); });
+        double areaTime = Best(repeat, [&]() {
+            NormalGenerator::Generate(vertices.data(), vertices.size(), indexes.data(), indexes.size(), NormalWeighting::Area, area);
+        });
+        double angleTime = Best(repeat, [&]() {
+            NormalGenerator::Generate(vertices.data(), vertices.size(), indexes.data(), indexes.size(), NormalWeighting::Angle, angle);
+        });
+
+        LOG_INFO("  legacy          %9.2f ms", legacyTime * 1000.0);
+        LOG_INFO("  area            %9.2f ms  %.2fx, %.2f deg from legacy", areaTime * 1000.0, legacyTime / areaTime, MaxAngle(legacy, area));
+        LOG_INFO("  angle           %9.2f ms  %.2fx, %.2f deg from legacy", angleTime * 1000.0, legacyTime / angleTime, MaxAngle(legacy, angle));
+
+        // Thread scaling, the calling thread counts as one of them
+        int status = 0;
+        for (uint32_t threads = 2; threads <= maxThreads; threads *= 2)
+        {
+            ThreadPool pool(threads - 1);
+            std::vector<glm::vec3> parallel;
+            double time = Best(repeat, [&]() {
+                NormalGenerator::Generate(vertices.data(), vertices.size(), indexes.data(), indexes.size(), NormalWeighting::Area, parallel, &pool);
+            });
+
+            bool same = memcmp(parallel.data(), area.data(), area.size() * sizeof(glm::vec3)) == 0;
+            LOG_INFO("  area %2u threads %9.2f ms  %.2fx, output %s", threads, time * 1000.0, legacyTime / time, same ? "identical" : "DIFFERS");
+            if (!same)
+                status = 1;
+        }
+
+        return status;
+    }
+
+}
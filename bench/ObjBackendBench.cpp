@@ -0,0 +1,226 @@
+#include "Bench.h"
+
+#include "Core/Loaders/ObjBackend.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace GLMV {
+
+    static const ObjBackendType s_Backends[] = { ObjBackendType::Native, ObjBackendType::TinyObj };
+
+    struct BackendRun
+    {
+        double Seconds = 0;
+        // Peak resident memory growth while parsing, 0 when unknown
+        uint64_t PeakBytes = 0;
+        bool Ok = false;
+    };
+
+    static uint64_t PeakResident()
+    {
+#ifndef _WIN32
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return (uint64_t)usage.ru_maxrss;
+#else
+        return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    static BackendRun RunBackend(ObjBackendType type, const std::string& path, int repeat)
+    {
+        BackendRun run;
+        Scope<ObjBackend> backend = ObjBackend::Create(type);
+        uint64_t baseline = PeakResident();
+
+        for (int i = 0; i < repeat; ++i)
+        {
+            ObjData data;
+            BenchTimer timer;
+            run.Ok = backend->Parse(path, data);
+            double seconds = timer.ElapsedSeconds();
+            run.Seconds = i == 0 ? seconds : std::min(run.Seconds, seconds);
+        }
+
+        run.PeakBytes = PeakResident() - baseline;
+        return run;
+    }
+
+    // Peak RSS is per process, so every backend runs in a fresh child
+    // where the high water mark is not left over from an earlier one
+    static BackendRun RunIsolated(ObjBackendType type, const std::string& path, int repeat)
+    {
+#ifndef _WIN32
+        int fds[2];
+        if (pipe(fds) == 0)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                close(fds[0]);
+                BackendRun run = RunBackend(type, path, repeat);
+                ssize_t written = write(fds[1], &run, sizeof(run));
+                _exit(written == sizeof(run) ? 0 : 1);
+            }
+
+            close(fds[1]);
+            BackendRun run;
+            bool received = pid > 0 && read(fds[0], &run, sizeof(run)) == sizeof(run);
+            close(fds[0]);
+            if (pid > 0)
+                waitpid(pid, nullptr, 0);
+            if (received)
+                return run;
+        }
+#endif
+        return RunBackend(type, path, repeat);
+    }
+
+    // Both backends must give the same triangles in file order with the
+    // same attribute values and materials. Groups may be split differently,
+    // since tinyobjloader also starts one at every o/g, and it drops the
+    // name of a material missing from the mtl files, so an empty name
+    // matches any.
+    static bool SameOutput(const ObjData& a, const ObjData& b, std::string& reason)
+    {
+        struct CornerValue
+        {
+            glm::vec3 Position;
+            glm::vec2 TexCoord;
+            glm::vec3 Normal;
+            const std::string* Material;
+        };
+
+        auto flatten = [](const ObjData& data) {
+            std::vector<CornerValue> corners;
+            for (const auto& group : data.Groups)
+            {
+                for (size_t i = 0; i < group.Indexes.size(); ++i)
+                {
+                    CornerValue corner;
+                    uint32_t texCoord = group.TexCoordIndexes.empty() ? ObjParser::None : group.TexCoordIndexes[i];
+                    uint32_t normal = group.NormalIndexes.empty() ? ObjParser::None : group.NormalIndexes[i];
+                    corner.Position = group.Indexes[i] < data.Positions.size() ? data.Positions[group.Indexes[i]] : glm::vec3(NAN);
+                    corner.TexCoord = texCoord < data.TexCoords.size() ? data.TexCoords[texCoord] : glm::vec2(0.0f);
+                    corner.Normal = normal < data.Normals.size() ? data.Normals[normal] : glm::vec3(0.0f);
+                    corner.Material = &group.Material;
+                    corners.push_back(corner);
+                }
+            }
+            return corners;
+        };
+
+        // The parsers round decimal text slightly differently
+        auto close = [](float x, float y) { return std::fabs(x - y) <= 1e-5f * std::max(1.0f, std::fabs(x)); };
+
+        std::vector<CornerValue> ca = flatten(a), cb = flatten(b);
+        if (ca.size() != cb.size())
+        {
+            reason = std::to_string(ca.size() / 3) + " vs " + std::to_string(cb.size() / 3) + " triangles";
+            return false;
+        }
+
+        for (size_t i = 0; i < ca.size(); ++i)
+        {
+            const CornerValue& x = ca[i];
+            const CornerValue& y = cb[i];
+            const char* differs = nullptr;
+            if (!x.Material->empty() && !y.Material->empty() && *x.Material != *y.Material)
+                differs = "material";
+            for (int c = 0; c < 3 && !differs; ++c)
+            {
+                if (!close(x.Position[c], y.Position[c]))
+                    differs = "position";
+                else if (!close(x.Normal[c], y.Normal[c]))
+                    differs = "normal";
+            }
+            for (int c = 0; c < 2 && !differs; ++c)
+            {
+                if (!close(x.TexCoord[c], y.TexCoord[c]))
+                    differs = "texcoord";
+            }
+
+            if (differs)
+            {
+                reason = std::string(differs) + " of triangle " + std::to_string(i / 3);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    int ObjBackendBench(const std::vector<std::string>& args)
+    {
+        int repeat = 3;
+        std::vector<std::string> files;
+
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            if (args[i] == "--repeat" && i + 1 < args.size())
+                repeat = std::max(1, atoi(args[++i].c_str()));
+            else
+                files.push_back(args[i]);
+        }
+
+        if (files.empty())
+            files.push_back("assets/examples/wood/Wood_Texture.obj");
+
+        int status = 0;
+        for (const auto& path : files)
+        {
+            LOG_INFO("%s", path.c_str());
+
+            double fastest = 0;
+            const char* winner = "";
+            for (ObjBackendType type : s_Backends)
+            {
+                BackendRun run = RunIsolated(type, path, repeat);
+                const char* name = ObjBackend::Create(type)->GetName();
+                if (!run.Ok)
+                {
+                    LOG_ERROR("  %-8s failed", name);
+                    status = 1;
+                    continue;
+                }
+
+                LOG_INFO("  %-8s %9.2f ms  peak RSS +%.1f MB", name, run.Seconds * 1000.0, run.PeakBytes / (1024.0 * 1024.0));
+                if (fastest == 0 || run.Seconds < fastest)
+                {
+                    fastest = run.Seconds;
+                    winner = name;
+                }
+            }
+
+            std::vector<ObjData> outputs(std::size(s_Backends));
+            for (size_t i = 0; i < outputs.size(); ++i)
+                ObjBackend::Create(s_Backends[i])->Parse(path, outputs[i]);
+
+            for (size_t i = 1; i < outputs.size(); ++i)
+            {
+                std::string reason;
+                bool same = SameOutput(outputs[0], outputs[i], reason);
+                LOG_INFO("  %s vs %s: output %s%s", ObjBackend::Create(s_Backends[0])->GetName(), ObjBackend::Create(s_Backends[i])->GetName(),
+                    same ? "equivalent" : "DIFFERS at ", reason.c_str());
+                if (!same)
+                    status = 1;
+            }
+
+            LOG_INFO("  fastest: %s", winner);
+        }
+
+        return status;
+    }
+
+}
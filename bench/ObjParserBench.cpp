@@ -0,0 +1,303 @@
+#include "Bench.h"
+
+#include "Core/Loaders/MappedFile.h"
+#include "Core/Loaders/ObjParser.h"
+#include "Core/ThreadPool.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace GLMV {
+
+    // The getline/istringstream parser ObjLoader used before the mapped
+    // tokenizer, kept here as the baseline.
+    static bool ParseLegacy(const std::string& path, ObjData& data)
+    {
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        if (!in)
+            return false;
+
+        ObjGroup* group = nullptr;
+        std::string line;
+        std::string meshName;
+        while (std::getline(in, line))
+        {
+            std::istringstream iss(line);
+            std::string token;
+
+            iss >> token;
+
+            if (token.size() and token[0] == '#') continue;
+            else if (token == "mtllib")
+            {
+                std::string mtlib;
+                iss >> mtlib;
+                data.MaterialLibs.push_back(mtlib);
+            }
+            else if (token == "o" or token == "g")
+            {
+                iss >> meshName;
+            }
+            else if (token == "usemtl")
+            {
+                group = &data.Groups.emplace_back();
+                group->Name = meshName;
+                iss >> group->Material;
+            }
+            else if (token == "v")
+            {
+                float x = 0, y = 0, z = 0;
+                iss >> x >> y >> z;
+                data.Positions.push_back(glm::vec3(x, y, z));
+            }
+            else if (token == "f")
+            {
+                if (!group)
+                {
+                    group = &data.Groups.emplace_back();
+                    group->Name = meshName;
+                }
+
+                std::string _str;
+                uint32_t cnt{};
+                int vFirst = -1;
+
+                while (iss >> _str)
+                {
+                    std::istringstream ref(_str);
+                    std::string vStr;
+                    std::getline(ref, vStr, '/');
+                    int v = atoi(vStr.c_str());
+
+                    if (vFirst == -1) vFirst = v - 1;
+
+                    if (cnt >= 3)
+                    {
+                        auto last = group->Indexes.back();
+                        group->Indexes.push_back(vFirst);
+                        group->Indexes.push_back(last);
+                    }
+
+                    group->Indexes.push_back(v - 1);
+                    cnt++;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    static bool ParseMapped(const std::string& path, ObjData& data, ThreadPool* pool = nullptr)
+    {
+        Ref<MappedFile> file = MappedFile::Create(path);
+        if (!file->IsValid())
+            return false;
+
+        ObjParser::Parse(file->begin(), file->end(), data, pool);
+        return true;
+    }
+
+    template<typename T>
+    static bool SameStream(const std::vector<T>& a, const std::vector<T>& b)
+    {
+        return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+    }
+
+    // The legacy parser only reads positions, so texcoords and normals are
+    // only compared between the mapped parses
+    static bool SameData(const ObjData& a, const ObjData& b, bool attributes = false)
+    {
+        if (!SameStream(a.Positions, b.Positions) || a.Groups.size() != b.Groups.size())
+            return false;
+
+        if (attributes && (!SameStream(a.TexCoords, b.TexCoords) || !SameStream(a.Normals, b.Normals)))
+            return false;
+
+        for (size_t i = 0; i < a.Groups.size(); ++i)
+        {
+            const ObjGroup& ga = a.Groups[i];
+            const ObjGroup& gb = b.Groups[i];
+            if (ga.Name != gb.Name || ga.Material != gb.Material || ga.Indexes != gb.Indexes)
+                return false;
+
+            if (attributes && (ga.TexCoordIndexes != gb.TexCoordIndexes || ga.NormalIndexes != gb.NormalIndexes))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Writes a tessellated height field split into a few materials,
+    // close to what a scanner export looks like.
+    static bool GenerateObj(const std::string& path, size_t megabytes)
+    {
+        FILE* out = fopen(path.c_str(), "wb");
+        if (!out)
+            return false;
+
+        const size_t target = megabytes * 1024 * 1024;
+        const uint32_t width = 1024;
+        size_t written = 0;
+        uint32_t row = 0;
+        char line[128];
+        std::string buffer;
+        buffer.reserve(1 << 20);
+
+        auto flush = [&]() {
+            fwrite(buffer.data(), 1, buffer.size(), out);
+            written += buffer.size();
+            buffer.clear();
+        };
+
+        buffer += "# generated by OpenGLModelViewerBench\n";
+        while (written + buffer.size() < target)
+        {
+            if (row % 64 == 0)
+            {
+                snprintf(line, sizeof(line), "o part%u\nusemtl material%u\n", row / 64, (row / 64) % 8);
+                buffer += line;
+            }
+
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float h = 0.25f * sinf(x * 0.05f) * cosf(row * 0.05f);
+                snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", x * 0.01f, h, row * 0.01f);
+                buffer += line;
+            }
+
+            if (row > 0)
+            {
+                uint32_t base = (row - 1) * width + 1;
+                for (uint32_t x = 0; x + 1 < width; ++x)
+                {
+                    uint32_t a = base + x, b = a + 1, c = a + width + 1, d = a + width;
+                    snprintf(line, sizeof(line), "f %u %u %u %u\n", a, b, c, d);
+                    buffer += line;
+                }
+            }
+
+            if (buffer.size() > (1 << 20) - 4096)
+                flush();
+            row++;
+        }
+        flush();
+
+        fclose(out);
+        return true;
+    }
+
+    int ObjParserBench(const std::vector<std::string>& args)
+    {
+        int repeat = 3;
+        bool legacy = true;
+        uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::string> files;
+
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            if (args[i] == "--repeat" && i + 1 < args.size())
+                repeat = std::max(1, atoi(args[++i].c_str()));
+            else if (args[i] == "--skip-legacy")
+                legacy = false;
+            else if (args[i] == "--threads" && i + 1 < args.size())
+                maxThreads = std::max(1, atoi(args[++i].c_str()));
+            else if (args[i] == "--generate" && i + 2 < args.size())
+            {
+                const std::string& path = args[i + 1];
+                size_t megabytes = (size_t)atoll(args[i + 2].c_str());
+                i += 2;
+                if (!GenerateObj(path, megabytes))
+                {
+                    LOG_ERROR("Could not write '%s'", path.c_str());
+                    return 1;
+                }
+                files.push_back(path);
+            }
+            else
+                files.push_back(args[i]);
+        }
+
+        if (files.empty())
+            files.push_back("assets/examples/wood/Wood_Texture.obj");
+
+        int status = 0;
+        for (const auto& path : files)
+        {
+            Ref<MappedFile> file = MappedFile::Create(path);
+            if (!file->IsValid())
+            {
+                LOG_ERROR("Could not open '%s'", path.c_str());
+                status = 1;
+                continue;
+            }
+            double megabytes = file->Size() / (1024.0 * 1024.0);
+
+            double bestLegacy = 0, bestMapped = 0;
+            ObjData legacyData, mappedData;
+            for (int i = 0; i < repeat; ++i)
+            {
+                if (legacy)
+                {
+                    legacyData = ObjData();
+                    BenchTimer timer;
+                    ParseLegacy(path, legacyData);
+                    double seconds = timer.ElapsedSeconds();
+                    bestLegacy = i == 0 ? seconds : std::min(bestLegacy, seconds);
+                }
+
+                mappedData = ObjData();
+                BenchTimer timer;
+                ParseMapped(path, mappedData);
+                double seconds = timer.ElapsedSeconds();
+                bestMapped = i == 0 ? seconds : std::min(bestMapped, seconds);
+            }
+
+            size_t triangles = 0;
+            for (const auto& group : mappedData.Groups)
+                triangles += group.Indexes.size() / 3;
+
+            LOG_INFO("%s: %.1f MB, %zu vertices, %zu triangles", path.c_str(), megabytes, mappedData.Positions.size(), triangles);
+            if (legacy)
+            {
+                LOG_INFO("  legacy  %9.2f ms  %8.1f MB/s", bestLegacy * 1000.0, megabytes / bestLegacy);
+            }
+            LOG_INFO("  mapped  %9.2f ms  %8.1f MB/s", bestMapped * 1000.0, megabytes / bestMapped);
+            if (legacy)
+            {
+                bool same = SameData(legacyData, mappedData);
+                LOG_INFO("  speedup %.2fx, output %s", bestLegacy / bestMapped, same ? "identical" : "DIFFERS");
+                if (!same)
+                    status = 1;
+            }
+
+            if (file->Size() <= ObjParser::ParallelThreshold)
+                continue;
+
+            // Thread scaling, the calling thread counts as one of them
+            for (uint32_t threads = 2; threads <= maxThreads; threads *= 2)
+            {
+                ThreadPool pool(threads - 1);
+                ObjData parallelData;
+                double best = 0;
+                for (int i = 0; i < repeat; ++i)
+                {
+                    parallelData = ObjData();
+                    BenchTimer timer;
+                    ParseMapped(path, parallelData, &pool);
+                    double seconds = timer.ElapsedSeconds();
+                    best = i == 0 ? seconds : std::min(best, seconds);
+                }
+
+                bool same = SameData(mappedData, parallelData, true);
+                LOG_INFO("  %2u threads %9.2f ms  %8.1f MB/s  %.2fx, output %s", threads, best * 1000.0, megabytes / best, bestMapped / best, same ? "identical" : "DIFFERS");
+                if (!same)
+                    status = 1;
+            }
+        }
+
+        return status;
+    }
+
+}
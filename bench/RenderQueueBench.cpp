@@ -0,0 +1,126 @@
+#include "Bench.h"
+
+#include "Core/Renderer/RenderQueue.h"
+
+#include <random>
+
+namespace GLMV {
+
+    // What a recorded draw was submitted with, to check the sorted order
+    struct BenchDraw
+    {
+        RenderPass Pass;
+        uint32_t VertexArray;
+        float Depth;
+    };
+
+    template<typename Fn>
+    static double Best(int repeat, const Fn& fn)
+    {
+        double best = 0;
+        for (int i = 0; i < repeat; ++i)
+        {
+            BenchTimer timer;
+            fn();
+            double seconds = timer.ElapsedSeconds();
+            best = i == 0 ? seconds : std::min(best, seconds);
+        }
+        return best;
+    }
+
+    // Opaque draws first with every vertex array in one run, then the
+    // transparent ones farthest first, up to the precision of the key
+    static bool CheckOrder(const std::vector<RenderPacket>& packets, const std::vector<BenchDraw>& draws)
+    {
+        std::vector<bool> seen(draws.size(), false);
+        bool transparent = false;
+        for (size_t i = 0; i < packets.size(); ++i)
+        {
+            const BenchDraw& draw = draws[packets[i].Command];
+            if (draw.Pass == RenderPass::Opaque)
+            {
+                if (transparent)
+                {
+                    LOG_ERROR("  opaque draw %u after a transparent one", packets[i].Command);
+                    return false;
+                }
+
+                bool continues = i > 0 && draws[packets[i - 1].Command].VertexArray == draw.VertexArray;
+                if (seen[draw.VertexArray] && !continues)
+                {
+                    LOG_ERROR("  vertex array %u bound twice", draw.VertexArray);
+                    return false;
+                }
+                seen[draw.VertexArray] = true;
+                continue;
+            }
+
+            const BenchDraw* previous = i > 0 ? &draws[packets[i - 1].Command] : nullptr;
+            if (transparent && previous && draw.Depth > previous->Depth * 1.001f)
+            {
+                LOG_ERROR("  transparent draw at %g after one at %g", draw.Depth, previous->Depth);
+                return false;
+            }
+            transparent = true;
+        }
+        return true;
+    }
+
+    int RenderQueueBench(const std::vector<std::string>& args)
+    {
+        int repeat = 5;
+        uint32_t count = 100000;
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            if (args[i] == "--repeat" && i + 1 < args.size())
+                repeat = std::max(1, atoi(args[++i].c_str()));
+            else if (args[i] == "--draws" && i + 1 < args.size())
+                count = (uint32_t)std::max(1, atoi(args[++i].c_str()));
+        }
+
+        // A scene like an assembly: a few hundred meshes in a few dozen
+        // vertex arrays, a quarter of the parts see through
+        std::mt19937 random(1);
+        std::vector<BenchDraw> draws(count);
+        std::vector<uint64_t> keys(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            BenchDraw& draw = draws[i];
+            draw.Pass = random() % 4 == 0 ? RenderPass::Transparent : RenderPass::Opaque;
+            draw.VertexArray = random() % 48;
+            draw.Depth = std::uniform_real_distribution<float>(0.1f, 1000.0f)(random);
+            keys[i] = RenderQueue::MakeKey(draw.Pass, 0, draw.VertexArray, random() % 400, random() % 24, draw.Depth);
+        }
+
+        LOG_INFO("%u draws", count);
+
+        RenderQueue queue;
+        std::vector<RenderPacket> sorted;
+        double radixTime = Best(repeat, [&]() {
+            queue.Clear();
+            for (uint32_t i = 0; i < count; ++i)
+                queue.Submit(keys[i], i);
+            sorted = queue.Sort();
+        });
+
+        std::vector<RenderPacket> reference;
+        double stableTime = Best(repeat, [&]() {
+            reference.clear();
+            for (uint32_t i = 0; i < count; ++i)
+                reference.push_back({ keys[i], i });
+            std::stable_sort(reference.begin(), reference.end(), [](const RenderPacket& a, const RenderPacket& b) { return a.Key < b.Key; });
+        });
+
+        bool same = true;
+        for (size_t i = 0; i < count; ++i)
+            same &= sorted[i].Command == reference[i].Command;
+
+        bool ordered = CheckOrder(sorted, draws);
+        LOG_INFO("  std::stable_sort %9.3f ms", stableTime * 1000.0);
+        LOG_INFO("  radix sort       %9.3f ms  %.2fx, order %s, passes %s", radixTime * 1000.0, stableTime / radixTime,
+            same ? "identical" : "DIFFERS", ordered ? "correct" : "WRONG");
+
+        return same && ordered ? 0 : 1;
+    }
+
+}
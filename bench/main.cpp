@@ -0,0 +1,51 @@
+#include "Bench.h"
+
+#include <cstring>
+
+namespace GLMV {
+
+    struct BenchEntry
+    {
+        const char* Name;
+        const char* Usage;
+        BenchFn Fn;
+    };
+
+    static const BenchEntry s_Benches[] = {
+        { "obj-parse", "[--repeat N] [--generate out.obj MB] files...", ObjParserBench },
+        { "obj-backends", "[--repeat N] files...", ObjBackendBench },
+        { "normals", "[--repeat N] [--grid N] [--threads N] [file.obj]", NormalBench },
+        { "render-queue", "[--repeat N] [--draws N]", RenderQueueBench },
+    };
+
+    static void PrintUsage()
+    {
+        LOG_INFO("usage: OpenGLModelViewerBench <bench> [args]");
+        for (const auto& bench : s_Benches)
+        {
+            LOG_INFO("  %s %s", bench.Name, bench.Usage);
+        }
+    }
+
+}
+
+int main(int argc, char** argv)
+{
+    using namespace GLMV;
+
+    if (argc < 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    std::vector<std::string> args(argv + 2, argv + argc);
+    for (const auto& bench : s_Benches)
+    {
+        if (strcmp(argv[1], bench.Name) == 0)
+            return bench.Fn(args);
+    }
+
+    PrintUsage();
+    return 1;
+}
@@ -62,6 +62,40 @@ project "OpenGLModelViewer"
             "YAML_CPP_STATIC_DEFINE"
         }
 
+project "OpenGLModelViewerBench"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    architecture "x86_64"
+
+    targetdir "bin/%{cfg.buildcfg}"
+    objdir "obj/%{cfg.buildcfg}"
+
+    includedirs {
+        "src",
+        "vendor/glm"
+    }
+
+    files {
+        "bench/**.cpp",
+        "bench/**.h",
+
+        -- Only the CPU side of the loaders, no window or GL context needed
+        "src/Core/ThreadPool.cpp",
+        "src/Core/Loaders/MappedFile.cpp",
+        "src/Core/Loaders/ObjParser.cpp",
+        "src/Core/Loaders/ObjBackend.cpp",
+        "src/Core/Loaders/TinyObjBackend.cpp",
+        "src/Core/Geometry/NormalGenerator.cpp",
+        "src/Core/Renderer/RenderQueue.cpp"
+    }
+
+    filter "system:linux"
+        links { "pthread" }
+
+    filter "system:windows"
+        defines { "_CRT_SECURE_NO_WARNINGS" }
+
 include "vendor/glad.lua"
 include "vendor/glfw.lua"
 include "vendor/glm.lua"
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Base.h"
+#include <glm/glm.hpp>
+
+#ifndef GLM_ENABLE_EXPERIMENTAL
+#define GLM_ENABLE_EXPERIMENTAL
+#endif
+#include <glm/gtx/component_wise.hpp>
+
+namespace GLMV {
+
+    // return the min/max points of pts
+    template< typename Vec >
+    std::pair< Vec, Vec > GetExtents(const Vec* pts, size_t stride, size_t count)
+    {
+        unsigned char* base = (unsigned char*)pts;
+        Vec pmin(*(Vec*)base);
+        Vec pmax(*(Vec*)base);
+        for (size_t i = 0; i < count; ++i, base += stride)
+        {
+            const Vec& pt = *(Vec*)base;
+            pmin = glm::min(pmin, pt);
+            pmax = glm::max(pmax, pt);
+        }
+
+        return std::make_pair(pmin, pmax);
+    }
+
+    // centers geometry around the origin
+    // and scales it to fit in a size^3 box
+    template< typename Vec >
+    void CenterAndScale(Vec* pts, size_t stride, size_t count, const typename Vec::value_type& size)
+    {
+        typedef typename Vec::value_type Scalar;
+
+        // get min/max extents
+        std::pair< Vec, Vec > exts = GetExtents(pts, stride, count);
+
+        // center and scale 
+        const Vec center = (exts.first * Scalar(0.5)) + (exts.second * Scalar(0.5f));
+
+        const Scalar factor = size / glm::compMax(exts.second - exts.first);
+        unsigned char* base = (unsigned char*)pts;
+        for (size_t i = 0; i < count; ++i, base += stride)
+        {
+            Vec& pt = *(Vec*)base;
+            pt = ((pt - center) * factor);
+        }
+    }
+
+}
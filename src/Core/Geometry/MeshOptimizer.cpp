@@ -0,0 +1,333 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+
+namespace GLMV {
+
+    static constexpr uint32_t s_Unused = ~0u;
+
+    // FIFO cache over vertex timestamps: a vertex is cached while fewer than
+    // CacheSize others came in after it. Starting the clock past CacheSize
+    // makes every vertex with a zero stamp a miss.
+    struct CacheSimulator
+    {
+        std::vector<uint32_t> Stamps;
+        uint32_t Time = MeshOptimizer::CacheSize + 1;
+
+        CacheSimulator(size_t vertexCount)
+            : Stamps(vertexCount, 0) {}
+
+        bool IsCached(uint32_t vertex) const { return Time - Stamps[vertex] <= MeshOptimizer::CacheSize; }
+
+        // Returns true on a miss
+        bool Fetch(uint32_t vertex)
+        {
+            if (IsCached(vertex))
+                return false;
+
+            Stamps[vertex] = Time++;
+            return true;
+        }
+
+        // Advancing the clock a whole cache evicts everything
+        void Flush() { Time += MeshOptimizer::CacheSize + 1; }
+    };
+
+    static bool IsValid(const uint32_t* indexes, size_t indexCount, size_t vertexCount)
+    {
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            if (indexes[i] >= vertexCount)
+                return false;
+        }
+        return true;
+    }
+
+    VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indexes, size_t indexCount, size_t vertexCount)
+    {
+        VertexCacheStats stats;
+        indexCount -= indexCount % 3;
+        if (indexCount == 0 || !IsValid(indexes, indexCount, vertexCount))
+            return stats;
+
+        CacheSimulator cache(vertexCount);
+        size_t misses = 0, referenced = 0;
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            if (cache.Stamps[indexes[i]] == 0)
+                referenced++;
+            if (cache.Fetch(indexes[i]))
+                misses++;
+        }
+
+        stats.ACMR = (float)misses / (indexCount / 3);
+        stats.ATVR = (float)misses / referenced;
+        return stats;
+    }
+
+    void MeshOptimizer::OptimizeVertexCache(uint32_t* indexes, size_t indexCount, size_t vertexCount, std::vector<uint32_t>* clusters)
+    {
+        indexCount -= indexCount % 3;
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || !IsValid(indexes, indexCount, vertexCount))
+            return;
+
+        // Triangles around every vertex (CSR), and how many of them are
+        // still to be emitted
+        std::vector<uint32_t> live(vertexCount, 0);
+        for (size_t i = 0; i < indexCount; ++i)
+            live[indexes[i]]++;
+
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; ++v)
+            offsets[v + 1] = offsets[v] + live[v];
+
+        std::vector<uint32_t> adjacency(indexCount);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; ++i)
+                adjacency[fill[indexes[i]]++] = (uint32_t)(i / 3);
+        }
+
+        CacheSimulator cache(vertexCount);
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+
+        size_t cursor = 0;
+        auto nextLive = [&]() -> uint32_t
+        {
+            while (cursor < vertexCount && live[cursor] == 0)
+                cursor++;
+            return cursor < vertexCount ? (uint32_t)cursor : s_Unused;
+        };
+
+        uint32_t fan = nextLive();
+        bool restart = true;
+        while (fan != s_Unused)
+        {
+            if (restart && clusters)
+                clusters->push_back((uint32_t)(result.size() / 3));
+            restart = false;
+
+            // Emit every remaining triangle around the fan vertex
+            candidates.clear();
+            for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; ++a)
+            {
+                uint32_t triangle = adjacency[a];
+                if (emitted[triangle])
+                    continue;
+                emitted[triangle] = 1;
+
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    uint32_t vertex = indexes[triangle * 3 + corner];
+                    result.push_back(vertex);
+                    deadEnd.push_back(vertex);
+                    candidates.push_back(vertex);
+                    live[vertex]--;
+                    cache.Fetch(vertex);
+                }
+            }
+
+            // Next fan: the candidate that entered the cache earliest and
+            // would still be in it after emitting all its triangles
+            uint32_t best = s_Unused;
+            int64_t bestPriority = -1;
+            for (uint32_t vertex : candidates)
+            {
+                if (live[vertex] == 0)
+                    continue;
+
+                int64_t priority = 0;
+                int64_t age = cache.Time - cache.Stamps[vertex];
+                if (age + 2 * (int64_t)live[vertex] <= CacheSize)
+                    priority = age;
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    best = vertex;
+                }
+            }
+
+            // Dead end: back to a recently used vertex, or anywhere else
+            while (best == s_Unused && !deadEnd.empty())
+            {
+                uint32_t vertex = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[vertex] > 0)
+                    best = vertex;
+            }
+            if (best == s_Unused)
+            {
+                best = nextLive();
+                restart = true;
+            }
+
+            fan = best;
+        }
+
+        std::copy(result.begin(), result.end(), indexes);
+    }
+
+    void MeshOptimizer::OptimizeOverdraw(uint32_t* indexes, size_t indexCount, const glm::vec3* positions, size_t vertexCount,
+        const std::vector<uint32_t>& clusters, const glm::vec3& center, float threshold)
+    {
+        indexCount -= indexCount % 3;
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || clusters.empty() || !IsValid(indexes, indexCount, vertexCount))
+            return;
+
+        // Split where the cluster so far, drawn from a cold cache, already
+        // costs no more than threshold times the whole mesh, so moving
+        // clusters around keeps most of the cache order
+        float limit = AnalyzeVertexCache(indexes, indexCount, vertexCount).ACMR * threshold;
+
+        std::vector<uint32_t> starts;
+        CacheSimulator cache(vertexCount);
+        for (size_t c = 0; c < clusters.size(); ++c)
+        {
+            size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+            size_t start = clusters[c];
+            size_t misses = 0;
+
+            starts.push_back((uint32_t)start);
+            cache.Flush();
+            for (size_t t = start; t < end; ++t)
+            {
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                    misses += cache.Fetch(indexes[t * 3 + corner]);
+
+                if (t + 1 < end && misses <= limit * (t + 1 - start))
+                {
+                    start = t + 1;
+                    misses = 0;
+                    starts.push_back((uint32_t)start);
+                    cache.Flush();
+                }
+            }
+        }
+
+        // Clusters far out along their own normal occlude the rest
+        struct Cluster
+        {
+            uint32_t Begin, End;
+            float Key;
+        };
+
+        std::vector<Cluster> sorted(starts.size());
+        for (size_t c = 0; c < starts.size(); ++c)
+        {
+            Cluster& cluster = sorted[c];
+            cluster.Begin = starts[c];
+            cluster.End = c + 1 < starts.size() ? starts[c + 1] : (uint32_t)triangleCount;
+
+            glm::vec3 centroid(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (uint32_t t = cluster.Begin; t < cluster.End; ++t)
+            {
+                const glm::vec3& a = positions[indexes[t * 3]];
+                const glm::vec3& b = positions[indexes[t * 3 + 1]];
+                const glm::vec3& c = positions[indexes[t * 3 + 2]];
+                glm::vec3 cross = glm::cross(b - a, c - a);
+                float weight = glm::length(cross);
+
+                centroid += (a + b + c) * (weight / 3.0f);
+                normal += cross;
+                area += weight;
+            }
+
+            float length = glm::length(normal);
+            cluster.Key = area > 0.0f && length > 0.0f ? glm::dot(centroid / area - center, normal / length) : 0.0f;
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.Key > b.Key; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+        for (const Cluster& cluster : sorted)
+            result.insert(result.end(), indexes + cluster.Begin * 3, indexes + cluster.End * 3);
+
+        std::copy(result.begin(), result.end(), indexes);
+    }
+
+    // Moves stream element v, made of stride values, to remap[v]
+    template<typename T>
+    static void Permute(std::vector<T>& stream, const std::vector<uint32_t>& remap, size_t stride)
+    {
+        if (stream.size() != remap.size() * stride)
+            return;
+
+        std::vector<T> permuted(stream.size());
+        for (size_t v = 0; v < remap.size(); ++v)
+        {
+            for (size_t j = 0; j < stride; ++j)
+                permuted[remap[v] * stride + j] = stream[v * stride + j];
+        }
+        stream.swap(permuted);
+    }
+
+    void MeshOptimizer::OptimizeVertexFetch(Mesh& mesh)
+    {
+        std::vector<uint32_t>& indexes = *mesh.Indexes;
+        size_t vertexCount = mesh.Vertices->size() / 2;
+        if (indexes.empty() || !IsValid(indexes.data(), indexes.size(), vertexCount))
+            return;
+
+        std::vector<uint32_t> remap(vertexCount, s_Unused);
+        uint32_t next = 0;
+        for (uint32_t index : indexes)
+        {
+            if (remap[index] == s_Unused)
+                remap[index] = next++;
+        }
+        for (auto& target : remap)
+        {
+            if (target == s_Unused)
+                target = next++;
+        }
+
+        for (auto& index : indexes)
+            index = remap[index];
+
+        // Vertices and Normals interleave position and normal
+        Permute(*mesh.Vertices, remap, 2);
+        Permute(*mesh.Normals, remap, 2);
+        Permute(*mesh.Vertex, remap, 1);
+        Permute(*mesh.TexCoords, remap, 1);
+        Permute(*mesh.Colors, remap, 1);
+    }
+
+    void MeshOptimizer::Optimize(Mesh& mesh, bool overdraw, float threshold, VertexCacheStats* before, VertexCacheStats* after)
+    {
+        std::vector<uint32_t>& indexes = *mesh.Indexes;
+        size_t vertexCount = mesh.Vertices->size() / 2;
+        size_t indexCount = indexes.size() - indexes.size() % 3;
+        if (indexCount == 0 || !IsValid(indexes.data(), indexes.size(), vertexCount))
+            return;
+
+        if (before)
+            *before = AnalyzeVertexCache(indexes.data(), indexCount, vertexCount);
+
+        overdraw = overdraw && mesh.Vertex->size() == vertexCount;
+
+        std::vector<uint32_t> clusters;
+        OptimizeVertexCache(indexes.data(), indexCount, vertexCount, overdraw ? &clusters : nullptr);
+        if (overdraw)
+        {
+            glm::vec3 center = (mesh.BoundingBox->first + mesh.BoundingBox->second) * 0.5f;
+            OptimizeOverdraw(indexes.data(), indexCount, mesh.Vertex->data(), vertexCount, clusters, center, threshold);
+        }
+        OptimizeVertexFetch(mesh);
+
+        if (after)
+            *after = AnalyzeVertexCache(indexes.data(), indexCount, vertexCount);
+
+        // Clusters index ranges that no longer exist
+        mesh.Meshlets->clear();
+        mesh.MarkDirty();
+    }
+
+}
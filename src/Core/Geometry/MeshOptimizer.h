@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Renderer/Mesh.h"
+#include <glm/glm.hpp>
+
+namespace GLMV {
+
+    // Post transform vertex cache efficiency of an index buffer, simulated
+    // with a FIFO cache of MeshOptimizer::CacheSize entries
+    struct VertexCacheStats
+    {
+        // Average cache misses per triangle, 0.5 at best and 3 at worst
+        float ACMR = 0.0f;
+        // Average transforms per referenced vertex, 1 at best
+        float ATVR = 0.0f;
+    };
+
+    // Reorders imported meshes for the GPU. Triangles are put in vertex
+    // cache order with Tipsify (Sander et al. 2007), optionally regrouped
+    // so outward facing parts are drawn first, and vertices are then
+    // renumbered in the order the triangles fetch them.
+    class MeshOptimizer
+    {
+        public:
+            static constexpr uint32_t CacheSize = 16;
+
+            static VertexCacheStats AnalyzeVertexCache(const uint32_t* indexes, size_t indexCount, size_t vertexCount);
+
+            // Reorders the triangles of indexes in place. clusters receives
+            // the first triangle of every run that starts with a cold cache.
+            static void OptimizeVertexCache(uint32_t* indexes, size_t indexCount, size_t vertexCount, std::vector<uint32_t>* clusters = nullptr);
+
+            // Splits the cache optimized triangles further where the cache
+            // has warmed up to within threshold of the ACMR of the whole mesh,
+            // then sorts the clusters so those facing away from center come
+            // first and hide the ones behind them
+            static void OptimizeOverdraw(uint32_t* indexes, size_t indexCount, const glm::vec3* positions, size_t vertexCount,
+                const std::vector<uint32_t>& clusters, const glm::vec3& center, float threshold);
+
+            // Renumbers vertices in first use order and moves every vertex
+            // stream of the mesh along. Unreferenced vertices keep their
+            // relative order at the end.
+            static void OptimizeVertexFetch(Mesh& mesh);
+
+            // All of the above on an imported mesh. Meshes without triangles
+            // are left alone.
+            static void Optimize(Mesh& mesh, bool overdraw, float threshold, VertexCacheStats* before = nullptr, VertexCacheStats* after = nullptr);
+    };
+
+}
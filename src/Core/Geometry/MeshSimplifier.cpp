@@ -0,0 +1,401 @@
+#include "MeshSimplifier.h"
+
+#include "Extents.h"
+#include "Core/ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace GLMV {
+
+    // Vertices per ParallelForBlocks block
+    static constexpr size_t s_BlockSize = 1 << 14;
+    // Give up on a level before it gets this small
+    static constexpr size_t s_MinTriangles = 256;
+    // A level has to drop at least this share of the triangles of the one before
+    static constexpr float s_MinReduction = 0.2f;
+    // Collapses of a pass may cost up to this times the one that would meet
+    // the goal, cheaper ones are left for the next pass to pick
+    static constexpr double s_PassSlack = 1.5;
+    // Weight of the planes that hold open borders in place
+    static constexpr double s_BorderWeight = 10.0;
+    static constexpr uint32_t s_MaxPasses = 100;
+    // Collapses may turn a triangle at most this far, as cosine of the angle
+    static constexpr float s_MinCosine = 0.25f;
+
+    // Sum of weighted squared plane distances, ax + by + cz + d = 0 per plane
+    struct Quadric
+    {
+        double A2 = 0, AB = 0, AC = 0, AD = 0, B2 = 0, BC = 0, BD = 0, C2 = 0, CD = 0, D2 = 0;
+        double Weight = 0;
+
+        static Quadric Plane(const glm::vec3& normal, const glm::vec3& point, double weight)
+        {
+            double a = normal.x, b = normal.y, c = normal.z;
+            double d = -(a * point.x + b * point.y + c * point.z);
+
+            Quadric q;
+            q.A2 = a * a * weight; q.AB = a * b * weight; q.AC = a * c * weight; q.AD = a * d * weight;
+            q.B2 = b * b * weight; q.BC = b * c * weight; q.BD = b * d * weight;
+            q.C2 = c * c * weight; q.CD = c * d * weight;
+            q.D2 = d * d * weight;
+            q.Weight = weight;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& q)
+        {
+            A2 += q.A2; AB += q.AB; AC += q.AC; AD += q.AD;
+            B2 += q.B2; BC += q.BC; BD += q.BD;
+            C2 += q.C2; CD += q.CD;
+            D2 += q.D2;
+            Weight += q.Weight;
+            return *this;
+        }
+
+        // Mean squared distance of p to the planes
+        double Error(const glm::vec3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double error = A2 * x * x + 2 * AB * x * y + 2 * AC * x * z + 2 * AD * x
+                + B2 * y * y + 2 * BC * y * z + 2 * BD * y
+                + C2 * z * z + 2 * CD * z
+                + D2;
+            return Weight > 0 ? std::max(error, 0.0) / Weight : 0.0;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t From, To;
+        double Cost;
+    };
+
+    // Triangles around every vertex (CSR)
+    struct Adjacency
+    {
+        std::vector<uint32_t> Offsets;
+        std::vector<uint32_t> Triangles;
+
+        void Build(const std::vector<uint32_t>& indexes, size_t vertexCount)
+        {
+            Offsets.assign(vertexCount + 1, 0);
+            for (uint32_t index : indexes)
+                Offsets[index + 1]++;
+            for (size_t v = 0; v < vertexCount; ++v)
+                Offsets[v + 1] += Offsets[v];
+
+            Triangles.resize(indexes.size());
+            std::vector<uint32_t> fill(Offsets.begin(), Offsets.end() - 1);
+            for (size_t i = 0; i < indexes.size(); ++i)
+                Triangles[fill[indexes[i]]++] = (uint32_t)(i / 3);
+        }
+    };
+
+    static uint32_t Corner(const uint32_t* triangle, uint32_t vertex)
+    {
+        return triangle[0] == vertex ? 0 : triangle[1] == vertex ? 1 : 2;
+    }
+
+    // Area weighted planes of the triangles around v, plus a plane standing
+    // on every open border edge of v so borders do not shrink
+    static Quadric VertexQuadric(uint32_t v, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indexes, const Adjacency& adjacency)
+    {
+        Quadric quadric;
+        uint32_t begin = adjacency.Offsets[v], end = adjacency.Offsets[v + 1];
+        for (uint32_t a = begin; a < end; ++a)
+        {
+            const uint32_t* triangle = &indexes[adjacency.Triangles[a] * 3];
+            const glm::vec3& p0 = positions[triangle[0]];
+            glm::vec3 normal = glm::cross(positions[triangle[1]] - p0, positions[triangle[2]] - p0);
+            float length = glm::length(normal);
+            if (length <= 0.0f)
+                continue;
+
+            normal /= length;
+            quadric += Quadric::Plane(normal, p0, length * 0.5);
+
+            uint32_t corner = Corner(triangle, v);
+            uint32_t next = triangle[(corner + 1) % 3];
+            uint32_t prev = triangle[(corner + 2) % 3];
+
+            // An edge is open when no other triangle walks it the other way
+            bool nextOpen = true, prevOpen = true;
+            for (uint32_t b = begin; b < end; ++b)
+            {
+                const uint32_t* other = &indexes[adjacency.Triangles[b] * 3];
+                uint32_t otherCorner = Corner(other, v);
+                nextOpen = nextOpen && other[(otherCorner + 2) % 3] != next;
+                prevOpen = prevOpen && other[(otherCorner + 1) % 3] != prev;
+            }
+
+            for (uint32_t neighbor : { nextOpen ? next : v, prevOpen ? prev : v })
+            {
+                if (neighbor == v)
+                    continue;
+
+                glm::vec3 edge = positions[neighbor] - positions[v];
+                glm::vec3 side = glm::cross(edge, normal);
+                float sideLength = glm::length(side);
+                if (sideLength > 0.0f)
+                    quadric += Quadric::Plane(side / sideLength, positions[v], s_BorderWeight * glm::dot(edge, edge));
+            }
+        }
+
+        return quadric;
+    }
+
+    // Every edge once, from its lower vertex, in the direction that costs less
+    static void ScoreEdges(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indexes, const Adjacency& adjacency,
+        const std::vector<Quadric>& quadrics, std::vector<Collapse>& collapses, ThreadPool* pool)
+    {
+        size_t vertexCount = quadrics.size();
+        std::vector<std::vector<Collapse>> blocks((vertexCount + s_BlockSize - 1) / s_BlockSize);
+        ParallelForBlocks(pool, vertexCount, s_BlockSize, [&](size_t begin, size_t end)
+        {
+            std::vector<Collapse>& block = blocks[begin / s_BlockSize];
+            std::vector<uint32_t> neighbors;
+            for (size_t i = begin; i < end; ++i)
+            {
+                uint32_t v = (uint32_t)i;
+                neighbors.clear();
+                for (uint32_t a = adjacency.Offsets[v]; a < adjacency.Offsets[v + 1]; ++a)
+                {
+                    const uint32_t* triangle = &indexes[adjacency.Triangles[a] * 3];
+                    uint32_t corner = Corner(triangle, v);
+                    for (uint32_t w : { triangle[(corner + 1) % 3], triangle[(corner + 2) % 3] })
+                    {
+                        if (w > v && std::find(neighbors.begin(), neighbors.end(), w) == neighbors.end())
+                            neighbors.push_back(w);
+                    }
+                }
+
+                for (uint32_t w : neighbors)
+                {
+                    Quadric quadric = quadrics[v];
+                    quadric += quadrics[w];
+                    double toW = quadric.Error(positions[w]);
+                    double toV = quadric.Error(positions[v]);
+                    block.push_back(toW <= toV ? Collapse{ v, w, toW } : Collapse{ w, v, toV });
+                }
+            }
+        });
+
+        collapses.clear();
+        for (const auto& block : blocks)
+            collapses.insert(collapses.end(), block.begin(), block.end());
+    }
+
+    // Moving from onto to must not fold any remaining triangle over or turn
+    // it far. Counts the triangles the collapse removes.
+    static bool CanCollapse(const Collapse& collapse, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indexes,
+        const Adjacency& adjacency, const std::vector<uint32_t>& remap, size_t& removed)
+    {
+        removed = 0;
+        for (uint32_t a = adjacency.Offsets[collapse.From]; a < adjacency.Offsets[collapse.From + 1]; ++a)
+        {
+            const uint32_t* triangle = &indexes[adjacency.Triangles[a] * 3];
+            uint32_t corners[3] = { remap[triangle[0]], remap[triangle[1]], remap[triangle[2]] };
+            if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+                continue;
+
+            if (corners[0] == collapse.To || corners[1] == collapse.To || corners[2] == collapse.To)
+            {
+                removed++;
+                continue;
+            }
+
+            glm::vec3 before = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+            for (auto& corner : corners)
+            {
+                if (corner == collapse.From)
+                    corner = collapse.To;
+            }
+            glm::vec3 after = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+            if (glm::dot(before, after) <= s_MinCosine * glm::length(before) * glm::length(after))
+                return false;
+        }
+
+        return true;
+    }
+
+    size_t MeshSimplifier::Simplify(const glm::vec3* source, size_t vertexCount, const uint32_t* indexes, size_t indexCount,
+        size_t targetIndexCount, float maxError, std::vector<uint32_t>& result, float* error, ThreadPool* pool)
+    {
+        indexCount -= indexCount % 3;
+        result.assign(indexes, indexes + indexCount);
+        if (error)
+            *error = 0.0f;
+        if (vertexCount == 0 || indexCount <= targetIndexCount)
+            return result.size();
+
+        for (uint32_t index : result)
+        {
+            if (index >= vertexCount)
+                return result.size();
+        }
+
+        // Errors are measured in a unit box
+        auto extents = GetExtents(source, sizeof(glm::vec3), vertexCount);
+        float extent = glm::compMax(extents.second - extents.first);
+        float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+        std::vector<glm::vec3> positions(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+            positions[v] = (source[v] - extents.first) * scale;
+
+        Adjacency adjacency;
+        adjacency.Build(result, vertexCount);
+
+        std::vector<Quadric> quadrics(vertexCount);
+        ParallelForBlocks(pool, vertexCount, s_BlockSize, [&](size_t begin, size_t end)
+        {
+            for (size_t v = begin; v < end; ++v)
+                quadrics[v] = VertexQuadric((uint32_t)v, positions, result, adjacency);
+        });
+
+        std::vector<uint32_t> remap(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+            remap[v] = (uint32_t)v;
+
+        double limit = (double)maxError * maxError;
+        double taken = 0.0;
+        size_t targetTriangles = targetIndexCount / 3;
+        std::vector<Collapse> collapses;
+        std::vector<uint8_t> locked(vertexCount);
+
+        for (uint32_t pass = 0; pass < s_MaxPasses && result.size() / 3 > targetTriangles; ++pass)
+        {
+            if (pass > 0)
+                adjacency.Build(result, vertexCount);
+
+            ScoreEdges(positions, result, adjacency, quadrics, collapses, pool);
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+            {
+                return a.Cost < b.Cost || (a.Cost == b.Cost && (a.From < b.From || (a.From == b.From && a.To < b.To)));
+            });
+
+            // Every collapse takes about two triangles
+            size_t triangles = result.size() / 3;
+            size_t goal = (triangles - targetTriangles + 1) / 2;
+            double passLimit = goal < collapses.size() ? collapses[goal].Cost * s_PassSlack : DBL_MAX;
+
+            std::fill(locked.begin(), locked.end(), 0);
+            size_t collapsed = 0;
+            for (const Collapse& collapse : collapses)
+            {
+                if (triangles <= targetTriangles || collapse.Cost > limit || collapse.Cost > passLimit)
+                    break;
+                if (locked[collapse.From] || locked[collapse.To])
+                    continue;
+
+                size_t removed = 0;
+                if (!CanCollapse(collapse, positions, result, adjacency, remap, removed))
+                    continue;
+
+                remap[collapse.From] = collapse.To;
+                quadrics[collapse.To] += quadrics[collapse.From];
+                locked[collapse.From] = locked[collapse.To] = 1;
+                triangles -= std::min(removed, triangles);
+                taken = std::max(taken, collapse.Cost);
+                collapsed++;
+            }
+
+            if (collapsed == 0)
+                break;
+
+            size_t count = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                uint32_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+                if (a == b || b == c || a == c)
+                    continue;
+
+                result[count++] = a;
+                result[count++] = b;
+                result[count++] = c;
+            }
+            result.resize(count);
+        }
+
+        if (error)
+            *error = (float)std::sqrt(taken) * extent;
+        return result.size();
+    }
+
+    // New mesh with the given triangles of mesh and the vertices they use,
+    // numbered in first use order
+    static Ref<Mesh> Extract(const Mesh& mesh, const std::vector<uint32_t>& indexes)
+    {
+        size_t vertexCount = mesh.Vertex->size();
+        std::vector<uint32_t> remap(vertexCount, ~0u);
+        std::vector<uint32_t> used;
+        for (uint32_t index : indexes)
+        {
+            if (remap[index] == ~0u)
+            {
+                remap[index] = (uint32_t)used.size();
+                used.push_back(index);
+            }
+        }
+
+        Ref<Mesh> lod = Mesh::Create();
+        lod->Indexes->resize(indexes.size());
+        for (size_t i = 0; i < indexes.size(); ++i)
+            (*lod->Indexes)[i] = remap[indexes[i]];
+
+        lod->Vertices->resize(used.size() * 2);
+        lod->Vertex->resize(used.size());
+        for (size_t v = 0; v < used.size(); ++v)
+        {
+            (*lod->Vertices)[v * 2] = (*mesh.Vertices)[used[v] * 2];
+            (*lod->Vertices)[v * 2 + 1] = (*mesh.Vertices)[used[v] * 2 + 1];
+            (*lod->Vertex)[v] = (*mesh.Vertex)[used[v]];
+        }
+        *lod->Normals = *lod->Vertices;
+
+        if (mesh.TexCoords->size() == vertexCount)
+        {
+            lod->TexCoords->resize(used.size());
+            for (size_t v = 0; v < used.size(); ++v)
+                (*lod->TexCoords)[v] = (*mesh.TexCoords)[used[v]];
+        }
+        if (mesh.Colors->size() == vertexCount)
+        {
+            lod->Colors->resize(used.size());
+            for (size_t v = 0; v < used.size(); ++v)
+                (*lod->Colors)[v] = (*mesh.Colors)[used[v]];
+        }
+
+        // Same bounds as the full mesh, so LOD selection does not jump
+        *lod->BoundingBox = *mesh.BoundingBox;
+        return lod;
+    }
+
+    std::vector<Ref<Mesh>> MeshSimplifier::GenerateLods(const Mesh& mesh, uint32_t levels, float ratio, ThreadPool* pool)
+    {
+        std::vector<Ref<Mesh>> lods;
+
+        size_t vertexCount = mesh.Vertex->size();
+        if (vertexCount == 0 || mesh.Vertices->size() != vertexCount * 2)
+            return lods;
+
+        std::vector<uint32_t> current(mesh.Indexes->begin(), mesh.Indexes->end() - mesh.Indexes->size() % 3);
+        std::vector<uint32_t> next;
+        for (uint32_t level = 0; level < levels; ++level)
+        {
+            size_t target = (size_t)(current.size() / 3 * ratio) * 3;
+            if (target / 3 < s_MinTriangles)
+                break;
+
+            Simplify(mesh.Vertex->data(), vertexCount, current.data(), current.size(), target, FLT_MAX, next, nullptr, pool);
+            if (next.size() > current.size() * (1.0f - s_MinReduction))
+                break;
+
+            lods.push_back(Extract(mesh, next));
+            current.swap(next);
+        }
+
+        return lods;
+    }
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Renderer/Mesh.h"
+#include <glm/glm.hpp>
+
+namespace GLMV {
+
+    class ThreadPool;
+
+    // Quadric error edge collapse (Garland and Heckbert 1997). Collapses
+    // move a vertex onto one of its neighbors, so a simplified mesh uses a
+    // subset of the original vertices and keeps all their attributes.
+    // Collapses are applied in passes: each pass scores every edge on the
+    // pool and then collapses the cheapest ones that do not touch each other.
+    class MeshSimplifier
+    {
+        public:
+            // Simplifies the triangle list until at most targetIndexCount
+            // indexes are left, or no collapse stays under maxError, relative
+            // to the extent of the mesh. Returns the size of result, which
+            // indexes the same vertices. error receives the largest error taken.
+            static size_t Simplify(const glm::vec3* positions, size_t vertexCount, const uint32_t* indexes, size_t indexCount,
+                size_t targetIndexCount, float maxError, std::vector<uint32_t>& result, float* error = nullptr, ThreadPool* pool = nullptr);
+
+            // Coarser copies of mesh, each with about ratio times the
+            // triangles of the one before and only the vertices it uses.
+            // Stops early once a level gets too small to be worth it.
+            static std::vector<Ref<Mesh>> GenerateLods(const Mesh& mesh, uint32_t levels, float ratio, ThreadPool* pool = nullptr);
+    };
+
+}
@@ -0,0 +1,98 @@
+#include "MeshSplitter.h"
+
+#include "Extents.h"
+
+namespace GLMV {
+
+    // Copies the vertices in used, in that order, and the indexes already
+    // remapped to them into a new mesh
+    static Ref<Mesh> Extract(const Mesh& mesh, const std::vector<uint32_t>& used, std::vector<uint32_t>& indexes)
+    {
+        size_t vertexCount = mesh.Vertex->size();
+
+        Ref<Mesh> part = Mesh::Create();
+        part->Indexes->swap(indexes);
+
+        part->Vertices->resize(used.size() * 2);
+        part->Vertex->resize(used.size());
+        for (size_t v = 0; v < used.size(); ++v)
+        {
+            (*part->Vertices)[v * 2] = (*mesh.Vertices)[used[v] * 2];
+            (*part->Vertices)[v * 2 + 1] = (*mesh.Vertices)[used[v] * 2 + 1];
+            (*part->Vertex)[v] = (*mesh.Vertex)[used[v]];
+        }
+        *part->Normals = *part->Vertices;
+
+        if (mesh.TexCoords->size() == vertexCount)
+        {
+            part->TexCoords->resize(used.size());
+            for (size_t v = 0; v < used.size(); ++v)
+                (*part->TexCoords)[v] = (*mesh.TexCoords)[used[v]];
+        }
+        if (mesh.Colors->size() == vertexCount)
+        {
+            part->Colors->resize(used.size());
+            for (size_t v = 0; v < used.size(); ++v)
+                (*part->Colors)[v] = (*mesh.Colors)[used[v]];
+        }
+
+        *part->BoundingBox = GetExtents(part->Vertex->data(), sizeof(glm::vec3), part->Vertex->size());
+        part->Format = mesh.Format;
+        return part;
+    }
+
+    std::vector<Ref<Mesh>> MeshSplitter::Split(const Mesh& mesh, uint32_t maxVertices)
+    {
+        std::vector<Ref<Mesh>> parts;
+
+        const std::vector<uint32_t>& indexes = *mesh.Indexes;
+        size_t vertexCount = mesh.Vertex->size();
+        size_t indexCount = indexes.size() - indexes.size() % 3;
+        if (vertexCount <= maxVertices || maxVertices < 3 || mesh.Vertices->size() != vertexCount * 2)
+            return parts;
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            if (indexes[i] >= vertexCount)
+                return parts;
+        }
+
+        // Vertex -> its index in the current part, valid while owner says so
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<uint32_t> owner(vertexCount, ~0u);
+        uint32_t current = 0;
+
+        std::vector<uint32_t> used;
+        std::vector<uint32_t> partIndexes;
+        for (size_t t = 0; t < indexCount; t += 3)
+        {
+            uint32_t added = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner)
+                added += owner[indexes[t + corner]] != current;
+
+            if (used.size() + added > maxVertices)
+            {
+                parts.push_back(Extract(mesh, used, partIndexes));
+                used.clear();
+                partIndexes.clear();
+                current++;
+            }
+
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                uint32_t vertex = indexes[t + corner];
+                if (owner[vertex] != current)
+                {
+                    owner[vertex] = current;
+                    remap[vertex] = (uint32_t)used.size();
+                    used.push_back(vertex);
+                }
+                partIndexes.push_back(remap[vertex]);
+            }
+        }
+        if (!partIndexes.empty())
+            parts.push_back(Extract(mesh, used, partIndexes));
+
+        return parts;
+    }
+
+}
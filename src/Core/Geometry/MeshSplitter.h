@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Renderer/Mesh.h"
+
+namespace GLMV {
+
+    // Cuts meshes too large for 16 bit indexes into parts that fit
+    class MeshSplitter
+    {
+        public:
+            static constexpr uint32_t MaxVertices16 = 0xffff;
+
+            // Parts of at most maxVertices vertices each, every one with its
+            // own compacted streams and bounding box. Triangles keep their
+            // order, so parts follow the spatial coherence of the index
+            // buffer. Empty when the mesh already fits.
+            static std::vector<Ref<Mesh>> Split(const Mesh& mesh, uint32_t maxVertices = MaxVertices16);
+    };
+
+}
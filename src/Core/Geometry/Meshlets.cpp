@@ -0,0 +1,234 @@
+#include "Meshlets.h"
+
+#include "Extents.h"
+#include "Core/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace GLMV {
+
+    // Triangles or clusters per ParallelForBlocks block
+    static constexpr size_t s_BlockSize = 1 << 14;
+    // A cluster of at least s_MinTriangles ends at a triangle whose normal
+    // is further than this cosine from the cluster's average
+    static constexpr uint32_t s_MinTriangles = 32;
+    static constexpr float s_MinNormalCosine = 0.5f;
+
+    // Spreads the low 10 bits of v three bits apart
+    static uint32_t Part1By2(uint32_t v)
+    {
+        v &= 0x3ff;
+        v = (v | (v << 16)) & 0x030000ff;
+        v = (v | (v << 8)) & 0x0300f00f;
+        v = (v | (v << 4)) & 0x030c30c3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    static glm::vec3 Normalize(const glm::vec3& v)
+    {
+        float length = glm::length(v);
+        return length > 0.0f ? v / length : glm::vec3(0.0f);
+    }
+
+    // Bounding sphere of the box around the cluster's vertices, and the
+    // narrowest cone around the average normal holding every triangle normal
+    static void ComputeBounds(Meshlet& meshlet, const uint32_t* indexes, const glm::vec3* positions)
+    {
+        glm::vec3 min = positions[indexes[0]], max = min;
+        glm::vec3 sum(0.0f);
+        for (uint32_t i = 0; i < meshlet.IndexCount; i += 3)
+        {
+            const glm::vec3& a = positions[indexes[i]];
+            const glm::vec3& b = positions[indexes[i + 1]];
+            const glm::vec3& c = positions[indexes[i + 2]];
+            min = glm::min(min, glm::min(a, glm::min(b, c)));
+            max = glm::max(max, glm::max(a, glm::max(b, c)));
+            sum += Normalize(glm::cross(b - a, c - a));
+        }
+
+        meshlet.Center = (min + max) * 0.5f;
+        meshlet.Radius = 0.0f;
+        for (uint32_t i = 0; i < meshlet.IndexCount; ++i)
+            meshlet.Radius = std::max(meshlet.Radius, glm::length(positions[indexes[i]] - meshlet.Center));
+
+        meshlet.ConeAxis = Normalize(sum);
+        float minCosine = 1.0f;
+        for (uint32_t i = 0; i < meshlet.IndexCount; i += 3)
+        {
+            const glm::vec3& a = positions[indexes[i]];
+            glm::vec3 normal = glm::cross(positions[indexes[i + 1]] - a, positions[indexes[i + 2]] - a);
+            // Degenerate triangles draw nothing and do not widen the cone
+            if (glm::length(normal) > 0.0f)
+                minCosine = std::min(minCosine, glm::dot(Normalize(normal), meshlet.ConeAxis));
+        }
+
+        // Wider than a hemisphere, some triangle always faces the camera
+        meshlet.ConeCutoff = minCosine > 0.0f && glm::length(sum) > 0.0f ? std::sqrt(1.0f - minCosine * minCosine) : 1.0f;
+    }
+
+    void Meshlets::Build(Mesh& mesh, ThreadPool* pool)
+    {
+        std::vector<uint32_t>& indexes = *mesh.Indexes;
+        std::vector<Meshlet>& meshlets = *mesh.Meshlets;
+        const glm::vec3* positions = mesh.Vertex->data();
+        size_t vertexCount = mesh.Vertex->size();
+        size_t triangleCount = indexes.size() / 3;
+
+        meshlets.clear();
+        if (triangleCount == 0)
+            return;
+        for (size_t i = 0; i < triangleCount * 3; ++i)
+        {
+            if (indexes[i] >= vertexCount)
+                return;
+        }
+
+        // Triangles along a Morton curve through the box of the mesh
+        auto extents = GetExtents(positions, sizeof(glm::vec3), vertexCount);
+        glm::vec3 extent = extents.second - extents.first;
+        glm::vec3 scale = glm::vec3(
+            extent.x > 0.0f ? 1023.0f / extent.x : 0.0f,
+            extent.y > 0.0f ? 1023.0f / extent.y : 0.0f,
+            extent.z > 0.0f ? 1023.0f / extent.z : 0.0f);
+
+        std::vector<uint64_t> keys(triangleCount);
+        ParallelForBlocks(pool, triangleCount, s_BlockSize, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; ++t)
+            {
+                glm::vec3 centroid = (positions[indexes[t * 3]] + positions[indexes[t * 3 + 1]] + positions[indexes[t * 3 + 2]]) / 3.0f;
+                glm::vec3 cell = glm::clamp((centroid - extents.first) * scale, glm::vec3(0.0f), glm::vec3(1023.0f));
+                uint32_t code = Part1By2((uint32_t)cell.x) | (Part1By2((uint32_t)cell.y) << 1) | (Part1By2((uint32_t)cell.z) << 2);
+                // Ties keep the input order, so the cache order survives
+                keys[t] = ((uint64_t)code << 32) | t;
+            }
+        });
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<uint32_t> sorted;
+        sorted.reserve(triangleCount * 3);
+
+        // Vertex -> last cluster using it, to count the vertices of a cluster
+        std::vector<uint32_t> owner(vertexCount, ~0u);
+        uint32_t vertices = 0, triangles = 0;
+        glm::vec3 normals(0.0f);
+        uint32_t cluster = 0;
+
+        auto close = [&]()
+        {
+            Meshlet meshlet;
+            meshlet.IndexOffset = (uint32_t)(sorted.size() - triangles * 3);
+            meshlet.IndexCount = triangles * 3;
+            meshlets.push_back(meshlet);
+
+            cluster++;
+            vertices = triangles = 0;
+            normals = glm::vec3(0.0f);
+        };
+
+        for (uint64_t key : keys)
+        {
+            const uint32_t* triangle = &indexes[(key & 0xffffffffu) * 3];
+            glm::vec3 normal = Normalize(glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]));
+
+            uint32_t added = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner)
+                added += owner[triangle[corner]] != cluster;
+
+            bool full = vertices + added > MaxVertices || triangles == MaxTriangles;
+            bool turned = triangles >= s_MinTriangles && glm::dot(normal, Normalize(normals)) < s_MinNormalCosine;
+            if (triangles > 0 && (full || turned))
+                close();
+
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                if (owner[triangle[corner]] != cluster)
+                {
+                    owner[triangle[corner]] = cluster;
+                    vertices++;
+                }
+                sorted.push_back(triangle[corner]);
+            }
+            triangles++;
+            normals += normal;
+        }
+        if (triangles > 0)
+            close();
+
+        // Incomplete trailing indexes stay at the end
+        sorted.insert(sorted.end(), indexes.begin() + triangleCount * 3, indexes.end());
+        indexes.swap(sorted);
+
+        ParallelForBlocks(pool, meshlets.size(), s_BlockSize, [&](size_t begin, size_t end)
+        {
+            for (size_t m = begin; m < end; ++m)
+                ComputeBounds(meshlets[m], indexes.data() + meshlets[m].IndexOffset, positions);
+        });
+
+        mesh.MarkDirty();
+    }
+
+    size_t Meshlets::Cull(const Mesh& mesh, const glm::mat4& modelViewProjection, const glm::vec3& camera, bool cullBackfaces,
+        std::vector<IndexRange>& ranges, ThreadPool* pool)
+    {
+        const std::vector<Meshlet>& meshlets = *mesh.Meshlets;
+        ranges.clear();
+
+        // Frustum planes in mesh space (Gribb and Hartmann), pointing inwards
+        const glm::mat4& m = modelViewProjection;
+        glm::vec4 rows[4];
+        for (int r = 0; r < 4; ++r)
+            rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+
+        glm::vec4 planes[6] = {
+            rows[3] + rows[0], rows[3] - rows[0],
+            rows[3] + rows[1], rows[3] - rows[1],
+            rows[3] + rows[2], rows[3] - rows[2],
+        };
+        for (auto& plane : planes)
+        {
+            float length = glm::length(glm::vec3(plane));
+            if (length > 0.0f)
+                plane = plane / length;
+        }
+
+        std::vector<uint8_t> visible(meshlets.size());
+        ParallelForBlocks(pool, meshlets.size(), s_BlockSize, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Meshlet& meshlet = meshlets[i];
+                bool inside = true;
+                for (const auto& plane : planes)
+                    inside = inside && glm::dot(glm::vec3(plane), meshlet.Center) + plane.w >= -meshlet.Radius;
+
+                if (inside && cullBackfaces)
+                {
+                    glm::vec3 view = meshlet.Center - camera;
+                    inside = glm::dot(view, meshlet.ConeAxis) < meshlet.ConeCutoff * glm::length(view) + meshlet.Radius;
+                }
+
+                visible[i] = inside;
+            }
+        });
+
+        size_t count = 0;
+        for (size_t i = 0; i < meshlets.size(); ++i)
+        {
+            if (!visible[i])
+                continue;
+
+            count++;
+            const Meshlet& meshlet = meshlets[i];
+            if (!ranges.empty() && ranges.back().Offset + ranges.back().Count == meshlet.IndexOffset)
+                ranges.back().Count += meshlet.IndexCount;
+            else
+                ranges.push_back({ meshlet.IndexOffset, meshlet.IndexCount });
+        }
+
+        return count;
+    }
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Renderer/Mesh.h"
+#include <glm/glm.hpp>
+
+namespace GLMV {
+
+    class ThreadPool;
+
+    // Splits meshes into small clusters that are culled on their own, so a
+    // close up of a huge scan only draws what is in view
+    class Meshlets
+    {
+        public:
+            static constexpr uint32_t MaxVertices = 64;
+            static constexpr uint32_t MaxTriangles = 124;
+
+            // Sorts the triangles of the mesh along a Morton curve and cuts
+            // them into clusters at the vertex and triangle limits, or where
+            // the surface turns too far for a tight normal cone. Reorders
+            // Indexes so every cluster is one range, and fills Mesh::Meshlets.
+            static void Build(Mesh& mesh, ThreadPool* pool = nullptr);
+
+            // Index ranges of the clusters inside the frustum of
+            // modelViewProjection, adjacent ones merged. With cullBackfaces,
+            // clusters whose triangles all face away from camera, given in
+            // mesh space, are dropped as well. Returns the visible clusters.
+            static size_t Cull(const Mesh& mesh, const glm::mat4& modelViewProjection, const glm::vec3& camera, bool cullBackfaces,
+                std::vector<IndexRange>& ranges, ThreadPool* pool = nullptr);
+    };
+
+}
@@ -0,0 +1,138 @@
+#include "NormalGenerator.h"
+
+#include "Core/ThreadPool.h"
+
+#include <cmath>
+
+namespace GLMV {
+
+    // Work items per ParallelFor index, large enough to hide the scheduling
+    static constexpr size_t s_BlockSize = 1 << 16;
+
+    static float Angle(const glm::vec3& a, const glm::vec3& b)
+    {
+        float length = glm::length(a) * glm::length(b);
+        if (length <= 0.0f)
+            return 0.0f;
+
+        return std::acos(glm::clamp(glm::dot(a, b) / length, -1.0f, 1.0f));
+    }
+
+    // Weighted face normal as seen from each corner of one triangle. The
+    // cross product is twice the triangle area, so it is already the area
+    // weighted one.
+    static void FaceNormals(const glm::vec3* positions, const uint32_t* idx, NormalWeighting weighting, glm::vec3* corner)
+    {
+        const glm::vec3& a = positions[idx[0]];
+        const glm::vec3& b = positions[idx[1]];
+        const glm::vec3& c = positions[idx[2]];
+        glm::vec3 normal = glm::cross(b - a, c - a);
+
+        if (weighting == NormalWeighting::Area)
+        {
+            corner[0] = corner[1] = corner[2] = normal;
+            return;
+        }
+
+        float length = glm::length(normal);
+        if (length <= 0.0f)
+        {
+            corner[0] = corner[1] = corner[2] = glm::vec3(0.0f);
+            return;
+        }
+
+        normal /= length;
+        corner[0] = normal * Angle(b - a, c - a);
+        corner[1] = normal * Angle(c - b, a - b);
+        corner[2] = normal * Angle(a - c, b - c);
+    }
+
+    static glm::vec3 Normalize(const glm::vec3& sum)
+    {
+        float length = glm::length(sum);
+        return length > 0.0f ? sum / length : glm::vec3(0.0f);
+    }
+
+    void NormalGenerator::Generate(const glm::vec3* positions, size_t vertexCount, const uint32_t* indexes, size_t indexCount,
+        NormalWeighting weighting, std::vector<glm::vec3>& normals, ThreadPool* pool)
+    {
+        normals.assign(vertexCount, glm::vec3(0.0f));
+        indexCount -= indexCount % 3;
+        if (indexCount == 0)
+            return;
+
+        // A single thread scatters straight into the normals. Every vertex
+        // still adds its corners in index order, exactly like the gather
+        // below, so both give bit identical results.
+        if (!pool || pool->GetThreadCount() == 0 || indexCount / 3 <= s_BlockSize)
+        {
+            glm::vec3 corner[3];
+            for (size_t i = 0; i < indexCount; i += 3)
+            {
+                FaceNormals(positions, indexes + i, weighting, corner);
+                normals[indexes[i]] += corner[0];
+                normals[indexes[i + 1]] += corner[1];
+                normals[indexes[i + 2]] += corner[2];
+            }
+
+            for (auto& normal : normals)
+                normal = Normalize(normal);
+            return;
+        }
+
+        std::vector<glm::vec3> corners(indexCount);
+        ParallelForBlocks(pool, indexCount / 3, s_BlockSize, [&](size_t begin, size_t end) {
+            for (size_t face = begin; face < end; ++face)
+                FaceNormals(positions, indexes + face * 3, weighting, corners.data() + face * 3);
+        });
+
+        // vertex -> corners adjacency, corners listed in index order
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t i = 0; i < indexCount; ++i)
+            offsets[indexes[i] + 1]++;
+        for (size_t i = 0; i < vertexCount; ++i)
+            offsets[i + 1] += offsets[i];
+
+        std::vector<uint32_t> adjacency(indexCount);
+        {
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; ++i)
+                adjacency[cursor[indexes[i]]++] = (uint32_t)i;
+        }
+
+        // Gather, each vertex is written by exactly one thread
+        ParallelForBlocks(pool, vertexCount, s_BlockSize, [&](size_t begin, size_t end) {
+            for (size_t vertex = begin; vertex < end; ++vertex)
+            {
+                glm::vec3 sum(0.0f);
+                for (uint32_t k = offsets[vertex]; k < offsets[vertex + 1]; ++k)
+                    sum += corners[adjacency[k]];
+
+                normals[vertex] = Normalize(sum);
+            }
+        });
+    }
+
+    void NormalGenerator::Generate(Mesh& mesh, NormalWeighting weighting, ThreadPool* pool)
+    {
+        const std::vector<glm::vec3>& positions = *mesh.Vertex;
+        const std::vector<uint32_t>& indexes = *mesh.Indexes;
+
+        std::vector<glm::vec3> normals;
+        Generate(positions.data(), positions.size(), indexes.data(), indexes.size(), weighting, normals, pool);
+
+        // Both interleave position and normal
+        std::vector<glm::vec3>& vertices = *mesh.Vertices;
+        std::vector<glm::vec3>& lines = *mesh.Normals;
+        for (size_t i = 0; i < normals.size(); ++i)
+        {
+            if (i * 2 + 1 < vertices.size())
+                vertices[i * 2 + 1] = normals[i];
+            if (i * 2 + 1 < lines.size())
+                lines[i * 2 + 1] = normals[i];
+        }
+
+        mesh.MarkDirty();
+    }
+
+}
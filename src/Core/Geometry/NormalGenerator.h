@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Renderer/Mesh.h"
+#include <glm/glm.hpp>
+
+namespace GLMV {
+
+    class ThreadPool;
+
+    enum class NormalWeighting
+    {
+        Area = 0, Angle
+    };
+
+    class NormalGenerator
+    {
+        public:
+            // Smooth per-vertex normals of an indexed triangle list. Every face
+            // corner computes its weighted face normal, then each vertex sums
+            // its corners through a vertex -> corner adjacency (CSR), so no two
+            // threads write the same vertex and the result does not depend on
+            // the thread count. Unreferenced and degenerate vertices get zero.
+            static void Generate(const glm::vec3* positions, size_t vertexCount, const uint32_t* indexes, size_t indexCount,
+                NormalWeighting weighting, std::vector<glm::vec3>& normals, ThreadPool* pool = nullptr);
+
+            // Recomputes the normals of an imported mesh in place, for use
+            // after its positions were edited
+            static void Generate(Mesh& mesh, NormalWeighting weighting, ThreadPool* pool = nullptr);
+    };
+
+}
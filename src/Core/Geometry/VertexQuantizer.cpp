@@ -0,0 +1,212 @@
+#include "VertexQuantizer.h"
+
+#include "Extents.h"
+#include "Core/ThreadPool.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace GLMV {
+
+    // Vertices per ParallelForBlocks block
+    static constexpr size_t s_BlockSize = 1 << 16;
+
+    // The bounding box, or the extents of the positions when the box was
+    // never filled in
+    static std::pair<glm::vec3, glm::vec3> GetBox(const Mesh& mesh)
+    {
+        const auto& box = *mesh.BoundingBox;
+        bool valid = box.first.x <= box.second.x && box.first.y <= box.second.y && box.first.z <= box.second.z
+            && box.first != box.second;
+        if (valid || mesh.Vertex->empty())
+            return box;
+
+        return GetExtents(mesh.Vertex->data(), sizeof(glm::vec3), mesh.Vertex->size());
+    }
+
+    static int32_t ToSnorm(float v, int32_t max)
+    {
+        return (int32_t)std::lround(glm::clamp(v, -1.0f, 1.0f) * max);
+    }
+
+    // What the GPU reads back from a normalized signed integer
+    static float FromSnorm(int32_t v, int32_t max)
+    {
+        return std::max((float)v / max, -1.0f);
+    }
+
+    // Octahedral mapping (Meyer et al. 2010): the unit sphere folded onto
+    // the [-1, 1] square
+    static glm::vec2 OctEncode(const glm::vec3& n)
+    {
+        float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (sum <= 0.0f)
+            return glm::vec2(0.0f);
+
+        glm::vec2 p(n.x / sum, n.y / sum);
+        if (n.z < 0.0f)
+        {
+            glm::vec2 folded(
+                (1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+            p = folded;
+        }
+        return p;
+    }
+
+    // Same as DecodeNormal in Mesh.glsl
+    static glm::vec3 OctDecode(const glm::vec2& p)
+    {
+        glm::vec3 n(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+        if (n.z < 0.0f)
+        {
+            float x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+            float y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+            n.x = x;
+            n.y = y;
+        }
+        float length = glm::length(n);
+        return length > 0.0f ? n / length : n;
+    }
+
+    struct EncodedVertex
+    {
+        uint16_t Position[4];
+        uint32_t Normal;
+    };
+
+    static EncodedVertex EncodeVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& min, const glm::vec3& scale, VertexFormat format)
+    {
+        EncodedVertex vertex;
+        glm::vec3 q = glm::clamp((position - min) * scale, glm::vec3(0.0f), glm::vec3(1.0f)) * 65535.0f;
+        vertex.Position[0] = (uint16_t)std::lround(q.x);
+        vertex.Position[1] = (uint16_t)std::lround(q.y);
+        vertex.Position[2] = (uint16_t)std::lround(q.z);
+        vertex.Position[3] = 65535;
+
+        if (format == VertexFormat::Octahedral16)
+        {
+            glm::vec2 oct = OctEncode(normal);
+            uint16_t x = (uint16_t)(int16_t)ToSnorm(oct.x, 32767);
+            uint16_t y = (uint16_t)(int16_t)ToSnorm(oct.y, 32767);
+            vertex.Normal = x | ((uint32_t)y << 16);
+        }
+        else
+        {
+            float length = glm::length(normal);
+            glm::vec3 n = length > 0.0f ? normal / length : normal;
+            vertex.Normal = ((uint32_t)ToSnorm(n.x, 511) & 0x3ff)
+                | (((uint32_t)ToSnorm(n.y, 511) & 0x3ff) << 10)
+                | (((uint32_t)ToSnorm(n.z, 511) & 0x3ff) << 20);
+        }
+
+        return vertex;
+    }
+
+    static glm::vec3 DecodeNormal(uint32_t normal, VertexFormat format)
+    {
+        if (format == VertexFormat::Octahedral16)
+            return OctDecode(glm::vec2(FromSnorm((int16_t)(normal & 0xffff), 32767), FromSnorm((int16_t)(normal >> 16), 32767)));
+
+        // Sign extend each 10 bit field
+        auto field = [&](int shift) { return FromSnorm(((int32_t)(normal << (22 - shift))) >> 22, 511); };
+        glm::vec3 n(field(0), field(10), field(20));
+        float length = glm::length(n);
+        return length > 0.0f ? n / length : n;
+    }
+
+    // 1 / extent per axis, 0 for flat axes
+    static glm::vec3 GetScale(const std::pair<glm::vec3, glm::vec3>& box)
+    {
+        glm::vec3 extent = box.second - box.first;
+        return glm::vec3(
+            extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+            extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+            extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+    }
+
+    uint32_t VertexQuantizer::GetStride(VertexFormat format)
+    {
+        return format == VertexFormat::Float ? 2 * sizeof(glm::vec3) : sizeof(EncodedVertex);
+    }
+
+    void VertexQuantizer::Encode(const Mesh& mesh, VertexFormat format, std::vector<uint8_t>& data, ThreadPool* pool)
+    {
+        const std::vector<glm::vec3>& vertices = *mesh.Vertices;
+        size_t count = vertices.size() / 2;
+        if (format == VertexFormat::Float)
+        {
+            data.resize(count * GetStride(format));
+            memcpy(data.data(), vertices.data(), data.size());
+            return;
+        }
+
+        auto box = GetBox(mesh);
+        glm::vec3 scale = GetScale(box);
+
+        data.resize(count * sizeof(EncodedVertex));
+        EncodedVertex* encoded = (EncodedVertex*)data.data();
+        ParallelForBlocks(pool, count, s_BlockSize, [&](size_t begin, size_t end)
+        {
+            for (size_t v = begin; v < end; ++v)
+                encoded[v] = EncodeVertex(vertices[v * 2], vertices[v * 2 + 1], box.first, scale, format);
+        });
+    }
+
+    glm::mat4 VertexQuantizer::GetPositionDecode(const Mesh& mesh)
+    {
+        if (mesh.Format == VertexFormat::Float)
+            return glm::mat4(1.0f);
+
+        auto box = GetBox(mesh);
+        glm::vec3 extent = box.second - box.first;
+        return glm::scale(glm::translate(glm::mat4(1.0f), box.first), extent);
+    }
+
+    QuantizationError VertexQuantizer::Measure(const Mesh& mesh, VertexFormat format, ThreadPool* pool)
+    {
+        QuantizationError error;
+        const std::vector<glm::vec3>& vertices = *mesh.Vertices;
+        size_t count = vertices.size() / 2;
+        if (format == VertexFormat::Float || count == 0)
+            return error;
+
+        auto box = GetBox(mesh);
+        glm::vec3 scale = GetScale(box);
+        glm::vec3 extent = box.second - box.first;
+
+        // Per block maxima, as floats do not have an atomic max
+        size_t blocks = (count + s_BlockSize - 1) / s_BlockSize;
+        std::vector<QuantizationError> errors(blocks);
+        ParallelForBlocks(pool, count, s_BlockSize, [&](size_t begin, size_t end)
+        {
+            QuantizationError& block = errors[begin / s_BlockSize];
+            float minCosine = 1.0f;
+            for (size_t v = begin; v < end; ++v)
+            {
+                const glm::vec3& position = vertices[v * 2];
+                const glm::vec3& normal = vertices[v * 2 + 1];
+                EncodedVertex encoded = EncodeVertex(position, normal, box.first, scale, format);
+
+                glm::vec3 decoded = box.first + glm::vec3(encoded.Position[0], encoded.Position[1], encoded.Position[2]) / 65535.0f * extent;
+                block.Position = std::max(block.Position, glm::length(decoded - position));
+
+                float length = glm::length(normal);
+                if (length > 0.0f)
+                    minCosine = std::min(minCosine, glm::dot(normal / length, DecodeNormal(encoded.Normal, format)));
+            }
+            block.Normal = glm::degrees(std::acos(glm::clamp(minCosine, -1.0f, 1.0f)));
+        });
+
+        for (const auto& block : errors)
+        {
+            error.Position = std::max(error.Position, block.Position);
+            error.Normal = std::max(error.Normal, block.Normal);
+        }
+        return error;
+    }
+
+}
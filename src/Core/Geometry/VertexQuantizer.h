@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Renderer/Mesh.h"
+#include <glm/glm.hpp>
+
+namespace GLMV {
+
+    class ThreadPool;
+
+    // Largest differences between a mesh and its quantized GPU copy
+    struct QuantizationError
+    {
+        // Distance, in the units of the mesh
+        float Position = 0.0f;
+        // Angle, in degrees
+        float Normal = 0.0f;
+    };
+
+    // Encodes the position and normal stream of a mesh in one of the
+    // packed VertexFormats. Positions become 16 bit fractions of the mesh
+    // BoundingBox, the box itself is folded back in by GetPositionDecode.
+    class VertexQuantizer
+    {
+        public:
+            // Bytes per vertex in the GPU buffer
+            static uint32_t GetStride(VertexFormat format);
+
+            // Interleaved position and normal of every vertex, stride bytes apart
+            static void Encode(const Mesh& mesh, VertexFormat format, std::vector<uint8_t>& data, ThreadPool* pool = nullptr);
+
+            // Maps encoded positions back into mesh space, identity for floats
+            static glm::mat4 GetPositionDecode(const Mesh& mesh);
+
+            // Encodes and decodes every vertex the way the GPU does
+            static QuantizationError Measure(const Mesh& mesh, VertexFormat format, ThreadPool* pool = nullptr);
+    };
+
+}
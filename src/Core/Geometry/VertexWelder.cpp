@@ -0,0 +1,309 @@
+#include "VertexWelder.h"
+
+#include "Core/ThreadPool.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace GLMV {
+
+    static uint64_t HashWords(const uint32_t* words, uint32_t count)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            hash ^= words[i];
+            hash *= 0x100000001b3ull;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    static size_t WeldWords(const T* vertices, size_t count, uint32_t stride, std::vector<T>& unique, std::vector<uint32_t>& remap)
+    {
+        static_assert(sizeof(T) == sizeof(uint32_t), "vertices are hashed as 32 bit words");
+
+        remap.resize(count);
+
+        // Open addressing, power of two sized, at most half full
+        size_t capacity = 16;
+        while (capacity < count * 2)
+            capacity *= 2;
+        std::vector<uint32_t> table(capacity, UINT32_MAX);
+
+        size_t base = unique.size() / stride;
+        size_t uniqueCount = 0;
+        const size_t bytes = stride * sizeof(T);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const T* vertex = vertices + i * stride;
+            size_t slot = HashWords((const uint32_t*)vertex, stride) & (capacity - 1);
+
+            while (true)
+            {
+                uint32_t id = table[slot];
+                if (id == UINT32_MAX)
+                {
+                    table[slot] = (uint32_t)uniqueCount;
+                    remap[i] = (uint32_t)uniqueCount++;
+                    unique.insert(unique.end(), vertex, vertex + stride);
+                    break;
+                }
+
+                if (memcmp(unique.data() + (base + id) * stride, vertex, bytes) == 0)
+                {
+                    remap[i] = id;
+                    break;
+                }
+
+                slot = (slot + 1) & (capacity - 1);
+            }
+        }
+
+        return uniqueCount;
+    }
+
+    size_t VertexWelder::Weld(const float* vertices, size_t count, uint32_t stride, std::vector<float>& unique, std::vector<uint32_t>& remap)
+    {
+        return WeldWords(vertices, count, stride, unique, remap);
+    }
+
+    size_t VertexWelder::Weld(const uint32_t* keys, size_t count, uint32_t stride, std::vector<uint32_t>& unique, std::vector<uint32_t>& remap)
+    {
+        return WeldWords(keys, count, stride, unique, remap);
+    }
+
+    // Positions per ParallelFor index, and the number of hash shards
+    static constexpr size_t s_BlockSize = 1 << 16;
+    static constexpr uint32_t s_ShardBits = 8;
+    // Marks remap entries that already hold the new index
+    static constexpr uint32_t s_Resolved = 0x80000000u;
+
+    // Bits of a position with -0 turned into 0, so both weld
+    static void PositionKey(const glm::vec3& position, uint32_t key[3])
+    {
+        glm::vec3 canonical = position + glm::vec3(0.0f);
+        memcpy(key, &canonical, sizeof(glm::vec3));
+    }
+
+    size_t VertexWelder::Weld(const PositionStream& positions, std::vector<glm::vec3>& unique, std::vector<uint32_t>& remap, ThreadPool* pool)
+    {
+        const size_t count = positions.Count;
+        const size_t shards = (size_t)1 << s_ShardBits;
+        const size_t blocks = (count + s_BlockSize - 1) / s_BlockSize;
+
+        unique.clear();
+        remap.resize(count);
+
+        // How many positions every block sends to every shard
+        std::vector<uint8_t> shardOf(count);
+        std::vector<uint32_t> cursors(blocks * shards, 0);
+        ParallelForBlocks(pool, count, s_BlockSize, [&](size_t begin, size_t end) {
+            uint32_t* counts = cursors.data() + begin / s_BlockSize * shards;
+            positions.ForEach(begin, end, [&](size_t i, const glm::vec3& position) {
+                uint32_t key[3];
+                PositionKey(position, key);
+                shardOf[i] = (uint8_t)(HashWords(key, 3) >> (64 - s_ShardBits));
+                counts[shardOf[i]]++;
+            });
+        });
+
+        // Shard major offsets, so every shard lists its positions in order
+        std::vector<uint32_t> shardStart(shards + 1);
+        uint32_t total = 0;
+        for (size_t shard = 0; shard < shards; ++shard)
+        {
+            shardStart[shard] = total;
+            for (size_t block = 0; block < blocks; ++block)
+            {
+                uint32_t blockCount = cursors[block * shards + shard];
+                cursors[block * shards + shard] = total;
+                total += blockCount;
+            }
+        }
+        shardStart[shards] = total;
+
+        // Each shard gets its keys in a contiguous run, so welding it does
+        // not jump around the source
+        struct ShardEntry
+        {
+            uint32_t Key[3];
+            uint32_t Index;
+        };
+
+        std::vector<ShardEntry> entries(count);
+        ParallelForBlocks(pool, count, s_BlockSize, [&](size_t begin, size_t end) {
+            uint32_t* cursor = cursors.data() + begin / s_BlockSize * shards;
+            positions.ForEach(begin, end, [&](size_t i, const glm::vec3& position) {
+                ShardEntry& entry = entries[cursor[shardOf[i]]++];
+                PositionKey(position, entry.Key);
+                entry.Index = (uint32_t)i;
+            });
+        });
+        shardOf = {};
+        cursors = {};
+
+        // Equal positions always land in the same shard. remap[i] becomes
+        // the first position with the value of position i.
+        ParallelForBlocks(pool, shards, 1, [&](size_t shard, size_t) {
+            size_t begin = shardStart[shard], end = shardStart[shard + 1];
+
+            size_t capacity = 16;
+            while (capacity < (end - begin) * 2)
+                capacity *= 2;
+            std::vector<uint32_t> table(capacity, UINT32_MAX);
+
+            for (size_t k = begin; k < end; ++k)
+            {
+                const ShardEntry& entry = entries[k];
+                size_t slot = HashWords(entry.Key, 3) & (capacity - 1);
+
+                while (true)
+                {
+                    uint32_t id = table[slot];
+                    if (id == UINT32_MAX)
+                    {
+                        table[slot] = (uint32_t)k;
+                        remap[entry.Index] = entry.Index;
+                        break;
+                    }
+
+                    if (memcmp(entries[id].Key, entry.Key, sizeof(entry.Key)) == 0)
+                    {
+                        remap[entry.Index] = entries[id].Index;
+                        break;
+                    }
+
+                    slot = (slot + 1) & (capacity - 1);
+                }
+            }
+        });
+        entries = {};
+
+        // New indexes in first use order, counted per block first
+        std::vector<uint32_t> blockStart(blocks + 1, 0);
+        ParallelForBlocks(pool, count, s_BlockSize, [&](size_t begin, size_t end) {
+            uint32_t firsts = 0;
+            for (size_t i = begin; i < end; ++i)
+                firsts += remap[i] == i;
+            blockStart[begin / s_BlockSize + 1] = firsts;
+        });
+        for (size_t block = 0; block < blocks; ++block)
+            blockStart[block + 1] += blockStart[block];
+
+        unique.resize(blockStart[blocks]);
+        ParallelForBlocks(pool, count, s_BlockSize, [&](size_t begin, size_t end) {
+            uint32_t id = blockStart[begin / s_BlockSize];
+            positions.ForEach(begin, end, [&](size_t i, const glm::vec3& position) {
+                if (remap[i] != i)
+                    return;
+
+                uint32_t key[3];
+                PositionKey(position, key);
+                memcpy(&unique[id], key, sizeof(glm::vec3));
+                remap[i] = id++ | s_Resolved;
+            });
+        });
+
+        // The others only read first positions, which are not written here
+        ParallelForBlocks(pool, count, s_BlockSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (!(remap[i] & s_Resolved))
+                    remap[i] = remap[remap[i]];
+            }
+        });
+        ParallelForBlocks(pool, count, s_BlockSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                remap[i] &= ~s_Resolved;
+        });
+
+        return unique.size();
+    }
+
+    size_t VertexWelder::WeldPositions(const std::vector<glm::vec3>& positions, float epsilon, std::vector<uint32_t>& remap)
+    {
+        remap.resize(positions.size());
+
+        // Exact weld is the same as an interleaved weld of positions alone
+        if (epsilon <= 0.0f)
+        {
+            std::vector<float> unique;
+            std::vector<uint32_t> ids;
+            size_t count = Weld((const float*)positions.data(), positions.size(), 3, unique, ids);
+
+            // point every duplicate at the first position with the same value
+            std::vector<uint32_t> first(count, UINT32_MAX);
+            for (size_t i = 0; i < positions.size(); ++i)
+            {
+                if (first[ids[i]] == UINT32_MAX)
+                    first[ids[i]] = (uint32_t)i;
+                remap[i] = first[ids[i]];
+            }
+            return count;
+        }
+
+        // Grid of epsilon sized cells: a close enough position can only be
+        // in the same cell or one of its 26 neighbours.
+        const float inverse = 1.0f / epsilon;
+        const float epsilon2 = epsilon * epsilon;
+
+        auto cellKey = [](int64_t x, int64_t y, int64_t z) {
+            return (uint64_t)(x * 73856093) ^ (uint64_t)(y * 19349663) ^ (uint64_t)(z * 83492791);
+        };
+
+        std::unordered_map<uint64_t, uint32_t> heads;
+        heads.reserve(positions.size());
+        std::vector<uint32_t> next(positions.size(), UINT32_MAX);
+
+        size_t count = 0;
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            const glm::vec3& p = positions[i];
+            int64_t cx = (int64_t)std::floor(p.x * inverse);
+            int64_t cy = (int64_t)std::floor(p.y * inverse);
+            int64_t cz = (int64_t)std::floor(p.z * inverse);
+
+            uint32_t found = UINT32_MAX;
+            for (int64_t dx = -1; dx <= 1 && found == UINT32_MAX; ++dx)
+                for (int64_t dy = -1; dy <= 1 && found == UINT32_MAX; ++dy)
+                    for (int64_t dz = -1; dz <= 1 && found == UINT32_MAX; ++dz)
+                    {
+                        auto it = heads.find(cellKey(cx + dx, cy + dy, cz + dz));
+                        if (it == heads.end())
+                            continue;
+
+                        for (uint32_t j = it->second; j != UINT32_MAX; j = next[j])
+                        {
+                            glm::vec3 d = positions[j] - p;
+                            if (glm::dot(d, d) <= epsilon2)
+                            {
+                                found = j;
+                                break;
+                            }
+                        }
+                    }
+
+            if (found != UINT32_MAX)
+            {
+                remap[i] = found;
+                continue;
+            }
+
+            // keep it as a representative of its cell
+            remap[i] = (uint32_t)i;
+            auto [it, inserted] = heads.emplace(cellKey(cx, cy, cz), (uint32_t)i);
+            if (!inserted)
+            {
+                next[i] = it->second;
+                it->second = (uint32_t)i;
+            }
+            count++;
+        }
+
+        return count;
+    }
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Base.h"
+#include <glm/glm.hpp>
+
+#include <cstring>
+
+namespace GLMV {
+
+    class ThreadPool;
+
+    // Positions stored in fixed size groups, like the three corners of a
+    // binary stl triangle record. Position i is read from
+    // Data + (i / GroupSize) * GroupStride + (i % GroupSize) * sizeof(glm::vec3).
+    struct PositionStream
+    {
+        const char* Data = nullptr;
+        size_t Count = 0;
+        uint32_t GroupSize = 1;
+        uint32_t GroupStride = sizeof(glm::vec3);
+
+        glm::vec3 operator[](size_t i) const
+        {
+            glm::vec3 position;
+            memcpy(&position, Data + (i / GroupSize) * GroupStride + (i % GroupSize) * sizeof(glm::vec3), sizeof(glm::vec3));
+            return position;
+        }
+
+        // Calls fn(i, position) for i in [begin, end), walking the groups
+        // instead of dividing for every position
+        template<typename Fn>
+        void ForEach(size_t begin, size_t end, const Fn& fn) const
+        {
+            const char* group = Data + (begin / GroupSize) * GroupStride;
+            uint32_t corner = (uint32_t)(begin % GroupSize);
+            for (size_t i = begin; i < end; ++i)
+            {
+                glm::vec3 position;
+                memcpy(&position, group + corner * sizeof(glm::vec3), sizeof(glm::vec3));
+                fn(i, position);
+
+                if (++corner == GroupSize)
+                {
+                    corner = 0;
+                    group += GroupStride;
+                }
+            }
+        }
+    };
+
+    class VertexWelder
+    {
+        public:
+            // Merges positions closer than epsilon to each other. remap[i] is
+            // the index of the position that i was merged into. Returns how many
+            // positions are left.
+            static size_t WeldPositions(const std::vector<glm::vec3>& positions, float epsilon, std::vector<uint32_t>& remap);
+
+            // Deduplicates `count` interleaved vertices of `stride` floats,
+            // compared bit for bit. Unique vertices are appended to `unique` in
+            // first use order and remap[i] is the new index of vertex i.
+            // Returns the number of unique vertices.
+            static size_t Weld(const float* vertices, size_t count, uint32_t stride, std::vector<float>& unique, std::vector<uint32_t>& remap);
+            // Same for tuples of indexes, e.g. the position/texcoord/normal
+            // references of obj face corners
+            static size_t Weld(const uint32_t* keys, size_t count, uint32_t stride, std::vector<uint32_t>& unique, std::vector<uint32_t>& remap);
+
+            // Exact weld of a large stream of positions, fewer than 2^31. They
+            // are sharded by hash and every shard is welded on its own, so the
+            // threads never share a table. The result does not depend on the
+            // pool: unique holds the positions in first use order, with -0
+            // taken as 0, and remap[i] is the new index of position i.
+            static size_t Weld(const PositionStream& positions, std::vector<glm::vec3>& unique, std::vector<uint32_t>& remap, ThreadPool* pool = nullptr);
+    };
+
+}
@@ -0,0 +1,176 @@
+#include "AsyncImporter.h"
+#include "Importer.h"
+
+#include "Core/Renderer/MeshCache.h"
+
+#include <chrono>
+
+namespace GLMV {
+
+    // Bytes handed to the driver per upload call, small enough that a single
+    // slice never blows the frame budget on its own
+    static constexpr size_t s_UploadSlice = 8 << 20;
+
+    AsyncImporter::~AsyncImporter()
+    {
+        m_Progress->Cancel = true;
+        Join();
+    }
+
+    bool AsyncImporter::Import(const std::string& path, const ImportOptions& options)
+    {
+        return Import(std::vector<std::string>{ path }, options);
+    }
+
+    bool AsyncImporter::Import(const std::vector<std::string>& paths, const ImportOptions& options)
+    {
+        Reap();
+        if (m_Busy || m_Stopping || paths.empty())
+            return false;
+
+        Join();
+        Reset();
+
+        m_Path = paths.size() == 1 ? paths[0] : std::to_string(paths.size()) + " files";
+        m_Busy = true;
+
+        // The worker keeps its own reference, the progress outlives a Reset
+        Ref<ImportProgress> progress = m_Progress;
+        m_Worker = std::thread([this, paths, options, progress]()
+        {
+            std::vector<ImportResult> results;
+            Importer::ImportBatch(paths, options, results, progress.get());
+
+            if (!progress->IsCancelled())
+            {
+                for (auto& result : results)
+                {
+                    if (!result.Meshes.empty())
+                        m_Results.Push(CreateRef<ImportResult>(std::move(result)));
+                }
+            }
+
+            // Marks the end of the batch
+            m_Results.Push(nullptr);
+            progress->Finished = true;
+        });
+
+        return true;
+    }
+
+    void AsyncImporter::Cancel()
+    {
+        if (!m_Busy)
+            return;
+
+        // Stages that do not check for cancellation can take a while to
+        // return, the worker is left to finish and joined by OnUpdate
+        m_Progress->Cancel = true;
+        m_Stopping = m_Progress;
+
+        if (m_Scene)
+        {
+            for (Entity entity : m_Created)
+                m_Scene->DestroyEntity(entity);
+        }
+
+        LOG_INFO("Import of '%s' cancelled", m_Path.c_str());
+        Reset();
+    }
+
+    void AsyncImporter::OnUpdate(const Ref<Scene>& scene, float budgetMs)
+    {
+        Reap();
+        if (!m_Busy)
+            return;
+
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::microseconds((int64_t)(budgetMs * 1000.0f));
+
+        while (true)
+        {
+            if (!m_Current)
+            {
+                Ref<ImportResult> result;
+                if (!m_Results.Pop(result))
+                    return;
+
+                if (!result)
+                    break;
+
+                if (!m_Scene)
+                {
+                    m_Scene = scene;
+                    m_Progress->Stage = ImportStage::Uploading;
+                }
+
+                // One group per file, as with a synchronous load
+                m_Current = result;
+                m_NextMesh = 0;
+                m_MeshCount += result->Meshes.size();
+                m_Group = UUID();
+            }
+
+            while (m_NextMesh < m_Current->Meshes.size())
+            {
+                size_t budget = s_UploadSlice;
+                if (MeshCache::Upload(m_Current->Meshes[m_NextMesh]->Mesh_, budget))
+                {
+                    m_Created.push_back(Importer::CreateEntity(m_Scene, *m_Current, m_NextMesh, m_Group));
+                    ++m_NextMesh;
+                }
+
+                if (std::chrono::steady_clock::now() >= deadline)
+                    return;
+            }
+
+            m_Current = nullptr;
+        }
+
+        Join();
+        m_Progress->Stage = ImportStage::Done;
+        if (m_Created.empty())
+        {
+            LOG_ERROR("Import of '%s' failed", m_Path.c_str());
+        }
+        else
+        {
+            LOG_INFO("Imported '%s' into the scene: %zu entities", m_Path.c_str(), m_Created.size());
+        }
+        Reset();
+    }
+
+    void AsyncImporter::Join()
+    {
+        if (m_Worker.joinable())
+            m_Worker.join();
+    }
+
+    void AsyncImporter::Reap()
+    {
+        if (!m_Stopping || !m_Stopping->Finished)
+            return;
+
+        Join();
+        m_Stopping = nullptr;
+
+        // What the cancelled worker queued after the last Reset
+        Ref<ImportResult> result;
+        while (m_Results.Pop(result)) {}
+    }
+
+    void AsyncImporter::Reset()
+    {
+        Ref<ImportResult> result;
+        while (m_Results.Pop(result)) {}
+
+        m_Busy = false;
+        m_Scene = nullptr;
+        m_Current = nullptr;
+        m_NextMesh = 0;
+        m_MeshCount = 0;
+        m_Created.clear();
+        m_Progress = CreateRef<ImportProgress>();
+    }
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Base.h"
+#include "ImportData.h"
+#include "ImportOptions.h"
+#include "Core/MPSCQueue.h"
+#include "Core/Scene/Scene.h"
+#include "Core/Scene/Entity.h"
+
+#include <thread>
+
+namespace GLMV {
+
+    // Runs Importer::ImportBatch on a worker thread. The finished results are
+    // handed back through a lock-free queue, and OnUpdate then uploads the
+    // meshes and creates their entities a few milliseconds per frame.
+    class AsyncImporter
+    {
+        public:
+            AsyncImporter() = default;
+            ~AsyncImporter();
+
+            AsyncImporter(const AsyncImporter&) = delete;
+            AsyncImporter& operator=(const AsyncImporter&) = delete;
+
+            // Returns false while another import is still running, or a
+            // cancelled one is still stopping
+            bool Import(const std::string& path, const ImportOptions& options = {});
+            bool Import(const std::vector<std::string>& paths, const ImportOptions& options = {});
+            // Removes the entities created so far and tells the worker to
+            // stop. Returns right away, OnUpdate joins the worker once it
+            // reached its next cancellation check and returned.
+            void Cancel();
+
+            // Main thread only, spends at most budgetMs on uploads and entities
+            void OnUpdate(const Ref<Scene>& scene, float budgetMs = 4.0f);
+
+            bool IsBusy() const { return m_Busy; }
+            bool IsStopping() const { return m_Stopping != nullptr; }
+            const std::string& GetPath() const { return m_Path; }
+            const ImportProgress& GetProgress() const { return *m_Progress; }
+            size_t GetMeshCount() const { return m_MeshCount; }
+            size_t GetMeshesCreated() const { return m_Created.size(); }
+        private:
+            void Join();
+            void Reset();
+            // Joins a cancelled worker that has returned
+            void Reap();
+        private:
+            std::thread m_Worker;
+            std::string m_Path;
+            Ref<ImportProgress> m_Progress = CreateRef<ImportProgress>();
+            MPSCQueue<Ref<ImportResult>> m_Results;
+            bool m_Busy = false;
+            // Progress of a cancelled worker that may still be running
+            Ref<ImportProgress> m_Stopping;
+
+            Ref<Scene> m_Scene;
+            Ref<ImportResult> m_Current;
+            size_t m_NextMesh = 0;
+            size_t m_MeshCount = 0;
+            std::vector<Entity> m_Created;
+            UUID m_Group = 0;
+    };
+
+}
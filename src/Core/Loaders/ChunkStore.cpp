@@ -0,0 +1,189 @@
+#include "ChunkStore.h"
+
+#include <cstring>
+#include <filesystem>
+
+namespace GLMV {
+
+    static constexpr uint32_t s_StoreVersion = 1;
+    static constexpr char s_StoreMagic[8] = { 'G', 'L', 'M', 'V', 'C', 'H', 'N', 'K' };
+    static constexpr uint64_t s_Alignment = 16;
+
+    // File layout: header, chunk payloads 16 byte aligned, then the chunk
+    // table, which is only known once every chunk was written
+    struct StoreHeader
+    {
+        char Magic[8];
+        uint32_t Version;
+        uint32_t ChunkCount;
+        uint64_t Key;
+        uint64_t TableOffset;
+    };
+
+    struct StoreChunk
+    {
+        float BoundsMin[3], BoundsMax[3];
+        uint64_t VerticesOffset, VerticesCount;
+        uint64_t IndexesOffset, IndexesCount;
+    };
+
+    Ref<ChunkStore> ChunkStore::Open(const std::string& path, uint64_t key)
+    {
+        Ref<MappedFile> file = MappedFile::Create(path);
+        if (!file->IsValid() || file->Size() < sizeof(StoreHeader))
+            return nullptr;
+
+        const uint64_t size = file->Size();
+        auto inside = [size](uint64_t offset, uint64_t bytes) { return offset <= size && bytes <= size - offset; };
+
+        StoreHeader header;
+        memcpy(&header, file->Data(), sizeof(header));
+        if (memcmp(header.Magic, s_StoreMagic, sizeof(s_StoreMagic)) != 0 || header.Version != s_StoreVersion || header.Key != key
+            || !inside(header.TableOffset, (uint64_t)header.ChunkCount * sizeof(StoreChunk)))
+            return nullptr;
+
+        Ref<ChunkStore> store = CreateRef<ChunkStore>();
+        store->m_Path = path;
+        store->m_Chunks.resize(header.ChunkCount);
+        for (uint32_t i = 0; i < header.ChunkCount; ++i)
+        {
+            StoreChunk record;
+            memcpy(&record, file->Data() + header.TableOffset + i * sizeof(StoreChunk), sizeof(record));
+            if (record.VerticesCount % 2 || !inside(record.VerticesOffset, record.VerticesCount * sizeof(glm::vec3))
+                || !inside(record.IndexesOffset, record.IndexesCount * sizeof(uint32_t)))
+                return nullptr;
+
+            ChunkInfo& chunk = store->m_Chunks[i];
+            chunk.Min = { record.BoundsMin[0], record.BoundsMin[1], record.BoundsMin[2] };
+            chunk.Max = { record.BoundsMax[0], record.BoundsMax[1], record.BoundsMax[2] };
+            chunk.VerticesOffset = record.VerticesOffset;
+            chunk.VerticesCount = record.VerticesCount;
+            chunk.IndexesOffset = record.IndexesOffset;
+            chunk.IndexesCount = record.IndexesCount;
+        }
+
+        store->m_File = file;
+        return store;
+    }
+
+    Ref<Mesh> ChunkStore::Load(uint32_t chunk) const
+    {
+        Ref<Mesh> mesh = Mesh::Create();
+        if (chunk >= m_Chunks.size())
+            return mesh;
+
+        const ChunkInfo& info = m_Chunks[chunk];
+        const glm::vec3* vertices = (const glm::vec3*)(m_File->Data() + info.VerticesOffset);
+        const uint32_t* indexes = (const uint32_t*)(m_File->Data() + info.IndexesOffset);
+        mesh->Vertices->assign(vertices, vertices + info.VerticesCount);
+        mesh->Indexes->assign(indexes, indexes + info.IndexesCount);
+
+        // The mesh owns a copy now, the mapped pages can go
+        m_File->Discard((const char*)vertices, (const char*)(vertices + info.VerticesCount));
+        m_File->Discard((const char*)indexes, (const char*)(indexes + info.IndexesCount));
+
+        size_t count = info.VerticesCount / 2;
+        mesh->Vertex->resize(count);
+        for (size_t v = 0; v < count; ++v)
+            (*mesh->Vertex)[v] = (*mesh->Vertices)[v * 2];
+        *mesh->Normals = *mesh->Vertices;
+        *mesh->BoundingBox = { info.Min, info.Max };
+        return mesh;
+    }
+
+    ChunkStoreWriter::ChunkStoreWriter(const std::string& path, uint64_t key)
+        : m_Path(path), m_Temporary(path + ".tmp"), m_Key(key)
+    {
+        m_Out.open(m_Temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+
+        // rewritten by Finish
+        StoreHeader header;
+        memset(&header, 0, sizeof(header));
+        Write(&header, sizeof(header));
+        Pad();
+    }
+
+    ChunkStoreWriter::~ChunkStoreWriter()
+    {
+        // Finish was not called or failed
+        if (m_Out.is_open())
+        {
+            m_Out.close();
+            std::error_code error;
+            std::filesystem::remove(m_Temporary, error);
+        }
+    }
+
+    void ChunkStoreWriter::Write(const void* data, uint64_t bytes)
+    {
+        m_Out.write((const char*)data, bytes);
+        m_Written += bytes;
+    }
+
+    void ChunkStoreWriter::Pad()
+    {
+        static const char zeros[s_Alignment] = {};
+        uint64_t aligned = (m_Written + s_Alignment - 1) & ~(s_Alignment - 1);
+        Write(zeros, aligned - m_Written);
+    }
+
+    void ChunkStoreWriter::Add(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indexes, const std::pair<glm::vec3, glm::vec3>& bounds)
+    {
+        ChunkInfo& chunk = m_Chunks.emplace_back();
+        chunk.Min = bounds.first;
+        chunk.Max = bounds.second;
+
+        chunk.VerticesOffset = m_Written;
+        chunk.VerticesCount = vertices.size();
+        Write(vertices.data(), vertices.size() * sizeof(glm::vec3));
+        Pad();
+
+        chunk.IndexesOffset = m_Written;
+        chunk.IndexesCount = indexes.size();
+        Write(indexes.data(), indexes.size() * sizeof(uint32_t));
+        Pad();
+    }
+
+    bool ChunkStoreWriter::Finish()
+    {
+        StoreHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.Magic, s_StoreMagic, sizeof(s_StoreMagic));
+        header.Version = s_StoreVersion;
+        header.ChunkCount = (uint32_t)m_Chunks.size();
+        header.Key = m_Key;
+        header.TableOffset = m_Written;
+
+        for (const auto& chunk : m_Chunks)
+        {
+            StoreChunk record;
+            memcpy(record.BoundsMin, &chunk.Min, sizeof(record.BoundsMin));
+            memcpy(record.BoundsMax, &chunk.Max, sizeof(record.BoundsMax));
+            record.VerticesOffset = chunk.VerticesOffset;
+            record.VerticesCount = chunk.VerticesCount;
+            record.IndexesOffset = chunk.IndexesOffset;
+            record.IndexesCount = chunk.IndexesCount;
+            Write(&record, sizeof(record));
+        }
+
+        m_Out.seekp(0);
+        m_Out.write((const char*)&header, sizeof(header));
+        m_Out.close();
+        if (!m_Out)
+        {
+            std::error_code error;
+            std::filesystem::remove(m_Temporary, error);
+            return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(m_Temporary, m_Path, error);
+        if (error)
+        {
+            std::filesystem::remove(m_Temporary, error);
+            return false;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Base.h"
+#include "MappedFile.h"
+#include "Core/Renderer/Mesh.h"
+
+#include <fstream>
+
+namespace GLMV {
+
+    struct ChunkInfo
+    {
+        glm::vec3 Min, Max;
+        uint64_t VerticesOffset = 0, VerticesCount = 0;
+        uint64_t IndexesOffset = 0, IndexesCount = 0;
+
+        // CPU memory the chunk takes once paged into a Mesh
+        uint64_t GetMemory() const
+        {
+            // Vertices and Normals hold the interleaved pairs, Vertex the positions
+            return VerticesCount * sizeof(glm::vec3) * 2 + VerticesCount / 2 * sizeof(glm::vec3) + IndexesCount * sizeof(uint32_t);
+        }
+    };
+
+    // Spatial chunks of one streamed import, in a single mapped file. Chunks
+    // are read on demand, from any thread.
+    class ChunkStore
+    {
+        public:
+            // Null if the file is missing, damaged or was written for another key
+            static Ref<ChunkStore> Open(const std::string& path, uint64_t key);
+
+            const std::string& GetPath() const { return m_Path; }
+            const std::vector<ChunkInfo>& GetChunks() const { return m_Chunks; }
+
+            // Copies a chunk into a new mesh
+            Ref<Mesh> Load(uint32_t chunk) const;
+        private:
+            std::string m_Path;
+            Ref<MappedFile> m_File;
+            std::vector<ChunkInfo> m_Chunks;
+    };
+
+    // Appends chunks to a new store. Nothing is visible under the final path
+    // before Finish() succeeds.
+    class ChunkStoreWriter
+    {
+        public:
+            ChunkStoreWriter(const std::string& path, uint64_t key);
+            ~ChunkStoreWriter();
+
+            bool IsValid() const { return (bool)m_Out; }
+
+            // Interleaved position/normal pairs and triangle indexes
+            void Add(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indexes, const std::pair<glm::vec3, glm::vec3>& bounds);
+            bool Finish();
+
+            size_t GetChunkCount() const { return m_Chunks.size(); }
+        private:
+            void Write(const void* data, uint64_t bytes);
+            void Pad();
+        private:
+            std::string m_Path;
+            std::string m_Temporary;
+            uint64_t m_Key;
+            std::ofstream m_Out;
+            uint64_t m_Written = 0;
+            std::vector<ChunkInfo> m_Chunks;
+    };
+
+}
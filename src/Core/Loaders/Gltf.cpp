@@ -0,0 +1,888 @@
+#include "Gltf.h"
+#include "MappedFile.h"
+#include "Importer.h"
+#include "Core/ThreadPool.h"
+#include "Core/Geometry/Extents.h"
+#include "Core/Geometry/NormalGenerator.h"
+#include "Core/Renderer/Mesh.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include <atomic>
+#include <cfloat>
+#include <cstring>
+#include <filesystem>
+
+namespace GLMV {
+
+    // GLB container, all little endian
+    static constexpr uint32_t s_GlbMagic = 0x46546C67;  // "glTF"
+    static constexpr uint32_t s_JsonChunk = 0x4E4F534A; // "JSON"
+    static constexpr uint32_t s_BinChunk = 0x004E4942;  // "BIN\0"
+
+    enum GltfComponentType : uint32_t
+    {
+        Byte = 5120, UnsignedByte = 5121, Short = 5122, UnsignedShort = 5123, UnsignedInt = 5125, Float = 5126
+    };
+
+    enum GltfMode : uint32_t
+    {
+        Triangles = 4, TriangleStrip = 5, TriangleFan = 6
+    };
+
+    struct GltfBuffer
+    {
+        const char* Data = nullptr;
+        size_t Size = 0;
+        // Backing storage, a mapped file or a decoded data uri
+        Ref<MappedFile> File;
+        std::vector<char> Decoded;
+    };
+
+    struct GltfBufferView
+    {
+        uint32_t Buffer = 0;
+        size_t Offset = 0;
+        size_t Length = 0;
+        // 0 means tightly packed
+        uint32_t Stride = 0;
+    };
+
+    struct GltfAccessor
+    {
+        // -1 when the accessor has no data, which means all zeros
+        int View = -1;
+        size_t Offset = 0;
+        uint32_t ComponentType = Float;
+        uint32_t Components = 1;
+        size_t Count = 0;
+        bool Normalized = false;
+    };
+
+    struct GltfPrimitive
+    {
+        int Position = -1, Normal = -1, TexCoord = -1, Color = -1, Indices = -1;
+        int Material = -1;
+        uint32_t Mode = Triangles;
+        // Filled once decoded, null when the primitive could not be read
+        Ref<Mesh> Mesh_;
+    };
+
+    struct GltfMesh
+    {
+        std::string Name;
+        std::vector<GltfPrimitive> Primitives;
+        bool Used = false;
+    };
+
+    struct GltfInstance
+    {
+        uint32_t Mesh;
+        std::string Name;
+        glm::mat4 Transform;
+    };
+
+    // State of a single glTF import
+    struct GltfContext
+    {
+        std::string Path;
+        ImportOptions Options;
+        ImportProgress* Progress = nullptr;
+
+        std::vector<GltfBuffer> Buffers;
+        std::vector<GltfBufferView> Views;
+        std::vector<GltfAccessor> Accessors;
+        std::vector<GltfMesh> Meshes;
+        // Key of every material in ImportResult::Materials
+        std::vector<std::string> Materials;
+        std::vector<GltfInstance> Instances;
+
+        bool IsCancelled() const { return Progress && Progress->IsCancelled(); }
+    };
+
+    static uint32_t ComponentSize(uint32_t type)
+    {
+        switch (type)
+        {
+            case Byte:
+            case UnsignedByte:  return 1;
+            case Short:
+            case UnsignedShort: return 2;
+            case UnsignedInt:
+            case Float:         return 4;
+            default:            return 0;
+        }
+    }
+
+    static uint32_t ComponentCount(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2")   return 2;
+        if (type == "VEC3")   return 3;
+        if (type == "VEC4")   return 4;
+        if (type == "MAT2")   return 4;
+        if (type == "MAT3")   return 9;
+        if (type == "MAT4")   return 16;
+        return 0;
+    }
+
+    static float ReadComponent(const char* data, uint32_t type, bool normalized)
+    {
+        switch (type)
+        {
+            case Byte:
+            {
+                float value = (int8_t)*data;
+                return normalized ? std::max(value / 127.0f, -1.0f) : value;
+            }
+            case UnsignedByte:
+            {
+                float value = (uint8_t)*data;
+                return normalized ? value / 255.0f : value;
+            }
+            case Short:
+            {
+                int16_t value;
+                memcpy(&value, data, sizeof(value));
+                return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+            }
+            case UnsignedShort:
+            {
+                uint16_t value;
+                memcpy(&value, data, sizeof(value));
+                return normalized ? value / 65535.0f : value;
+            }
+            case UnsignedInt:
+            {
+                uint32_t value;
+                memcpy(&value, data, sizeof(value));
+                return (float)value;
+            }
+            case Float:
+            {
+                float value;
+                memcpy(&value, data, sizeof(value));
+                return value;
+            }
+            default:
+                return 0.0f;
+        }
+    }
+
+    // Element 0 of the accessor and the distance between elements. Returns
+    // null when the accessor reaches past its buffer view or buffer.
+    static const char* GetElements(const GltfContext& context, const GltfAccessor& accessor, size_t& stride)
+    {
+        if (accessor.View < 0 || accessor.View >= (int)context.Views.size())
+            return nullptr;
+
+        const GltfBufferView& view = context.Views[accessor.View];
+        if (view.Buffer >= context.Buffers.size())
+            return nullptr;
+
+        const GltfBuffer& buffer = context.Buffers[view.Buffer];
+        size_t elementSize = (size_t)ComponentSize(accessor.ComponentType) * accessor.Components;
+        stride = view.Stride ? view.Stride : elementSize;
+
+        if (elementSize == 0 || view.Offset > buffer.Size || view.Length > buffer.Size - view.Offset || accessor.Count == 0)
+            return nullptr;
+        if (accessor.Offset > view.Length || (accessor.Count - 1) > (view.Length - accessor.Offset) / stride
+            || accessor.Offset + (accessor.Count - 1) * stride + elementSize > view.Length)
+            return nullptr;
+
+        return buffer.Data + view.Offset + accessor.Offset;
+    }
+
+    // Reads an accessor as float vectors. Tightly packed float data of the
+    // same size is copied in one go, anything else converted per component.
+    // Components the accessor does not have keep the value from fill.
+    template<typename Vec>
+    static bool ReadFloats(const GltfContext& context, int index, std::vector<Vec>& out, const Vec& fill = Vec(0.0f))
+    {
+        constexpr uint32_t components = (uint32_t)Vec::length();
+        if (index < 0 || index >= (int)context.Accessors.size())
+            return false;
+
+        const GltfAccessor& accessor = context.Accessors[index];
+        out.assign(accessor.Count, fill);
+
+        // no buffer view means all zeros
+        if (accessor.View < 0)
+        {
+            std::fill(out.begin(), out.end(), Vec(0.0f));
+            return true;
+        }
+
+        size_t stride;
+        const char* data = GetElements(context, accessor, stride);
+        if (!data)
+            return false;
+
+        if (accessor.ComponentType == Float && accessor.Components == components && stride == sizeof(Vec))
+        {
+            memcpy(out.data(), data, accessor.Count * sizeof(Vec));
+            return true;
+        }
+
+        uint32_t count = std::min(components, accessor.Components);
+        uint32_t size = ComponentSize(accessor.ComponentType);
+        for (size_t i = 0; i < accessor.Count; ++i)
+        {
+            const char* element = data + i * stride;
+            for (uint32_t c = 0; c < count; ++c)
+                out[i][c] = ReadComponent(element + c * size, accessor.ComponentType, accessor.Normalized);
+        }
+        return true;
+    }
+
+    static bool ReadIndexes(const GltfContext& context, int index, std::vector<uint32_t>& out)
+    {
+        if (index < 0 || index >= (int)context.Accessors.size())
+            return false;
+
+        const GltfAccessor& accessor = context.Accessors[index];
+        size_t stride;
+        const char* data = GetElements(context, accessor, stride);
+        if (!data || accessor.Components != 1)
+            return false;
+
+        out.resize(accessor.Count);
+        switch (accessor.ComponentType)
+        {
+            case UnsignedInt:
+                if (stride == sizeof(uint32_t))
+                {
+                    memcpy(out.data(), data, accessor.Count * sizeof(uint32_t));
+                    return true;
+                }
+                // fallthrough
+            case UnsignedShort:
+            case UnsignedByte:
+                for (size_t i = 0; i < accessor.Count; ++i)
+                    out[i] = (uint32_t)ReadComponent(data + i * stride, accessor.ComponentType, false);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // True when positions and normals are interleaved float vec3 pairs in
+    // one buffer view, which is the layout of Mesh::Vertices
+    static bool IsInterleaved(const GltfContext& context, int position, int normal)
+    {
+        if (position < 0 || normal < 0 || position >= (int)context.Accessors.size() || normal >= (int)context.Accessors.size())
+            return false;
+
+        const GltfAccessor& p = context.Accessors[position];
+        const GltfAccessor& n = context.Accessors[normal];
+        if (p.View < 0 || p.View != n.View || p.Count != n.Count || n.Offset != p.Offset + sizeof(glm::vec3))
+            return false;
+        if (p.ComponentType != Float || n.ComponentType != Float || p.Components != 3 || n.Components != 3)
+            return false;
+
+        size_t stride;
+        return context.Views[p.View].Stride == 2 * sizeof(glm::vec3)
+            && GetElements(context, p, stride) && GetElements(context, n, stride);
+    }
+
+    // Turns strips and fans into a triangle list
+    static void ToTriangles(uint32_t mode, std::vector<uint32_t>& indexes)
+    {
+        if (mode == Triangles || indexes.size() < 3)
+        {
+            indexes.resize(indexes.size() - indexes.size() % 3);
+            return;
+        }
+
+        std::vector<uint32_t> triangles;
+        triangles.reserve((indexes.size() - 2) * 3);
+        for (size_t i = 2; i < indexes.size(); ++i)
+        {
+            if (mode == TriangleFan)
+                triangles.insert(triangles.end(), { indexes[0], indexes[i - 1], indexes[i] });
+            else if (i % 2 == 0)
+                triangles.insert(triangles.end(), { indexes[i - 2], indexes[i - 1], indexes[i] });
+            else
+                triangles.insert(triangles.end(), { indexes[i - 1], indexes[i - 2], indexes[i] });
+        }
+        indexes = std::move(triangles);
+    }
+
+    static bool DecodePrimitive(const GltfContext& context, GltfPrimitive& primitive)
+    {
+        Ref<Mesh> mesh = Mesh::Create();
+        std::vector<glm::vec3>& positions = *mesh->Vertex;
+        std::vector<glm::vec3>& vertices = *mesh->Vertices;
+        std::vector<uint32_t>& indexes = *mesh->Indexes;
+
+        if (!ReadFloats(context, primitive.Position, positions) || positions.empty())
+            return false;
+
+        size_t count = positions.size();
+        if (primitive.Indices >= 0)
+        {
+            if (!ReadIndexes(context, primitive.Indices, indexes))
+                return false;
+        }
+        else
+        {
+            indexes.resize(count);
+            for (size_t i = 0; i < count; ++i)
+                indexes[i] = (uint32_t)i;
+        }
+
+        ToTriangles(primitive.Mode, indexes);
+        if (!std::all_of(indexes.begin(), indexes.end(), [count](uint32_t idx) { return idx < count; }))
+            return false;
+
+        if (IsInterleaved(context, primitive.Position, primitive.Normal))
+        {
+            // already laid out like Mesh::Vertices, one copy from the buffer
+            size_t stride;
+            const char* data = GetElements(context, context.Accessors[primitive.Position], stride);
+            vertices.resize(count * 2);
+            memcpy(vertices.data(), data, count * 2 * sizeof(glm::vec3));
+        }
+        else
+        {
+            std::vector<glm::vec3> normals;
+            if (primitive.Normal < 0 || !ReadFloats(context, primitive.Normal, normals) || normals.size() != count)
+                NormalGenerator::Generate(positions.data(), count, indexes.data(), indexes.size(), context.Options.Normals, normals, &ThreadPool::Get());
+
+            vertices.resize(count * 2);
+            for (size_t i = 0; i < count; ++i)
+            {
+                vertices[i * 2] = positions[i];
+                vertices[i * 2 + 1] = normals[i];
+            }
+        }
+        *mesh->Normals = vertices;
+
+        if (primitive.TexCoord >= 0 && (!ReadFloats(context, primitive.TexCoord, *mesh->TexCoords) || mesh->TexCoords->size() != count))
+            mesh->TexCoords->clear();
+        if (primitive.Color >= 0 && (!ReadFloats(context, primitive.Color, *mesh->Colors, glm::vec4(1.0f)) || mesh->Colors->size() != count))
+            mesh->Colors->clear();
+
+        *mesh->BoundingBox = GetExtents(positions.data(), sizeof(glm::vec3), count);
+        primitive.Mesh_ = mesh;
+        return true;
+    }
+
+    static int HexDigit(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Percent escapes decoded, a '%' not followed by two hex digits is kept
+    static std::string DecodeUri(const std::string& uri)
+    {
+        std::string decoded;
+        for (size_t i = 0; i < uri.size(); ++i)
+        {
+            int high = uri[i] == '%' && i + 2 < uri.size() ? HexDigit(uri[i + 1]) : -1;
+            int low = high >= 0 ? HexDigit(uri[i + 2]) : -1;
+            if (low >= 0)
+            {
+                decoded.push_back((char)(high * 16 + low));
+                i += 2;
+            }
+            else
+            {
+                decoded.push_back(uri[i]);
+            }
+        }
+        return decoded;
+    }
+
+    static bool DecodeBase64(const char* begin, const char* end, std::vector<char>& out)
+    {
+        auto value = [](char c) -> int {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+') return 62;
+            if (c == '/') return 63;
+            return -1;
+        };
+
+        out.reserve((end - begin) / 4 * 3);
+        uint32_t bits = 0;
+        int count = 0;
+        for (const char* c = begin; c < end && *c != '='; ++c)
+        {
+            int v = value(*c);
+            if (v < 0)
+                return false;
+
+            bits = (bits << 6) | (uint32_t)v;
+            if (++count == 4)
+            {
+                out.push_back((char)(bits >> 16));
+                out.push_back((char)(bits >> 8));
+                out.push_back((char)bits);
+                bits = 0;
+                count = 0;
+            }
+        }
+
+        if (count == 2)
+            out.push_back((char)(bits >> 4));
+        else if (count == 3)
+        {
+            out.push_back((char)(bits >> 10));
+            out.push_back((char)(bits >> 2));
+        }
+        return true;
+    }
+
+    static bool LoadBuffers(GltfContext& context, const YAML::Node& root, const char* glbData, size_t glbSize)
+    {
+        std::filesystem::path parent = std::filesystem::path(context.Path.c_str()).parent_path();
+
+        for (const auto& node : root["buffers"])
+        {
+            GltfBuffer& buffer = context.Buffers.emplace_back();
+            size_t length = node["byteLength"].as<size_t>(0);
+            std::string uri = node["uri"].as<std::string>("");
+
+            if (uri.empty())
+            {
+                // the BIN chunk of a glb
+                buffer.Data = glbData;
+                buffer.Size = glbSize;
+            }
+            else if (uri.compare(0, 5, "data:") == 0)
+            {
+                size_t comma = uri.find(";base64,");
+                if (comma == std::string::npos || !DecodeBase64(uri.data() + comma + 8, uri.data() + uri.size(), buffer.Decoded))
+                {
+                    LOG_ERROR("Unsupported data uri in '%s'", context.Path.c_str());
+                    return false;
+                }
+                buffer.Data = buffer.Decoded.data();
+                buffer.Size = buffer.Decoded.size();
+            }
+            else
+            {
+                std::string path = (parent / DecodeUri(uri)).u8string();
+                buffer.File = MappedFile::Create(path);
+                if (!buffer.File->IsValid())
+                {
+                    LOG_ERROR("Could not open buffer '%s'", path.c_str());
+                    return false;
+                }
+                buffer.Data = buffer.File->Data();
+                buffer.Size = buffer.File->Size();
+
+                if (context.Progress)
+                {
+                    context.Progress->BytesTotal += buffer.Size;
+                    context.Progress->BytesRead += buffer.Size;
+                }
+            }
+
+            if (buffer.Size < length)
+            {
+                LOG_ERROR("Buffer %zu of '%s' is too short", context.Buffers.size() - 1, context.Path.c_str());
+                return false;
+            }
+            buffer.Size = length;
+        }
+
+        return true;
+    }
+
+    static void LoadDocument(GltfContext& context, const YAML::Node& root, ImportResult& result)
+    {
+        for (const auto& node : root["bufferViews"])
+        {
+            GltfBufferView& view = context.Views.emplace_back();
+            view.Buffer = node["buffer"].as<uint32_t>(UINT32_MAX);
+            view.Offset = node["byteOffset"].as<size_t>(0);
+            view.Length = node["byteLength"].as<size_t>(0);
+            view.Stride = node["byteStride"].as<uint32_t>(0);
+        }
+
+        for (const auto& node : root["accessors"])
+        {
+            GltfAccessor& accessor = context.Accessors.emplace_back();
+            accessor.View = node["bufferView"].as<int>(-1);
+            accessor.Offset = node["byteOffset"].as<size_t>(0);
+            accessor.ComponentType = node["componentType"].as<uint32_t>(0);
+            accessor.Components = ComponentCount(node["type"].as<std::string>(""));
+            accessor.Count = node["count"].as<size_t>(0);
+            accessor.Normalized = node["normalized"].as<bool>(false);
+
+            if (node["sparse"])
+            {
+                LOG_WARN("Sparse accessors are not supported, '%s' may look wrong", context.Path.c_str());
+            }
+        }
+
+        for (const auto& node : root["materials"])
+        {
+            Ref<Material> material = CreateRef<Material>();
+            material->Name = node["name"].as<std::string>("");
+            material->Diffuse = glm::vec3(1.0f);
+
+            const YAML::Node pbr = node["pbrMetallicRoughness"];
+            const YAML::Node factor = pbr ? pbr["baseColorFactor"] : YAML::Node();
+            if (factor && factor.size() >= 3)
+                material->Diffuse = glm::vec3(factor[0].as<float>(1.0f), factor[1].as<float>(1.0f), factor[2].as<float>(1.0f));
+            // Alpha is ignored unless the material asks for blending
+            if (factor && factor.size() >= 4 && node["alphaMode"].as<std::string>("OPAQUE") == "BLEND")
+                material->Opacity = factor[3].as<float>(1.0f);
+
+            // names are optional and not unique
+            std::string key = material->Name.empty() ? "material_" + std::to_string(context.Materials.size()) : material->Name;
+            if (result.Materials.count(key))
+                key += "_" + std::to_string(context.Materials.size());
+            if (material->Name.empty())
+                material->Name = key;
+
+            result.Materials[key] = material;
+            context.Materials.push_back(key);
+        }
+
+        for (const auto& node : root["meshes"])
+        {
+            GltfMesh& mesh = context.Meshes.emplace_back();
+            mesh.Name = node["name"].as<std::string>("");
+
+            for (const auto& entry : node["primitives"])
+            {
+                GltfPrimitive& primitive = mesh.Primitives.emplace_back();
+                const YAML::Node attributes = entry["attributes"];
+                primitive.Position = attributes["POSITION"].as<int>(-1);
+                primitive.Normal = attributes["NORMAL"].as<int>(-1);
+                primitive.TexCoord = attributes["TEXCOORD_0"].as<int>(-1);
+                primitive.Color = attributes["COLOR_0"].as<int>(-1);
+                primitive.Indices = entry["indices"].as<int>(-1);
+                primitive.Material = entry["material"].as<int>(-1);
+                primitive.Mode = entry["mode"].as<uint32_t>(Triangles);
+            }
+        }
+    }
+
+    static glm::mat4 GetLocalTransform(const YAML::Node& node)
+    {
+        const YAML::Node matrix = node["matrix"];
+        if (matrix && matrix.size() == 16)
+        {
+            float values[16];
+            for (size_t i = 0; i < 16; ++i)
+                values[i] = matrix[i].as<float>(0.0f);
+            return glm::make_mat4(values);
+        }
+
+        glm::vec3 translation(0.0f), scale(1.0f);
+        glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+
+        const YAML::Node t = node["translation"], r = node["rotation"], s = node["scale"];
+        if (t && t.size() == 3)
+            translation = glm::vec3(t[0].as<float>(0.0f), t[1].as<float>(0.0f), t[2].as<float>(0.0f));
+        if (r && r.size() == 4)
+            rotation = glm::quat(r[3].as<float>(1.0f), r[0].as<float>(0.0f), r[1].as<float>(0.0f), r[2].as<float>(0.0f));
+        if (s && s.size() == 3)
+            scale = glm::vec3(s[0].as<float>(1.0f), s[1].as<float>(1.0f), s[2].as<float>(1.0f));
+
+        return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+    }
+
+    // Flattens the node tree of the default scene into one instance per
+    // node with a mesh, carrying its world transform
+    static void LoadNodes(GltfContext& context, const YAML::Node& root)
+    {
+        const YAML::Node nodes = root["nodes"];
+        size_t nodeCount = nodes ? nodes.size() : 0;
+
+        std::vector<uint32_t> roots;
+        const YAML::Node scenes = root["scenes"];
+        if (scenes && scenes.size())
+        {
+            size_t scene = root["scene"].as<size_t>(0);
+            for (const auto& node : scenes[scene < scenes.size() ? scene : 0]["nodes"])
+                roots.push_back(node.as<uint32_t>(UINT32_MAX));
+        }
+        else
+        {
+            // no scene, so every node that is nobody's child is a root
+            std::vector<bool> child(nodeCount, false);
+            for (const auto& node : nodes)
+                for (const auto& index : node["children"])
+                    if (index.as<size_t>(SIZE_MAX) < nodeCount)
+                        child[index.as<size_t>()] = true;
+            for (size_t i = 0; i < nodeCount; ++i)
+                if (!child[i])
+                    roots.push_back((uint32_t)i);
+        }
+
+        // Iterative walk, visiting every node at most once so a malformed
+        // file with cycles terminates
+        std::vector<bool> visited(nodeCount, false);
+        std::vector<std::pair<uint32_t, glm::mat4>> stack;
+        for (auto it = roots.rbegin(); it != roots.rend(); ++it)
+            stack.emplace_back(*it, glm::mat4(1.0f));
+
+        while (!stack.empty())
+        {
+            auto [index, parent] = stack.back();
+            stack.pop_back();
+            if (index >= nodeCount || visited[index])
+                continue;
+            visited[index] = true;
+
+            const YAML::Node node = nodes[index];
+            glm::mat4 transform = parent * GetLocalTransform(node);
+
+            uint32_t mesh = node["mesh"].as<uint32_t>(UINT32_MAX);
+            if (mesh < context.Meshes.size())
+            {
+                std::string name = node["name"].as<std::string>("");
+                if (name.empty())
+                    name = context.Meshes[mesh].Name;
+                if (name.empty())
+                    name = "node_" + std::to_string(index);
+
+                context.Instances.push_back({ mesh, name, transform });
+                context.Meshes[mesh].Used = true;
+            }
+
+            const YAML::Node children = node["children"];
+            for (size_t i = children ? children.size() : 0; i-- > 0;)
+                stack.emplace_back(children[i].as<uint32_t>(UINT32_MAX), transform);
+        }
+
+        // Files with meshes but no nodes still show them
+        if (context.Instances.empty())
+        {
+            for (uint32_t mesh = 0; mesh < context.Meshes.size(); ++mesh)
+            {
+                std::string name = context.Meshes[mesh].Name.empty() ? "mesh_" + std::to_string(mesh) : context.Meshes[mesh].Name;
+                context.Instances.push_back({ mesh, name, glm::mat4(1.0f) });
+                context.Meshes[mesh].Used = true;
+            }
+        }
+    }
+
+    // Splits an affine transform into what TransformComponent holds, shear
+    // is lost
+    static void Decompose(const glm::mat4& transform, MeshNode& node)
+    {
+        node.Translation = glm::vec3(transform[3]);
+
+        glm::mat3 rotation(transform);
+        for (int c = 0; c < 3; ++c)
+            node.Scale[c] = glm::length(rotation[c]);
+        if (glm::determinant(rotation) < 0.0f)
+            node.Scale.x = -node.Scale.x;
+
+        for (int c = 0; c < 3; ++c)
+        {
+            if (node.Scale[c] != 0.0f)
+                rotation[c] /= node.Scale[c];
+        }
+        node.Rotation = glm::eulerAngles(glm::quat_cast(rotation));
+    }
+
+    bool GltfLoader::Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress)
+    {
+        std::filesystem::path filepath = path.c_str();
+        std::string filename = filepath.filename().u8string();
+
+        GltfContext context;
+        context.Path = path;
+        context.Options = options;
+        context.Progress = progress;
+
+        Ref<MappedFile> file = MappedFile::Create(path);
+        if (!file->IsValid())
+        {
+            LOG_ERROR("Could not open gltf file '%s'", filepath.u8string().c_str());
+            return false;
+        }
+
+        if (progress)
+            progress->BytesTotal += file->Size();
+
+        // A glb holds the json and the first buffer in chunks of one file,
+        // a gltf is json only
+        const char* json = file->Data();
+        size_t jsonSize = file->Size();
+        const char* bin = nullptr;
+        size_t binSize = 0;
+
+        uint32_t header[3] = {};
+        if (file->Size() >= sizeof(header))
+            memcpy(header, file->Data(), sizeof(header));
+
+        if (header[0] == s_GlbMagic)
+        {
+            json = nullptr;
+            size_t offset = sizeof(header);
+            size_t size = std::min<size_t>(header[2], file->Size());
+            while (offset + 8 <= size)
+            {
+                uint32_t chunk[2];
+                memcpy(chunk, file->Data() + offset, sizeof(chunk));
+                offset += sizeof(chunk);
+                if (chunk[0] > size - offset)
+                    break;
+
+                if (chunk[1] == s_JsonChunk && !json)
+                {
+                    json = file->Data() + offset;
+                    jsonSize = chunk[0];
+                }
+                else if (chunk[1] == s_BinChunk && !bin)
+                {
+                    bin = file->Data() + offset;
+                    binSize = chunk[0];
+                }
+                offset += (chunk[0] + 3) & ~3u;
+            }
+
+            if (header[1] != 2 || !json)
+            {
+                LOG_ERROR("Unsupported glb file '%s'", filename.c_str());
+                return false;
+            }
+        }
+
+        YAML::Node root;
+        try
+        {
+            // json is a subset of yaml
+            root = YAML::Load(std::string(json, jsonSize));
+        }
+        catch (const YAML::Exception& e)
+        {
+            LOG_ERROR("Could not parse '%s': %s", filename.c_str(), e.what());
+            return false;
+        }
+
+        try
+        {
+            std::string version = root["asset"]["version"].as<std::string>("");
+            if (version.compare(0, 2, "2.") != 0)
+            {
+                LOG_ERROR("Unsupported gltf version '%s' in '%s'", version.c_str(), filename.c_str());
+                return false;
+            }
+
+            if (!LoadBuffers(context, root, bin, binSize))
+                return false;
+
+            LoadDocument(context, root, result);
+            LoadNodes(context, root);
+        }
+        catch (const YAML::Exception& e)
+        {
+            LOG_ERROR("Invalid gltf file '%s': %s", filename.c_str(), e.what());
+            return false;
+        }
+
+        if (progress)
+        {
+            progress->BytesRead += file->Size();
+            progress->Stage = ImportStage::Processing;
+        }
+
+        // Primitives decode independently, and only the ones in use
+        std::vector<GltfPrimitive*> primitives;
+        for (auto& mesh : context.Meshes)
+        {
+            if (!mesh.Used)
+                continue;
+
+            for (auto& primitive : mesh.Primitives)
+            {
+                if (primitive.Mode == Triangles || primitive.Mode == TriangleStrip || primitive.Mode == TriangleFan)
+                    primitives.push_back(&primitive);
+            }
+        }
+
+        std::atomic<size_t> failed{ 0 };
+        ThreadPool::Get().ParallelFor(primitives.size(), [&](size_t i) {
+            if (context.IsCancelled())
+                return;
+
+            if (!DecodePrimitive(context, *primitives[i]))
+                failed++;
+            else if (progress)
+                progress->Triangles += primitives[i]->Mesh_->Indexes->size() / 3;
+        });
+
+        if (context.IsCancelled())
+            return false;
+        if (failed)
+        {
+            LOG_WARN("Skipped %zu primitives of '%s' with invalid data", failed.load(), filename.c_str());
+        }
+
+        // Fit the whole scene in a unit box like the other loaders do, but
+        // through the transforms, since instances share their vertices
+        glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+        for (const auto& instance : context.Instances)
+        {
+            for (const auto& primitive : context.Meshes[instance.Mesh].Primitives)
+            {
+                if (!primitive.Mesh_)
+                    continue;
+
+                const auto& box = *primitive.Mesh_->BoundingBox;
+                for (int corner = 0; corner < 8; ++corner)
+                {
+                    glm::vec3 point((corner & 1) ? box.second.x : box.first.x, (corner & 2) ? box.second.y : box.first.y, (corner & 4) ? box.second.z : box.first.z);
+                    glm::vec3 world = glm::vec3(instance.Transform * glm::vec4(point, 1.0f));
+                    min = glm::min(min, world);
+                    max = glm::max(max, world);
+                }
+            }
+        }
+
+        if (min.x > max.x)
+        {
+            LOG_ERROR("No triangles found in gltf file '%s'", filename.c_str());
+            return false;
+        }
+
+        float extent = glm::compMax(max - min);
+        glm::mat4 fit = glm::scale(glm::mat4(1.0f), glm::vec3(extent > 0.0f ? 1.0f / extent : 1.0f))
+            * glm::translate(glm::mat4(1.0f), -(min + max) * 0.5f);
+
+        size_t meshes = 0;
+        for (const auto& instance : context.Instances)
+        {
+            const GltfMesh& mesh = context.Meshes[instance.Mesh];
+            for (size_t i = 0; i < mesh.Primitives.size(); ++i)
+            {
+                const GltfPrimitive& primitive = mesh.Primitives[i];
+                if (!primitive.Mesh_)
+                    continue;
+
+                Ref<MeshNode> node = CreateRef<MeshNode>();
+                node->Mesh_ = primitive.Mesh_;
+                node->Name = mesh.Primitives.size() > 1 ? instance.Name + "_" + std::to_string(i) : instance.Name;
+                if (primitive.Material >= 0 && primitive.Material < (int)context.Materials.size())
+                    node->Material_ = context.Materials[primitive.Material];
+                Decompose(fit * instance.Transform, *node);
+                result.Meshes.push_back(node);
+            }
+        }
+
+        for (const auto& primitive : primitives)
+            meshes += primitive->Mesh_ != nullptr;
+
+        result.Path = path;
+        LOG_INFO("Imported '%s': %zu meshes, %zu instances", filename.c_str(), meshes, result.Meshes.size());
+        return true;
+    }
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Base.h"
+#include "ImportOptions.h"
+#include "ImportData.h"
+#include <Core/Scene/Scene.h>
+
+namespace GLMV {
+
+    // glTF 2.0 files, both .gltf with external or embedded buffers and
+    // binary .glb. Every triangle primitive becomes one Mesh, and every node
+    // that uses it one entity with the node's world transform, so instances
+    // share their geometry.
+    class GltfLoader
+    {
+        public:
+            // Reads the file without touching the scene, so it can run on a
+            // worker thread
+            static bool Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress = nullptr);
+    };
+}
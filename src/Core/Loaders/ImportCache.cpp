@@ -0,0 +1,454 @@
+#include "ImportCache.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace GLMV {
+
+    std::string ImportCache::s_Directory = ".glmvcache";
+    uint64_t ImportCache::s_Capacity = 2ull * 1024 * 1024 * 1024;
+    ImportCacheStats ImportCache::s_Stats;
+    std::mutex ImportCache::s_Mutex;
+
+    // Bump when the layout or the processing that produced the data changes
+    static constexpr uint32_t s_CacheVersion = 4;
+    static constexpr char s_CacheMagic[8] = { 'G', 'L', 'M', 'V', 'C', 'A', 'C', 'H' };
+    static constexpr uint64_t s_Alignment = 16;
+
+    // File layout: header, mesh records, material records, dependency
+    // records, string table, then every stream 16 byte aligned. Offsets are from the file start,
+    // so a mapped entry can be read in place.
+    struct CacheHeader
+    {
+        char Magic[8];
+        uint32_t Version;
+        uint32_t MeshCount;
+        uint32_t MaterialCount;
+        uint32_t DependencyCount;
+        uint64_t Key;
+        uint64_t StringsOffset;
+        uint64_t StringsSize;
+    };
+
+    struct CacheMesh
+    {
+        uint32_t NameOffset, NameSize;
+        uint32_t MaterialOffset, MaterialSize;
+        float BoundsMin[3], BoundsMax[3];
+        uint64_t VerticesOffset, VerticesCount;
+        uint64_t IndexesOffset, IndexesCount;
+        uint64_t TexCoordsOffset, TexCoordsCount;
+    };
+
+    struct CacheMaterial
+    {
+        uint32_t NameOffset, NameSize;
+        float Diffuse[3];
+        float Opacity;
+    };
+
+    // Another file the entry was produced from, as it was when stored
+    struct CacheDependency
+    {
+        uint32_t PathOffset, PathSize;
+        int64_t Time;
+        uint64_t Size;
+    };
+
+    // Size of a file that does not exist
+    static constexpr uint64_t s_Missing = ~0ull;
+
+    static void GetFileState(const std::string& path, int64_t& time, uint64_t& size)
+    {
+        std::error_code error;
+        auto modified = std::filesystem::last_write_time(path, error);
+        uint64_t bytes = error ? 0 : std::filesystem::file_size(path, error);
+        time = error ? 0 : (int64_t)modified.time_since_epoch().count();
+        size = error ? s_Missing : bytes;
+    }
+
+    static uint64_t Mix(uint64_t hash, uint64_t value)
+    {
+        hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        return hash * 0xff51afd7ed558ccdull;
+    }
+
+    static uint64_t HashBytes(const char* data, size_t size, uint64_t hash = 0)
+    {
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            hash = Mix(hash, word);
+        }
+        for (; i < size; ++i)
+            hash = Mix(hash, (uint8_t)data[i]);
+        return hash;
+    }
+
+    // Hashes the head, the tail and evenly spaced blocks in between, so the
+    // cost stays flat on multi-GB files. Size and mtime catch the rest.
+    static uint64_t SampleHash(const MappedFile& file)
+    {
+        const size_t block = 4096, samples = 256;
+        uint64_t hash = file.Size();
+
+        if (file.Size() <= block * samples)
+            return HashBytes(file.Data(), file.Size(), hash);
+
+        size_t step = (file.Size() - block) / (samples - 1);
+        for (size_t i = 0; i < samples; ++i)
+            hash = HashBytes(file.Data() + i * step, block, hash);
+        return hash;
+    }
+
+    static bool CacheKey(const std::string& path, const ImportOptions& options, std::filesystem::path& entry, uint64_t& key)
+    {
+        std::error_code error;
+        std::filesystem::path source = std::filesystem::canonical(path, error);
+        if (error)
+            return false;
+
+        auto time = std::filesystem::last_write_time(source, error);
+        if (error)
+            return false;
+
+        Ref<MappedFile> file = MappedFile::Create(source.u8string());
+        if (!file->IsValid())
+            return false;
+
+        std::string name = source.u8string();
+        key = HashBytes(name.data(), name.size());
+        key = Mix(key, (uint64_t)time.time_since_epoch().count());
+        key = Mix(key, file->Size());
+        key = Mix(key, SampleHash(*file));
+        key = Mix(key, s_CacheVersion);
+        key = Mix(key, options.WeldVertices);
+        uint32_t epsilon;
+        memcpy(&epsilon, &options.WeldEpsilon, sizeof(epsilon));
+        key = Mix(key, epsilon);
+        key = Mix(key, (uint64_t)options.Normals);
+        key = Mix(key, (uint64_t)options.ObjBackend);
+
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key);
+        entry = std::filesystem::path(hex).replace_extension(".glmv");
+        return true;
+    }
+
+    bool ImportCache::GetKey(const std::string& path, const ImportOptions& options, uint64_t& key)
+    {
+        std::filesystem::path name;
+        return CacheKey(path, options, name, key);
+    }
+
+    bool ImportCache::Load(const std::string& path, const ImportOptions& options, std::vector<Ref<MeshNode>>& meshes, MaterialMap& materials,
+        std::vector<std::string>& dependencies)
+    {
+        std::filesystem::path name;
+        uint64_t key;
+        if (!CacheKey(path, options, name, key))
+            return false;
+
+        std::filesystem::path entry = std::filesystem::path(s_Directory) / name;
+        Ref<MappedFile> file = MappedFile::Create(entry.u8string());
+        if (!file->IsValid() || file->Size() < sizeof(CacheHeader))
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Stats.Misses++;
+            return false;
+        }
+
+        const char* data = file->Data();
+        const uint64_t size = file->Size();
+        auto inside = [size](uint64_t offset, uint64_t bytes) { return offset <= size && bytes <= size - offset; };
+
+        CacheHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.Magic, s_CacheMagic, sizeof(s_CacheMagic)) != 0 || header.Version != s_CacheVersion || header.Key != key
+            || !inside(sizeof(CacheHeader), (uint64_t)header.MeshCount * sizeof(CacheMesh) + (uint64_t)header.MaterialCount * sizeof(CacheMaterial)
+                + (uint64_t)header.DependencyCount * sizeof(CacheDependency))
+            || !inside(header.StringsOffset, header.StringsSize))
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Stats.Misses++;
+            return false;
+        }
+
+        const char* strings = data + header.StringsOffset;
+        auto string = [&](uint32_t offset, uint32_t bytes) {
+            return offset + (uint64_t)bytes <= header.StringsSize ? std::string(strings + offset, bytes) : std::string();
+        };
+
+        // Stale once any file it was produced from changed, appeared or went away
+        const char* records = data + sizeof(CacheHeader) + header.MeshCount * sizeof(CacheMesh) + header.MaterialCount * sizeof(CacheMaterial);
+        std::vector<std::string> loadedDependencies;
+        for (uint32_t i = 0; i < header.DependencyCount; ++i)
+        {
+            CacheDependency record;
+            memcpy(&record, records + i * sizeof(CacheDependency), sizeof(record));
+
+            int64_t time;
+            uint64_t bytes;
+            std::string dependency = string(record.PathOffset, record.PathSize);
+            GetFileState(dependency, time, bytes);
+            if (bytes != record.Size || (bytes != s_Missing && time != record.Time))
+            {
+                std::lock_guard<std::mutex> lock(s_Mutex);
+                s_Stats.Misses++;
+                return false;
+            }
+            loadedDependencies.push_back(dependency);
+        }
+
+        records = data + sizeof(CacheHeader);
+        std::vector<Ref<MeshNode>> loaded;
+        for (uint32_t i = 0; i < header.MeshCount; ++i)
+        {
+            CacheMesh record;
+            memcpy(&record, records + i * sizeof(CacheMesh), sizeof(record));
+            if (!inside(record.VerticesOffset, record.VerticesCount * sizeof(glm::vec3)) || !inside(record.IndexesOffset, record.IndexesCount * sizeof(uint32_t))
+                || !inside(record.TexCoordsOffset, record.TexCoordsCount * sizeof(glm::vec2)))
+            {
+                std::lock_guard<std::mutex> lock(s_Mutex);
+                s_Stats.Misses++;
+                return false;
+            }
+
+            Ref<MeshNode> node = CreateRef<MeshNode>();
+            node->Name = string(record.NameOffset, record.NameSize);
+            node->Material_ = string(record.MaterialOffset, record.MaterialSize);
+            node->Mesh_ = Mesh::Create();
+
+            const glm::vec3* vertices = (const glm::vec3*)(data + record.VerticesOffset);
+            const uint32_t* indexes = (const uint32_t*)(data + record.IndexesOffset);
+            Ref<Mesh>& mesh = node->Mesh_;
+            mesh->Vertices->assign(vertices, vertices + record.VerticesCount);
+            mesh->Indexes->assign(indexes, indexes + record.IndexesCount);
+            const glm::vec2* texCoords = (const glm::vec2*)(data + record.TexCoordsOffset);
+            mesh->TexCoords->assign(texCoords, texCoords + record.TexCoordsCount);
+
+            // position and position/normal streams are derived from the interleaved one
+            size_t count = record.VerticesCount / 2;
+            mesh->Vertex->resize(count);
+            for (size_t v = 0; v < count; ++v)
+                (*mesh->Vertex)[v] = vertices[v * 2];
+            *mesh->Normals = *mesh->Vertices;
+
+            mesh->BoundingBox->first = { record.BoundsMin[0], record.BoundsMin[1], record.BoundsMin[2] };
+            mesh->BoundingBox->second = { record.BoundsMax[0], record.BoundsMax[1], record.BoundsMax[2] };
+            loaded.push_back(node);
+        }
+
+        records += header.MeshCount * sizeof(CacheMesh);
+        MaterialMap loadedMaterials;
+        for (uint32_t i = 0; i < header.MaterialCount; ++i)
+        {
+            CacheMaterial record;
+            memcpy(&record, records + i * sizeof(CacheMaterial), sizeof(record));
+
+            Ref<Material> material = CreateRef<Material>();
+            material->Name = string(record.NameOffset, record.NameSize);
+            material->Diffuse = { record.Diffuse[0], record.Diffuse[1], record.Diffuse[2] };
+            material->Opacity = record.Opacity;
+            loadedMaterials[material->Name] = material;
+        }
+
+        meshes = std::move(loaded);
+        materials = std::move(loadedMaterials);
+        dependencies = std::move(loadedDependencies);
+
+        // Mark it as recently used
+        std::error_code error;
+        std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), error);
+
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_Stats.Hits++;
+        s_Stats.BytesRead += size;
+        return true;
+    }
+
+    void ImportCache::Store(const std::string& path, const ImportOptions& options, const std::vector<Ref<MeshNode>>& meshes, const MaterialMap& materials,
+        const std::vector<std::string>& dependencies)
+    {
+        std::filesystem::path name;
+        uint64_t key;
+        if (!CacheKey(path, options, name, key))
+            return;
+
+        std::error_code error;
+        std::filesystem::create_directories(s_Directory, error);
+        if (error)
+        {
+            LOG_WARN("Could not create import cache directory '%s'", s_Directory.c_str());
+            return;
+        }
+
+        std::string strings;
+        auto addString = [&strings](const std::string& value, uint32_t& offset, uint32_t& size) {
+            offset = (uint32_t)strings.size();
+            size = (uint32_t)value.size();
+            strings += value;
+        };
+
+        auto align = [](uint64_t offset) { return (offset + s_Alignment - 1) & ~(s_Alignment - 1); };
+
+        std::vector<CacheMesh> meshRecords(meshes.size());
+        std::vector<CacheMaterial> materialRecords;
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            CacheMesh& record = meshRecords[i];
+            memset(&record, 0, sizeof(record));
+            addString(meshes[i]->Name, record.NameOffset, record.NameSize);
+            addString(meshes[i]->Material_, record.MaterialOffset, record.MaterialSize);
+
+            const auto& bounds = *meshes[i]->Mesh_->BoundingBox;
+            memcpy(record.BoundsMin, &bounds.first, sizeof(record.BoundsMin));
+            memcpy(record.BoundsMax, &bounds.second, sizeof(record.BoundsMax));
+            record.VerticesCount = meshes[i]->Mesh_->Vertices->size();
+            record.IndexesCount = meshes[i]->Mesh_->Indexes->size();
+            record.TexCoordsCount = meshes[i]->Mesh_->TexCoords->size();
+        }
+
+        for (const auto& [materialName, material] : materials)
+        {
+            CacheMaterial& record = materialRecords.emplace_back();
+            memset(&record, 0, sizeof(record));
+            addString(material->Name, record.NameOffset, record.NameSize);
+            memcpy(record.Diffuse, &material->Diffuse, sizeof(record.Diffuse));
+            record.Opacity = material->Opacity;
+        }
+
+        std::vector<CacheDependency> dependencyRecords(dependencies.size());
+        for (size_t i = 0; i < dependencies.size(); ++i)
+        {
+            CacheDependency& record = dependencyRecords[i];
+            addString(dependencies[i], record.PathOffset, record.PathSize);
+            GetFileState(dependencies[i], record.Time, record.Size);
+        }
+
+        CacheHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.Magic, s_CacheMagic, sizeof(s_CacheMagic));
+        header.Version = s_CacheVersion;
+        header.MeshCount = (uint32_t)meshRecords.size();
+        header.MaterialCount = (uint32_t)materialRecords.size();
+        header.DependencyCount = (uint32_t)dependencyRecords.size();
+        header.Key = key;
+        header.StringsOffset = sizeof(CacheHeader) + meshRecords.size() * sizeof(CacheMesh) + materialRecords.size() * sizeof(CacheMaterial)
+            + dependencyRecords.size() * sizeof(CacheDependency);
+        header.StringsSize = strings.size();
+
+        uint64_t offset = align(header.StringsOffset + header.StringsSize);
+        for (auto& record : meshRecords)
+        {
+            record.VerticesOffset = offset;
+            offset = align(offset + record.VerticesCount * sizeof(glm::vec3));
+            record.IndexesOffset = offset;
+            offset = align(offset + record.IndexesCount * sizeof(uint32_t));
+            record.TexCoordsOffset = offset;
+            offset = align(offset + record.TexCoordsCount * sizeof(glm::vec2));
+        }
+
+        // Written next to the entry and renamed, so readers never see half a file
+        std::filesystem::path entry = std::filesystem::path(s_Directory) / name;
+        // Unique per thread, two imports of the same file may race here
+        std::filesystem::path temporary = entry;
+        temporary += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+        std::ofstream out(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out)
+            return;
+
+        uint64_t written = 0;
+        auto write = [&](const void* data, uint64_t bytes) {
+            out.write((const char*)data, bytes);
+            written += bytes;
+        };
+        auto pad = [&]() {
+            static const char zeros[s_Alignment] = {};
+            write(zeros, align(written) - written);
+        };
+
+        write(&header, sizeof(header));
+        write(meshRecords.data(), meshRecords.size() * sizeof(CacheMesh));
+        write(materialRecords.data(), materialRecords.size() * sizeof(CacheMaterial));
+        write(dependencyRecords.data(), dependencyRecords.size() * sizeof(CacheDependency));
+        write(strings.data(), strings.size());
+        pad();
+        for (const auto& node : meshes)
+        {
+            write(node->Mesh_->Vertices->data(), node->Mesh_->Vertices->size() * sizeof(glm::vec3));
+            pad();
+            write(node->Mesh_->Indexes->data(), node->Mesh_->Indexes->size() * sizeof(uint32_t));
+            pad();
+            write(node->Mesh_->TexCoords->data(), node->Mesh_->TexCoords->size() * sizeof(glm::vec2));
+            pad();
+        }
+        out.close();
+
+        if (!out)
+        {
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+
+        std::filesystem::rename(temporary, entry, error);
+        if (error)
+        {
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_Stats.BytesWritten += written;
+        Evict();
+    }
+
+    void ImportCache::Evict()
+    {
+        struct CacheEntry
+        {
+            std::filesystem::path Path;
+            std::filesystem::file_time_type Time;
+            uint64_t Size;
+        };
+
+        std::error_code error;
+        std::vector<CacheEntry> entries;
+        uint64_t total = 0;
+        for (const auto& file : std::filesystem::directory_iterator(s_Directory, error))
+        {
+            if (!file.is_regular_file(error) || file.path().extension() != ".glmv")
+                continue;
+
+            CacheEntry& entry = entries.emplace_back();
+            entry.Path = file.path();
+            entry.Time = file.last_write_time(error);
+            entry.Size = file.file_size(error);
+            total += entry.Size;
+        }
+
+        if (total <= s_Capacity)
+            return;
+
+        std::sort(entries.begin(), entries.end(), [](const CacheEntry& a, const CacheEntry& b) { return a.Time < b.Time; });
+        for (const auto& entry : entries)
+        {
+            if (total <= s_Capacity)
+                break;
+
+            if (std::filesystem::remove(entry.Path, error))
+            {
+                total -= entry.Size;
+                s_Stats.Evictions++;
+            }
+        }
+    }
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Base.h"
+#include "ImportData.h"
+#include "ImportOptions.h"
+
+#include <mutex>
+
+namespace GLMV {
+
+    struct ImportCacheStats
+    {
+        uint32_t Hits = 0;
+        uint32_t Misses = 0;
+        uint32_t Evictions = 0;
+        uint64_t BytesRead = 0;
+        uint64_t BytesWritten = 0;
+    };
+
+    // On disk cache of processed imports, so opening the same file again
+    // skips parsing and mesh processing. Entries are keyed by the source
+    // path, modification time, size, a sampled content hash and the import
+    // options, and evicted least recently used first once the cache grows
+    // past its capacity. Other files the import read, such as mtl libraries,
+    // are stored with their own modification time and size, and an entry
+    // is only used while all of them are unchanged. Safe to use from
+    // several imports at once.
+    class ImportCache
+    {
+        public:
+            static bool Load(const std::string& path, const ImportOptions& options, std::vector<Ref<MeshNode>>& meshes, MaterialMap& materials,
+                std::vector<std::string>& dependencies);
+            static void Store(const std::string& path, const ImportOptions& options, const std::vector<Ref<MeshNode>>& meshes, const MaterialMap& materials,
+                const std::vector<std::string>& dependencies);
+
+            // Key of the entry a file would be stored under, for data kept
+            // next to the cache with the same lifetime rules
+            static bool GetKey(const std::string& path, const ImportOptions& options, uint64_t& key);
+
+            static const std::string& GetDirectory() { return s_Directory; }
+            static void SetDirectory(const std::string& directory) { s_Directory = directory; }
+            static void SetCapacity(uint64_t bytes) { s_Capacity = bytes; }
+
+            static ImportCacheStats GetStats() { std::lock_guard<std::mutex> lock(s_Mutex); return s_Stats; }
+        private:
+            static void Evict();
+
+            static std::string s_Directory;
+            static uint64_t s_Capacity;
+            static ImportCacheStats s_Stats;
+            static std::mutex s_Mutex;
+    };
+
+}
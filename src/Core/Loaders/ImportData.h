@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Renderer/Mesh.h"
+#include "Core/Geometry/MeshOptimizer.h"
+#include "Core/Geometry/VertexQuantizer.h"
+
+#include <atomic>
+
+namespace GLMV {
+
+    class ChunkStore;
+
+    struct Material
+    {
+        std::string Name;
+        glm::vec3 Diffuse;
+        // Alpha the renderer blends with, below 1 draws in the transparent pass
+        float Opacity = 1.0f;
+    };
+
+    // One entity worth of imported geometry. Instances of the same mesh
+    // share Mesh_ and differ in their transform.
+    struct MeshNode
+    {
+        Ref<Mesh> Mesh_;
+        std::string Material_;
+        std::string Name;
+
+        glm::vec3 Translation{ 0.0f };
+        glm::vec3 Rotation{ 0.0f };
+        glm::vec3 Scale{ 1.0f };
+
+        // Set by streaming imports: Mesh_ starts out empty and the scene
+        // pages the chunk in from the store
+        Ref<ChunkStore> Store;
+        uint32_t Chunk = 0;
+
+        // Set when ImportOptions::OptimizeVertexCache reordered the mesh
+        bool Optimized = false;
+        VertexCacheStats CacheBefore;
+        VertexCacheStats CacheAfter;
+
+        // Set when ImportOptions::GenerateLods simplified the mesh, coarsest last
+        std::vector<Ref<Mesh>> Lods;
+
+        // Mesh::Format given by ImportOptions::GpuFormat, and what it costs
+        VertexFormat Format = VertexFormat::Float;
+        QuantizationError Quantization;
+    };
+
+    using MaterialMap = std::unordered_map<std::string, Ref<Material>>;
+
+    // Everything a loader produced for one file, ready to become entities
+    struct ImportResult
+    {
+        std::string Path;
+        std::vector<Ref<MeshNode>> Meshes;
+        MaterialMap Materials;
+        // Other files read for it, missing ones included, like mtl libraries
+        std::vector<std::string> Dependencies;
+    };
+
+    enum class ImportStage
+    {
+        Reading = 0, Processing, Uploading, Done
+    };
+
+    // Shared between an import running on a worker and the UI thread
+    struct ImportProgress
+    {
+        std::atomic<uint64_t> BytesRead{ 0 };
+        std::atomic<uint64_t> BytesTotal{ 0 };
+        std::atomic<uint64_t> Triangles{ 0 };
+        // Set by batch imports
+        std::atomic<uint64_t> Files{ 0 };
+        std::atomic<uint64_t> FilesDone{ 0 };
+        std::atomic<ImportStage> Stage{ ImportStage::Reading };
+        std::atomic<bool> Cancel{ false };
+        // Set by the worker of an AsyncImporter once it returned
+        std::atomic<bool> Finished{ false };
+
+        bool IsCancelled() const { return Cancel.load(std::memory_order_relaxed); }
+    };
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Geometry/NormalGenerator.h"
+#include "Core/Renderer/Mesh.h"
+#include "ObjBackend.h"
+
+namespace GLMV {
+
+    // Mesh processing applied by the loaders after parsing
+    struct ImportOptions
+    {
+        // Parser used for obj files
+        ObjBackendType ObjBackend = ObjBackendType::Native;
+
+        // Share vertices with the same attributes instead of emitting one per face corner
+        bool WeldVertices = true;
+        // Merge positions closer than this before normals are generated, 0 disables it
+        float WeldEpsilon = 0.0f;
+        // How face normals are weighted when smoothing them into vertex normals
+        NormalWeighting Normals = NormalWeighting::Area;
+
+        // Reuse the processed result of a previous import of the same file
+        bool UseCache = true;
+
+        // Cut meshes with more vertices than 16 bit indexes reach into parts
+        // that do, each its own entity. Smaller meshes get 16 bit indexes
+        // on the GPU either way.
+        bool SplitLargeMeshes = false;
+
+        // Reorder triangles and vertices for the post transform vertex cache
+        // and vertex fetch after loading
+        bool OptimizeVertexCache = false;
+        // Also regroup the triangles so outward facing parts draw first,
+        // trading at most OverdrawThreshold times the optimized ACMR
+        bool OptimizeOverdraw = false;
+        float OverdrawThreshold = 1.05f;
+
+        // Build coarser versions of every mesh that the scene draws in its
+        // place when it covers little of the screen. Each level keeps about
+        // LodRatio of the triangles of the one before, 0.25 halves the
+        // resolution.
+        bool GenerateLods = false;
+        uint32_t LodLevels = 4;
+        float LodRatio = 0.25f;
+
+        // Split every mesh and LOD into meshlets that the scene culls
+        // against the view on their own
+        bool BuildMeshlets = false;
+
+        // Layout of positions and normals in GPU memory. The packed formats
+        // take half the bytes of Float for a small, logged, precision loss.
+        VertexFormat GpuFormat = VertexFormat::Float;
+
+        // Obj files from this size on are imported out of core: split into
+        // spatial chunks in a store on disk that the scene pages in as the
+        // camera needs them. 0 disables streaming.
+        uint64_t StreamThreshold = 2ull * 1024 * 1024 * 1024;
+        // Memory a streaming import may hold on to between its disk passes
+        uint64_t StreamMemory = 512ull * 1024 * 1024;
+        // Triangles a streamed chunk aims for
+        uint32_t ChunkTriangles = 1 << 20;
+    };
+
+}
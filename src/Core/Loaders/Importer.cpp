@@ -0,0 +1,272 @@
+#include "Importer.h"
+#include "Gltf.h"
+#include "Obj.h"
+#include "Ply.h"
+#include "Stl.h"
+
+#include "Core/Scene/Components.h"
+#include "Core/Geometry/MeshSimplifier.h"
+#include "Core/Geometry/MeshSplitter.h"
+#include "Core/Geometry/Meshlets.h"
+#include "Core/ThreadPool.h"
+
+#include <filesystem>
+
+namespace GLMV {
+
+    static std::string GetExtension(const std::string& path)
+    {
+        std::string extension = std::filesystem::path(path).extension().u8string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower(c); });
+        return extension;
+    }
+
+    // Replaces the nodes of meshes too large for 16 bit indexes with one
+    // node per part, instances keep sharing the parts
+    static void SplitMeshes(ImportResult& result)
+    {
+        std::vector<const Mesh*> meshes;
+        std::unordered_map<const Mesh*, size_t> slots;
+        for (const auto& node : result.Meshes)
+        {
+            if (node->Store || !node->Mesh_)
+                continue;
+            if (slots.emplace(node->Mesh_.get(), meshes.size()).second)
+                meshes.push_back(node->Mesh_.get());
+        }
+
+        std::vector<std::vector<Ref<Mesh>>> parts(meshes.size());
+        ThreadPool::Get().ParallelFor(meshes.size(), [&](size_t i)
+        {
+            parts[i] = MeshSplitter::Split(*meshes[i]);
+        });
+
+        std::vector<Ref<MeshNode>> nodes;
+        nodes.reserve(result.Meshes.size());
+        for (const auto& node : result.Meshes)
+        {
+            auto it = node->Mesh_ ? slots.find(node->Mesh_.get()) : slots.end();
+            if (it == slots.end() || parts[it->second].empty())
+            {
+                nodes.push_back(node);
+                continue;
+            }
+
+            const auto& split = parts[it->second];
+            for (size_t i = 0; i < split.size(); ++i)
+            {
+                Ref<MeshNode> part = CreateRef<MeshNode>(*node);
+                part->Mesh_ = split[i];
+                part->Name = node->Name + "_" + std::to_string(i);
+                nodes.push_back(part);
+            }
+        }
+
+        result.Meshes.swap(nodes);
+    }
+
+    // Optimizes every mesh of the result, builds its LOD chain and meshlets
+    // and sets its GPU vertex format, once per mesh as instances share theirs
+    static void PostProcess(ImportResult& result, const ImportOptions& options)
+    {
+        // First, so every part is optimized on its own
+        if (options.SplitLargeMeshes)
+            SplitMeshes(result);
+
+        std::vector<Mesh*> meshes;
+        std::unordered_map<const Mesh*, size_t> slots;
+        for (const auto& node : result.Meshes)
+        {
+            // Streamed chunks are empty until paged in
+            if (node->Store || !node->Mesh_)
+                continue;
+            if (slots.emplace(node->Mesh_.get(), meshes.size()).second)
+                meshes.push_back(node->Mesh_.get());
+        }
+
+        std::vector<VertexCacheStats> before(meshes.size()), after(meshes.size());
+        std::vector<std::vector<Ref<Mesh>>> lods(meshes.size());
+        std::vector<QuantizationError> errors(meshes.size());
+        ThreadPool& pool = ThreadPool::Get();
+        pool.ParallelFor(meshes.size(), [&](size_t i)
+        {
+            if (options.OptimizeVertexCache)
+                MeshOptimizer::Optimize(*meshes[i], options.OptimizeOverdraw, options.OverdrawThreshold, &before[i], &after[i]);
+
+            if (options.GenerateLods)
+            {
+                lods[i] = MeshSimplifier::GenerateLods(*meshes[i], options.LodLevels, options.LodRatio, &pool);
+                if (options.OptimizeVertexCache)
+                {
+                    for (const auto& lod : lods[i])
+                        MeshOptimizer::Optimize(*lod, options.OptimizeOverdraw, options.OverdrawThreshold);
+                }
+            }
+
+            // Last, it reorders the triangles once more
+            if (options.BuildMeshlets)
+            {
+                Meshlets::Build(*meshes[i], &pool);
+                for (const auto& lod : lods[i])
+                    Meshlets::Build(*lod, &pool);
+            }
+
+            // LODs keep the box of the mesh, so they share its error bound
+            if (options.GpuFormat != VertexFormat::Float)
+            {
+                errors[i] = VertexQuantizer::Measure(*meshes[i], options.GpuFormat, &pool);
+                meshes[i]->Format = options.GpuFormat;
+                for (const auto& lod : lods[i])
+                    lod->Format = options.GpuFormat;
+            }
+        });
+
+        if (options.GpuFormat != VertexFormat::Float && !meshes.empty())
+        {
+            QuantizationError worst;
+            for (const auto& error : errors)
+            {
+                worst.Position = std::max(worst.Position, error.Position);
+                worst.Normal = std::max(worst.Normal, error.Normal);
+            }
+            LOG_INFO("Quantized '%s': position error %g, normal error %.3f degrees", result.Path.c_str(), worst.Position, worst.Normal);
+        }
+
+        for (const auto& node : result.Meshes)
+        {
+            auto it = node->Mesh_ ? slots.find(node->Mesh_.get()) : slots.end();
+            if (it == slots.end())
+                continue;
+
+            node->Lods = lods[it->second];
+            node->Format = meshes[it->second]->Format;
+            node->Quantization = errors[it->second];
+            if (after[it->second].ACMR == 0.0f)
+                continue;
+
+            node->Optimized = true;
+            node->CacheBefore = before[it->second];
+            node->CacheAfter = after[it->second];
+        }
+    }
+
+    static bool ImportFile(const std::string& path, const std::string& extension, const ImportOptions& options, ImportResult& result, ImportProgress* progress)
+    {
+        if (extension == ".obj")
+            return ObjLoader::Import(path, options, result, progress);
+        if (extension == ".ply")
+            return PlyLoader::Import(path, options, result, progress);
+        if (extension == ".stl")
+            return StlLoader::Import(path, options, result, progress);
+        if (extension == ".gltf" || extension == ".glb")
+            return GltfLoader::Import(path, options, result, progress);
+
+        LOG_ERROR("Unsupported model format '%s'", path.c_str());
+        return false;
+    }
+
+    bool Importer::Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress)
+    {
+        if (!ImportFile(path, GetExtension(path), options, result, progress))
+            return false;
+
+        if ((options.SplitLargeMeshes || options.OptimizeVertexCache || options.GenerateLods || options.BuildMeshlets || options.GpuFormat != VertexFormat::Float) && !(progress && progress->IsCancelled()))
+            PostProcess(result, options);
+
+        return true;
+    }
+
+    bool Importer::IsSupported(const std::string& path)
+    {
+        std::string extension = GetExtension(path);
+        return extension == ".obj" || extension == ".ply" || extension == ".stl"
+            || extension == ".gltf" || extension == ".glb";
+    }
+
+    std::vector<std::string> Importer::FindModels(const std::string& directory)
+    {
+        std::vector<std::string> paths;
+
+        std::error_code error;
+        for (const auto& file : std::filesystem::directory_iterator(directory, error))
+        {
+            if (file.is_regular_file(error) && IsSupported(file.path().u8string()))
+                paths.push_back(file.path().u8string());
+        }
+
+        if (error)
+        {
+            LOG_ERROR("Could not read directory '%s'", directory.c_str());
+        }
+
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    size_t Importer::ImportBatch(const std::vector<std::string>& paths, const ImportOptions& options, std::vector<ImportResult>& results, ImportProgress* progress)
+    {
+        results.clear();
+        results.resize(paths.size());
+
+        if (progress)
+            progress->Files += paths.size();
+
+        // The loaders spread large files over the same pool, ParallelFor
+        // nests so small and large parts share the workers
+        std::atomic<size_t> loaded{ 0 };
+        ThreadPool::Get().ParallelFor(paths.size(), [&](size_t i)
+        {
+            if (progress && progress->IsCancelled())
+                return;
+
+            if (Import(paths[i], options, results[i], progress))
+                loaded++;
+            else
+                results[i] = {};
+
+            if (progress)
+                progress->FilesDone++;
+        });
+
+        return loaded;
+    }
+
+    Entity Importer::CreateEntity(const Ref<Scene>& scene, const ImportResult& result, size_t mesh, UUID group)
+    {
+        const Ref<MeshNode>& meshNode = result.Meshes[mesh];
+
+        std::string name = meshNode->Name;
+        auto entity = scene->CreateEntityWithGroupUUID(name, group);
+        entity.AddComponent<MeshComponent>(meshNode->Mesh_, meshNode->Name, result.Path);
+
+        auto& transform = entity.GetComponent<TransformComponent>();
+        transform.Translation = meshNode->Translation;
+        transform.Rotation = meshNode->Rotation;
+        transform.Scale = meshNode->Scale;
+
+        if (meshNode->Store)
+            entity.AddComponent<StreamedComponent>(meshNode->Store, meshNode->Chunk);
+        if (meshNode->Optimized)
+            entity.AddComponent<VertexCacheComponent>(meshNode->CacheBefore, meshNode->CacheAfter);
+        if (!meshNode->Lods.empty())
+            entity.AddComponent<LodComponent>(meshNode->Lods);
+        if (meshNode->Format != VertexFormat::Float)
+            entity.AddComponent<QuantizationComponent>(meshNode->Format, meshNode->Quantization);
+
+        auto it = result.Materials.find(meshNode->Material_);
+        if (it != result.Materials.end())
+            entity.AddComponent<MaterialComponent>(scene->GetMaterials().Intern(*it->second));
+        else
+            entity.AddComponent<MaterialComponent>();
+
+        return entity;
+    }
+
+    void Importer::AddToScene(const Ref<Scene>& scene, const ImportResult& result)
+    {
+        UUID guid = UUID();
+        for (size_t i = 0; i < result.Meshes.size(); ++i)
+            CreateEntity(scene, result, i, guid);
+    }
+
+}
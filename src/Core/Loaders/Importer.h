@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Base.h"
+#include "ImportData.h"
+#include "ImportOptions.h"
+#include "Core/Scene/Scene.h"
+#include "Core/Scene/Entity.h"
+
+namespace GLMV {
+
+    // Front end shared by the model loaders: picks the loader for a file
+    // and turns its ImportResult into scene entities.
+    class Importer
+    {
+        public:
+            static bool Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress = nullptr);
+
+            // Imports every file at the same time on the thread pool.
+            // results[i] belongs to paths[i] and is left empty if that file
+            // failed. Returns the number of files that loaded.
+            static size_t ImportBatch(const std::vector<std::string>& paths, const ImportOptions& options, std::vector<ImportResult>& results, ImportProgress* progress = nullptr);
+
+            static bool IsSupported(const std::string& path);
+            // Supported model files directly inside directory, sorted by name
+            static std::vector<std::string> FindModels(const std::string& directory);
+
+            static Entity CreateEntity(const Ref<Scene>& scene, const ImportResult& result, size_t mesh, UUID group);
+            static void AddToScene(const Ref<Scene>& scene, const ImportResult& result);
+    };
+
+}
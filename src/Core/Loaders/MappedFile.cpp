@@ -0,0 +1,118 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace GLMV {
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& path)
+    {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+
+        m_File = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+            return;
+
+        m_Size = (size_t)size.QuadPart;
+        m_Valid = true;
+
+        // Empty files cannot be mapped, but they are still valid
+        if (m_Size == 0)
+            return;
+
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping)
+        {
+            m_Valid = false;
+            return;
+        }
+
+        m_Mapping = mapping;
+        m_Data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        m_Valid = m_Data != nullptr;
+    }
+
+    void MappedFile::Discard(const char* begin, const char* end) const
+    {
+        // Unlocking pages that are not locked takes them out of the working set
+        if (begin < end)
+            VirtualUnlock((LPVOID)begin, end - begin);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_Mapping)
+            CloseHandle((HANDLE)m_Mapping);
+        if (m_File)
+            CloseHandle((HANDLE)m_File);
+    }
+#else
+    MappedFile::MappedFile(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return;
+        }
+
+        m_Size = (size_t)st.st_size;
+        m_Valid = true;
+
+        // Empty files cannot be mapped, but they are still valid
+        if (m_Size > 0)
+        {
+            void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                m_Valid = false;
+            }
+            else
+            {
+                madvise(data, m_Size, MADV_SEQUENTIAL);
+                m_Data = (const char*)data;
+            }
+        }
+
+        // The mapping keeps its own reference to the file
+        close(fd);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_Data)
+            munmap((void*)m_Data, m_Size);
+    }
+
+    void MappedFile::Discard(const char* begin, const char* end) const
+    {
+        // madvise wants a page aligned start, round inwards so pages shared
+        // with neighbouring ranges stay
+        const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+        uintptr_t first = ((uintptr_t)begin + page - 1) & ~(page - 1);
+        uintptr_t last = (uintptr_t)end & ~(page - 1);
+        if (first < last)
+            madvise((void*)first, last - first, MADV_DONTNEED);
+    }
+#endif
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Base.h"
+
+namespace GLMV {
+
+    // Read-only view of a whole file mapped into memory
+    class MappedFile
+    {
+        public:
+            MappedFile(const std::string& path);
+            ~MappedFile();
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            const char* Data() const { return m_Data; }
+            size_t Size() const { return m_Size; }
+            const char* begin() const { return m_Data; }
+            const char* end() const { return m_Data + m_Size; }
+
+            bool IsValid() const { return m_Valid; }
+
+            // Drops the pages of [begin, end) from memory. They are read
+            // again from the file on the next access, which keeps passes
+            // over files larger than memory from piling up resident pages.
+            void Discard(const char* begin, const char* end) const;
+
+            static Ref<MappedFile> Create(const std::string& path) { return CreateRef<MappedFile>(path); }
+
+        private:
+            const char* m_Data = nullptr;
+            size_t m_Size = 0;
+            bool m_Valid = false;
+#ifdef _WIN32
+            void* m_File = nullptr;
+            void* m_Mapping = nullptr;
+#endif
+    };
+
+}
@@ -1,249 +1,345 @@
 #include "Obj.h"
+#include "ObjParser.h"
+#include "ImportData.h"
+#include "ImportCache.h"
+#include "Importer.h"
+#include "ObjBackend.h"
+#include "ObjStreamer.h"
+#include "Core/ThreadPool.h"
+#include "Core/Geometry/VertexWelder.h"
+#include "Core/Geometry/NormalGenerator.h"
+#include "Core/Geometry/Extents.h"
 #include "Base.h"
 #include "Core/Renderer/Mesh.h"
-#include "Core/Scene/Components.h"
-#include "Core/Scene/Entity.h"
 #include <filesystem>
 #include <fstream>
+#include <mutex>
 
 
 namespace GLMV {
 
-    struct Material
+    // Every mtl file parsed so far, shared by all imports referencing it.
+    // An entry is reparsed once the file changes on disk.
+    struct MaterialLibrary
     {
-        std::string Name;
-        glm::vec3 Diffuse;
+        std::filesystem::file_time_type Modified;
+        MaterialMap Materials;
     };
 
-    struct MeshNode
-    {
-        Ref<Mesh> Mesh_;
-        std::string Material_;
-        std::string Name;
-    };
+    static std::mutex s_LibrariesMutex;
+    static std::unordered_map<std::string, MaterialLibrary> s_Libraries;
 
-    static std::unordered_map<std::string, Ref<Material>> s_MTLMap;
-    static std::vector<Ref<MeshNode>> s_MeshVec;
-
-    static glm::vec3 ComputeNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+    bool ObjLoader::Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress)
     {
-        return glm::normalize(glm::cross(b - a, c - a));
-    }
+        std::filesystem::path filepath = path.c_str();
 
-    // return the min/max points of pts
-    template< typename Vec >
-    std::pair< Vec, Vec > GetExtents(const Vec* pts, size_t stride, size_t count)
-    {
-        unsigned char* base = (unsigned char*)pts;
-        Vec pmin(*(Vec*)base);
-        Vec pmax(*(Vec*)base);
-        for (size_t i = 0; i < count; ++i, base += stride)
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(filepath, error);
+        if (!error && options.StreamThreshold && size >= options.StreamThreshold)
         {
-            const Vec& pt = *(Vec*)base;
-            pmin = glm::min(pmin, pt);
-            pmax = glm::max(pmax, pt);
+            LOG_INFO("Streaming '%s' out of core (%.1f GB)", filepath.filename().u8string().c_str(), size / 1e9);
+            return ObjStreamer::Import(path, options, result, progress);
         }
 
-        return std::make_pair(pmin, pmax);
-    }
-
-    // centers geometry around the origin
-    // and scales it to fit in a size^3 box
-    template< typename Vec >
-    void CenterAndScale(Vec* pts, size_t stride, size_t count, const typename Vec::value_type& size)
-    {
-        typedef typename Vec::value_type Scalar;
-
-        // get min/max extents
-        std::pair< Vec, Vec > exts = GetExtents(pts, stride, count);
-
-        // center and scale 
-        const Vec center = (exts.first * Scalar(0.5)) + (exts.second * Scalar(0.5f));
+        ObjImportContext context;
+        context.Path = path;
+        context.Options = options;
+        context.Progress = progress;
+        context.Result.Path = path;
 
-        const Scalar factor = size / glm::compMax(exts.second - exts.first);
-        unsigned char* base = (unsigned char*)pts;
-        for (size_t i = 0; i < count; ++i, base += stride)
+        if (options.UseCache && ImportCache::Load(path, options, context.Result.Meshes, context.Result.Materials, context.Result.Dependencies))
         {
-            Vec& pt = *(Vec*)base;
-            pt = ((pt - center) * factor);
+            LOG_INFO("Imported '%s' from cache", filepath.filename().u8string().c_str());
+        }
+        else
+        {
+            if (!Process(context))
+                return false;
+
+            if (options.UseCache)
+                ImportCache::Store(path, options, context.Result.Meshes, context.Result.Materials, context.Result.Dependencies);
         }
+
+        result = std::move(context.Result);
+        return true;
     }
 
-    bool ObjLoader::Load(const std::string& path, Ref<Scene> scene)
+    bool ObjLoader::Process(ObjImportContext& context)
     {
-        std::filesystem::path filepath = path.c_str();
+        const ImportOptions& options = context.Options;
+        ImportProgress* progress = context.Progress;
+        std::vector<Ref<MeshNode>>& meshes = context.Result.Meshes;
+
+        std::filesystem::path filepath = context.Path.c_str();
         std::string parent = filepath.parent_path().u8string(); // Path to material folder
 
-        std::ifstream in(filepath, std::ios::in | std::ios::binary);
-        if (!in)
+        ObjData data;
+        Scope<ObjBackend> backend = ObjBackend::Create(options.ObjBackend);
+        if (!backend->Parse(context.Path, data, progress))
         {
-            LOG_ERROR("Could not open obj file '%s'", filepath.u8string().c_str());
+            if (!context.IsCancelled())
+            {
+                LOG_ERROR("Could not open obj file '%s'", filepath.u8string().c_str());
+            }
             return false;
         }
 
-        s_MTLMap.clear();
-        s_MeshVec.clear();
-
-        Ref<std::vector<glm::vec3>> vertices = CreateRef<std::vector<glm::vec3>>();
-        Ref<std::vector<glm::vec3>> normals = CreateRef<std::vector<glm::vec3>>();
+        if (context.IsCancelled())
+            return false;
+        if (progress)
+            progress->Stage = ImportStage::Processing;
 
-        Ref<MeshNode> mesh = {};
-        std::string line;
-        std::string meshName;
-        std::string mtl;
-        while (std::getline(in, line))
+        context.Result.Materials.insert(data.Materials.begin(), data.Materials.end());
+        context.Result.Dependencies.insert(context.Result.Dependencies.end(), data.MaterialFiles.begin(), data.MaterialFiles.end());
+        for (const auto& mtlib : data.MaterialLibs)
         {
-            std::istringstream iss(line);
-            std::string token;
-
-            iss >> token;
-
-            if (token.size() and token[0] == '#') continue;
-            else if (token == "mtllib")
-            {
-                std::string mtlib;
-                iss >> mtlib;
-                if (!LoadMTL(parent + "/" + mtlib))
-                    LOG_ERROR("Could not open mtl file '%s'", (parent + mtlib).c_str());
-            }
-            else if (token == "o" or token == "g")
-            {
-                iss >> meshName;
-            }
-            else if (token == "usemtl")
-            {
-                if (mesh)
-                {
-                    // still need to compute normals and normalize
-                    s_MeshVec.push_back(mesh);
-                }
-                iss >> mtl;
-                mesh = CreateRef<MeshNode>();
-                mesh->Mesh_ = Mesh::Create();
-                mesh->Name = meshName;
-                mesh->Material_ = mtl;
-            }
-            else if (token == "v")
+            context.Result.Dependencies.push_back(parent + "/" + mtlib);
+            if (!LoadMTL(context, parent + "/" + mtlib))
             {
-                float x = 0, y = 0, z = 0, w = 1;
-                iss >> x >> y >> z >> w;
-                vertices->push_back(glm::vec3(x, y, z));
+                LOG_ERROR("Could not open mtl file '%s'", (parent + mtlib).c_str());
             }
-            else if (token == "f")
-            {
-                std::string _str;
-                uint32_t cnt{};
-
-                int vFirst = -1;
-
-                while (iss >> _str)
-                {
-                    std::istringstream ref(_str);
-                    std::string vStr, vtStr, vnStr;
-                    std::getline(ref, vStr, '/');
-                    std::getline(ref, vtStr, '/');
-                    std::getline(ref, vnStr, '/');
-                    int v = atoi(vStr.c_str());
-                   // int vt = atoi(vtStr.c_str());
-                   // int vn = atoi(vnStr.c_str());
-                   // vt = (vt >= 0 ? vt : texcoords.size() + vt);
-                   // vn = (vn >= 0 ? vn : normals.size() + vn);
-
-                    if (vFirst == -1) vFirst = v - 1;
-
-                    if (cnt >= 3)
-                    {
-                        // triangularize
-                        auto last = mesh->Mesh_->Indexes->at(mesh->Mesh_->Indexes->size() - 1);
-                        mesh->Mesh_->Indexes->push_back(vFirst);
-                        mesh->Mesh_->Indexes->push_back(last);
-                    }
-
-                    mesh->Mesh_->Indexes->push_back(v - 1);
+        }
 
-                    cnt++;
-                }
+        // groups backing each mesh, for their texcoord and normal references
+        std::vector<const ObjGroup*> sources;
+        for (auto& group : data.Groups)
+        {
+            if (group.Indexes.empty())
+                continue;
+
+            Ref<MeshNode> mesh = CreateRef<MeshNode>();
+            mesh->Mesh_ = Mesh::Create();
+            mesh->Name = group.Name;
+            mesh->Material_ = group.Material;
+            *mesh->Mesh_->Indexes = std::move(group.Indexes);
+            meshes.push_back(mesh);
+            sources.push_back(&group);
+        }
 
-                GLMV_ASSERT(mesh->Mesh_->Indexes->size() % 3 == 0, "Should have eneded in triangles");
-            }
+        if (meshes.empty())
+        {
+            LOG_ERROR("No faces found in obj file '%s'", filepath.u8string().c_str());
+            return false;
         }
 
-        GLMV_ASSERT(mesh->Mesh_->Indexes->size() % 3 == 0, "Vertex cannot form all triangles");
+        // Both backends dropped the faces with positions out of range, the
+        // indexes below are used unchecked
+        std::vector<glm::vec3>* vertices = &data.Positions;
+        Ref<std::vector<glm::vec3>> normals = CreateRef<std::vector<glm::vec3>>();
 
-        if (mesh)
+        // welding positions first lets the normals smooth across the seams
+        if (options.WeldEpsilon > 0.0f)
         {
-            // still need to compute normals and normalize
-            s_MeshVec.push_back(mesh);
+            std::vector<uint32_t> remap;
+            size_t count = VertexWelder::WeldPositions(*vertices, options.WeldEpsilon, remap);
+            for (auto& mesh : meshes)
+                for (auto& idx : *mesh->Mesh_->Indexes)
+                    idx = remap[idx];
+            LOG_INFO("Welded %zu positions into %zu (epsilon %g)", vertices->size(), count, options.WeldEpsilon);
         }
 
-        // computing normals
-        normals->resize(vertices->size(), glm::vec3());
+        if (context.IsCancelled())
+            return false;
+
+        // A corner keeps its vn normal when it has a valid one
+        auto authored = [&](uint32_t normal) { return normal < data.Normals.size(); };
 
-        // faces
-        for (Ref<MeshNode> mesh : s_MeshVec)
+        // computing normals, only for meshes with corners the file gave no
+        // normal, over all of them at once so shared positions are smoothed
+        // across group borders
+        std::vector<uint32_t> allIndexes;
+        for (size_t m = 0; m < meshes.size(); ++m)
         {
-            for (int idx = 0; idx < mesh->Mesh_->Indexes->size(); idx += 3)
-            {
-                int ix = mesh->Mesh_->Indexes->at(idx),
-                    iy = mesh->Mesh_->Indexes->at(idx + 1),
-                    iz = mesh->Mesh_->Indexes->at(idx + 2);
-                glm::vec3 vx = vertices->at(ix),
-                    vy = vertices->at(iy),
-                    vz = vertices->at(iz);
-                glm::vec3 normal = ComputeNormal(vx, vy, vz);
-                normals->at(ix) += normal;
-                normals->at(iy) += normal;
-                normals->at(iz) += normal;
-            }
+            const auto& normalIndexes = sources[m]->NormalIndexes;
+            if (!normalIndexes.empty() && std::all_of(normalIndexes.begin(), normalIndexes.end(), authored))
+                continue;
+
+            const auto& indexes = *meshes[m]->Mesh_->Indexes;
+            allIndexes.insert(allIndexes.end(), indexes.begin(), indexes.end());
         }
 
+        if (!allIndexes.empty())
+            NormalGenerator::Generate(vertices->data(), vertices->size(), allIndexes.data(), allIndexes.size(), options.Normals, *normals, &ThreadPool::Get());
+        allIndexes = {};
+
         // scaling
         CenterAndScale(vertices->data(), sizeof(glm::vec3), vertices->size(), 1);
 
-        UUID guid = UUID();
-        for (auto& meshNode : s_MeshVec)
+        size_t corners = 0, uniqueVertices = 0;
+        std::vector<uint32_t> slots(options.WeldVertices ? vertices->size() : 0, UINT32_MAX);
+        for (size_t m = 0; m < meshes.size(); ++m)
         {
-            for (auto i = 0; i < meshNode->Mesh_->Indexes->size(); ++i)
+            auto& meshNode = meshes[m];
+            auto& indexes = *meshNode->Mesh_->Indexes;
+            const auto& texCoordIndexes = sources[m]->TexCoordIndexes;
+            const auto& normalIndexes = sources[m]->NormalIndexes;
+            bool hasTexCoords = !texCoordIndexes.empty();
+            corners += indexes.size();
+
+            auto normalOf = [&](size_t corner, uint32_t position) {
+                uint32_t normal = normalIndexes.empty() ? ObjParser::None : normalIndexes[corner];
+                if (!authored(normal))
+                    return (*normals)[position];
+
+                const glm::vec3& n = data.Normals[normal];
+                float length = glm::length(n);
+                return length > 0.0f ? n / length : n;
+            };
+            auto texCoordOf = [&](size_t corner) {
+                uint32_t texCoord = texCoordIndexes[corner];
+                return texCoord < data.TexCoords.size() ? data.TexCoords[texCoord] : glm::vec2(0.0f);
+            };
+
+            if (!options.WeldVertices)
             {
-                auto& idx = meshNode->Mesh_->Indexes->at(i);
-                glm::vec3 vertex = vertices->at(idx), normal = glm::normalize(normals->at(idx));
-                meshNode->Mesh_->Vertices->push_back(vertex);
-                meshNode->Mesh_->Vertices->push_back(normal);
-                meshNode->Mesh_->Vertex->push_back(vertex);
-                meshNode->Mesh_->Normals->push_back(vertex);
-                meshNode->Mesh_->Normals->push_back(normal);
-                idx = i;
+                // one vertex per face corner
+                for (size_t i = 0; i < indexes.size(); ++i)
+                {
+                    auto& idx = indexes[i];
+                    glm::vec3 vertex = (*vertices)[idx], normal = normalOf(i, idx);
+                    meshNode->Mesh_->Vertices->push_back(vertex);
+                    meshNode->Mesh_->Vertices->push_back(normal);
+                    meshNode->Mesh_->Vertex->push_back(vertex);
+                    meshNode->Mesh_->Normals->push_back(vertex);
+                    meshNode->Mesh_->Normals->push_back(normal);
+                    if (hasTexCoords)
+                        meshNode->Mesh_->TexCoords->push_back(texCoordOf(i));
+                    idx = (uint32_t)i;
+                }
+                uniqueVertices += indexes.size();
             }
+            else
+            {
+                // Distinct corners first: by position alone when the file
+                // has no other attribute here, else by the
+                // position/texcoord/normal reference triplet. used[i] is the
+                // first corner of distinct vertex i, positions[i] its position.
+                std::vector<uint32_t> used, positions;
+                if (!hasTexCoords && normalIndexes.empty())
+                {
+                    for (size_t i = 0; i < indexes.size(); ++i)
+                    {
+                        uint32_t& slot = slots[indexes[i]];
+                        if (slot == UINT32_MAX)
+                        {
+                            slot = (uint32_t)used.size();
+                            used.push_back((uint32_t)i);
+                            positions.push_back(indexes[i]);
+                        }
+                        indexes[i] = slot;
+                    }
+                    for (uint32_t idx : positions)
+                        slots[idx] = UINT32_MAX;
+                }
+                else
+                {
+                    std::vector<uint32_t> keys(indexes.size() * 3);
+                    for (size_t i = 0; i < indexes.size(); ++i)
+                    {
+                        keys[i * 3] = indexes[i];
+                        keys[i * 3 + 1] = hasTexCoords ? texCoordIndexes[i] : ObjParser::None;
+                        keys[i * 3 + 2] = normalIndexes.empty() ? ObjParser::None : normalIndexes[i];
+                    }
 
-            *meshNode->Mesh_->BoundingBox = GetExtents(meshNode->Mesh_->Vertex->data(), sizeof(glm::vec3), meshNode->Mesh_->Vertex->size());
+                    std::vector<uint32_t> unique, remap;
+                    size_t count = VertexWelder::Weld(keys.data(), indexes.size(), 3, unique, remap);
+                    used.assign(count, UINT32_MAX);
+                    positions.resize(count);
+                    for (size_t i = 0; i < count; ++i)
+                        positions[i] = unique[i * 3];
+                    for (size_t i = 0; i < indexes.size(); ++i)
+                    {
+                        if (used[remap[i]] == UINT32_MAX)
+                            used[remap[i]] = (uint32_t)i;
+                        indexes[i] = remap[i];
+                    }
+                }
 
-            auto entity = scene->Scene::CreateEntityWithGroupUUID(meshNode->Name, guid);
-            entity.AddComponent<MeshComponent>(meshNode->Mesh_, meshNode->Name, path);
+                // then merge the ones that end up with the same attribute values
+                const uint32_t stride = hasTexCoords ? 8 : 6;
+                std::vector<float> records;
+                records.reserve(used.size() * stride);
+                for (size_t i = 0; i < used.size(); ++i)
+                {
+                    const glm::vec3& vertex = (*vertices)[positions[i]];
+                    glm::vec3 normal = normalOf(used[i], positions[i]);
+                    records.insert(records.end(), { vertex.x, vertex.y, vertex.z, normal.x, normal.y, normal.z });
+                    if (hasTexCoords)
+                    {
+                        glm::vec2 texCoord = texCoordOf(used[i]);
+                        records.insert(records.end(), { texCoord.x, texCoord.y });
+                    }
+                }
 
-            auto it = s_MTLMap.find(meshNode->Material_);
-            if (it != s_MTLMap.end())
-            {
-                entity.AddComponent<MaterialComponent>(glm::vec4(it->second->Diffuse, 1), it->second->Name);
+                std::vector<float> unique;
+                std::vector<uint32_t> remap;
+                size_t count = VertexWelder::Weld(records.data(), used.size(), stride, unique, remap);
+                for (auto& idx : indexes)
+                    idx = remap[idx];
+
+                auto& mesh = *meshNode->Mesh_;
+                mesh.Vertices->reserve(count * 2);
+                mesh.Vertex->reserve(count);
+                mesh.Normals->reserve(count * 2);
+                if (hasTexCoords)
+                    mesh.TexCoords->reserve(count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const float* record = unique.data() + i * stride;
+                    glm::vec3 vertex(record[0], record[1], record[2]);
+                    glm::vec3 normal(record[3], record[4], record[5]);
+                    mesh.Vertices->push_back(vertex);
+                    mesh.Vertices->push_back(normal);
+                    mesh.Vertex->push_back(vertex);
+                    mesh.Normals->push_back(vertex);
+                    mesh.Normals->push_back(normal);
+                    if (hasTexCoords)
+                        mesh.TexCoords->emplace_back(record[6], record[7]);
+                }
+                uniqueVertices += count;
             }
-            else
-            {
-                entity.AddComponent<MaterialComponent>();
-            } 
+
+            *meshNode->Mesh_->BoundingBox = GetExtents(meshNode->Mesh_->Vertex->data(), sizeof(glm::vec3), meshNode->Mesh_->Vertex->size());
+        }
+
+        if (uniqueVertices)
+        {
+            LOG_INFO("Imported '%s': %zu corners -> %zu vertices (%.2fx fewer)", filepath.filename().u8string().c_str(), corners, uniqueVertices, (double)corners / uniqueVertices);
         }
 
         return true;
     }
 
-    bool ObjLoader::LoadMTL(const std::string& path)
+    bool ObjLoader::LoadMTL(ObjImportContext& context, const std::string& path)
     {
         std::filesystem::path filepath = path.c_str();
 
+        std::error_code error;
+        std::string key = std::filesystem::weakly_canonical(filepath, error).u8string();
+        if (error)
+            key = filepath.u8string();
+        std::filesystem::file_time_type modified = std::filesystem::last_write_time(filepath, error);
+        if (error)
+            return false;
+
+        {
+            std::lock_guard<std::mutex> lock(s_LibrariesMutex);
+            auto it = s_Libraries.find(key);
+            if (it != s_Libraries.end() && it->second.Modified == modified)
+            {
+                context.Result.Materials.insert(it->second.Materials.begin(), it->second.Materials.end());
+                return true;
+            }
+        }
+
         std::ifstream in(filepath, std::ios::in | std::ios::binary);
         if (!in)
         {
             return false;
         }
 
+        MaterialMap materials;
+
         std::string line;
         std::string mtl;
         Ref<Material> material = {};
@@ -260,25 +356,40 @@ namespace GLMV {
             {
                 if (material)
                 {
-                    s_MTLMap[mtl] = material;
+                    materials[mtl] = material;
                 }
                 iss >> mtl;
                 material = CreateRef<Material>();
                 material->Name = mtl;
             }
-            else if (token == "Kd")
+            else if (token == "Kd" && material)
             {
                 float r, g, b;
                 iss >> r >> g >> b;
                 material->Diffuse = {r, g, b};
             }
+            else if (token == "d" && material)
+            {
+                iss >> material->Opacity;
+            }
+            else if (token == "Tr" && material)
+            {
+                // Transparency, the inverse of d
+                float transparency = 0.0f;
+                iss >> transparency;
+                material->Opacity = 1.0f - transparency;
+            }
         }
 
         if (material)
         {
-            s_MTLMap[mtl] = material;
+            materials[mtl] = material;
         }
 
+        context.Result.Materials.insert(materials.begin(), materials.end());
+
+        std::lock_guard<std::mutex> lock(s_LibrariesMutex);
+        s_Libraries[key] = { modified, std::move(materials) };
         return true;
     }
 
@@ -1,15 +1,32 @@
 #pragma once
 
 #include "Base.h"
+#include "ImportOptions.h"
+#include "ImportData.h"
 #include <Core/Scene/Scene.h>
 
 namespace GLMV {
 
+    // State of a single OBJ import. Each import owns one, so any number of
+    // imports can run at the same time.
+    struct ObjImportContext
+    {
+        std::string Path;
+        ImportOptions Options;
+        ImportProgress* Progress = nullptr;
+        ImportResult Result;
+
+        bool IsCancelled() const { return Progress && Progress->IsCancelled(); }
+    };
+
     class ObjLoader
     {
         public:
-            static bool Load(const std::string& path, Ref<Scene> scene);
+            // Parses and processes the file without touching the scene, so it
+            // can run on a worker thread
+            static bool Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress = nullptr);
         private:
-            static bool LoadMTL(const std::string& path);
+            static bool Process(ObjImportContext& context);
+            static bool LoadMTL(ObjImportContext& context, const std::string& path);
     };
 }
\ No newline at end of file
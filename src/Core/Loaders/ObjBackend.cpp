@@ -0,0 +1,34 @@
+#include "ObjBackend.h"
+#include "MappedFile.h"
+#include "ImportData.h"
+
+#include "Core/ThreadPool.h"
+
+namespace GLMV {
+
+    Scope<ObjBackend> ObjBackend::Create(ObjBackendType type)
+    {
+        switch (type)
+        {
+            case ObjBackendType::Native: return CreateScope<NativeObjBackend>();
+            case ObjBackendType::TinyObj: return CreateScope<TinyObjBackend>();
+        }
+
+        GLMV_ASSERT(false, "Unknown obj backend");
+        return nullptr;
+    }
+
+    bool NativeObjBackend::Parse(const std::string& path, ObjData& data, ImportProgress* progress)
+    {
+        Ref<MappedFile> file = MappedFile::Create(path);
+        if (!file->IsValid())
+            return false;
+
+        // Added up, several imports may report into the same progress
+        if (progress)
+            progress->BytesTotal += file->Size();
+
+        return ObjParser::Parse(file->begin(), file->end(), data, &ThreadPool::Get(), progress);
+    }
+
+}
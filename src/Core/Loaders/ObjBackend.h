@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Base.h"
+#include "ObjParser.h"
+
+namespace GLMV {
+
+    struct ImportProgress;
+
+    enum class ObjBackendType
+    {
+        Native = 0, TinyObj
+    };
+
+    // Turns an obj file into ObjData. ObjLoader runs the same mesh
+    // processing on top of whichever backend parsed the file, so backends
+    // can be swapped per import and compared against each other.
+    class ObjBackend
+    {
+        public:
+            virtual ~ObjBackend() = default;
+
+            virtual const char* GetName() const = 0;
+
+            // Returns false if the file could not be read or the import was
+            // cancelled through `progress`
+            virtual bool Parse(const std::string& path, ObjData& data, ImportProgress* progress = nullptr) = 0;
+
+            static Scope<ObjBackend> Create(ObjBackendType type);
+    };
+
+    // Memory mapped file, allocation free tokenizer, parallel chunks on
+    // the shared thread pool
+    class NativeObjBackend : public ObjBackend
+    {
+        public:
+            virtual const char* GetName() const override { return "native"; }
+            virtual bool Parse(const std::string& path, ObjData& data, ImportProgress* progress = nullptr) override;
+    };
+
+    // The vendored tinyobjloader, single threaded. Materials come from its
+    // own mtl reader and are returned in ObjData::Materials.
+    class TinyObjBackend : public ObjBackend
+    {
+        public:
+            virtual const char* GetName() const override { return "tinyobj"; }
+            virtual bool Parse(const std::string& path, ObjData& data, ImportProgress* progress = nullptr) override;
+    };
+
+}
@@ -0,0 +1,398 @@
+#include "ObjParser.h"
+#include "Tokenizer.h"
+#include "ImportData.h"
+#include "Core/ThreadPool.h"
+
+namespace GLMV {
+
+    static constexpr size_t s_MinChunkSize = 1024 * 1024;
+    static constexpr size_t s_ProgressStep = 1024 * 1024;
+
+    // Relative (negative) references, as index slot and offset from the chunk start
+    using RelativeList = std::vector<std::pair<uint32_t, int64_t>>;
+
+    // What a chunk cannot know on its own is recorded here and resolved
+    // when the chunks are merged in file order.
+    struct ObjChunkGroup
+    {
+        ObjGroup Group;
+        // Started by a face, not by usemtl: appends to the group open at chunk start
+        bool Continues = false;
+        // No o/g seen in this chunk yet: takes the name open at chunk start
+        bool InheritsName = false;
+        RelativeList Relative;
+        RelativeList RelativeTexCoords;
+        RelativeList RelativeNormals;
+    };
+
+    // Raw obj references of one face corner, 0 when absent
+    struct Corner
+    {
+        int Position = 0, TexCoord = 0, Normal = 0;
+    };
+
+    struct ObjChunk
+    {
+        std::vector<glm::vec3> Positions;
+        std::vector<glm::vec2> TexCoords;
+        std::vector<glm::vec3> Normals;
+        std::vector<ObjChunkGroup> Groups;
+        std::vector<std::string> MaterialLibs;
+        std::string LastName;
+        bool HasName = false;
+    };
+
+    // Appends a one based or negative obj reference into a stream of
+    // `count` elements read so far
+    static void PushIndex(std::vector<uint32_t>& indexes, RelativeList& relative, int value, size_t count)
+    {
+        if (value < 0)
+        {
+            // fixed up once the chunk offset is known
+            relative.emplace_back((uint32_t)indexes.size(), (int64_t)count + value);
+            indexes.push_back(0);
+        }
+        else
+        {
+            indexes.push_back((uint32_t)(value - 1));
+        }
+    }
+
+    static bool ParseChunk(const char* begin, const char* end, ObjChunk& chunk, ImportProgress* progress)
+    {
+        Tokenizer tokenizer(begin, end);
+
+        const char* reported = begin;
+        uint64_t triangles = 0;
+        auto report = [&]() {
+            progress->BytesRead += tokenizer.GetPosition() - reported;
+            progress->Triangles += triangles;
+            reported = tokenizer.GetPosition();
+            triangles = 0;
+        };
+
+        ObjChunkGroup* group = nullptr;
+
+        auto newGroup = [&](bool continues) {
+            group = &chunk.Groups.emplace_back();
+            group->Continues = continues;
+            group->InheritsName = !chunk.HasName;
+            group->Group.Name = chunk.LastName;
+        };
+
+        while (!tokenizer.AtEnd())
+        {
+            std::string_view token = tokenizer.Token();
+
+            if (token == "v")
+            {
+                float x = 0, y = 0, z = 0;
+                tokenizer.Float(x);
+                tokenizer.Float(y);
+                tokenizer.Float(z);
+                chunk.Positions.emplace_back(x, y, z);
+            }
+            else if (token == "vt")
+            {
+                float u = 0, v = 0;
+                tokenizer.Float(u);
+                tokenizer.Float(v);
+                chunk.TexCoords.emplace_back(u, v);
+            }
+            else if (token == "vn")
+            {
+                float x = 0, y = 0, z = 0;
+                tokenizer.Float(x);
+                tokenizer.Float(y);
+                tokenizer.Float(z);
+                chunk.Normals.emplace_back(x, y, z);
+            }
+            else if (token == "f")
+            {
+                if (!group)
+                    newGroup(true);
+
+                ObjGroup& target = group->Group;
+                std::vector<uint32_t>& indexes = target.Indexes;
+                size_t faceStart = indexes.size();
+                size_t relativeStart[3] = { group->Relative.size(), group->RelativeTexCoords.size(), group->RelativeNormals.size() };
+                Corner first, last;
+                uint32_t cnt = 0;
+
+                // Attribute streams stay empty until a corner uses them, then
+                // get backfilled so they line up with the positions
+                auto pushAttribute = [&](std::vector<uint32_t>& stream, RelativeList& relative, int value, size_t count) {
+                    stream.resize(indexes.size() - 1, ObjParser::None);
+                    if (value == 0)
+                        stream.push_back(ObjParser::None);
+                    else
+                        PushIndex(stream, relative, value, count);
+                };
+
+                auto push = [&](const Corner& corner) {
+                    PushIndex(indexes, group->Relative, corner.Position, chunk.Positions.size());
+                    if (corner.TexCoord || !target.TexCoordIndexes.empty())
+                        pushAttribute(target.TexCoordIndexes, group->RelativeTexCoords, corner.TexCoord, chunk.TexCoords.size());
+                    if (corner.Normal || !target.NormalIndexes.empty())
+                        pushAttribute(target.NormalIndexes, group->RelativeNormals, corner.Normal, chunk.Normals.size());
+                };
+
+                while (!tokenizer.AtLineEnd())
+                {
+                    int v = 0;
+                    if (!tokenizer.Int(v) || v == 0)
+                    {
+                        tokenizer.SkipToken();
+                        continue;
+                    }
+
+                    // v, v/vt, v//vn or v/vt/vn
+                    int vt = 0, vn = 0;
+                    if (tokenizer.Consume('/'))
+                    {
+                        if (!tokenizer.Consume('/'))
+                        {
+                            tokenizer.Int(vt);
+                            if (tokenizer.Consume('/'))
+                                tokenizer.Int(vn);
+                        }
+                        else
+                        {
+                            tokenizer.Int(vn);
+                        }
+                    }
+                    tokenizer.SkipToken();
+
+                    Corner corner = { v, vt, vn };
+
+                    if (cnt == 0)
+                        first = corner;
+
+                    if (cnt >= 3)
+                    {
+                        // triangularize
+                        push(first);
+                        push(last);
+                    }
+
+                    push(corner);
+                    last = corner;
+                    cnt++;
+                }
+
+                // drop points and lines
+                if (cnt < 3)
+                {
+                    indexes.resize(faceStart);
+                    target.TexCoordIndexes.resize(std::min(target.TexCoordIndexes.size(), faceStart));
+                    target.NormalIndexes.resize(std::min(target.NormalIndexes.size(), faceStart));
+                    group->Relative.resize(relativeStart[0]);
+                    group->RelativeTexCoords.resize(relativeStart[1]);
+                    group->RelativeNormals.resize(relativeStart[2]);
+                }
+                else
+                {
+                    triangles += cnt - 2;
+                }
+            }
+            else if (token == "o" || token == "g")
+            {
+                chunk.LastName = tokenizer.Token();
+                chunk.HasName = true;
+            }
+            else if (token == "usemtl")
+            {
+                newGroup(false);
+                group->Group.Material = tokenizer.Token();
+            }
+            else if (token == "mtllib")
+            {
+                chunk.MaterialLibs.emplace_back(tokenizer.Rest());
+            }
+
+            tokenizer.NextLine();
+
+            if (progress && (size_t)(tokenizer.GetPosition() - reported) >= s_ProgressStep)
+            {
+                report();
+                if (progress->IsCancelled())
+                    return false;
+            }
+        }
+
+        if (progress)
+            report();
+
+        return true;
+    }
+
+    // Appends `count` attribute indexes of a continued group, keeping the
+    // stream either empty or aligned with the positions
+    static void AppendAttribute(std::vector<uint32_t>& stream, size_t offset, const std::vector<uint32_t>& appended, size_t count)
+    {
+        if (stream.empty() && appended.empty())
+            return;
+
+        stream.resize(offset, ObjParser::None);
+        if (appended.empty())
+            stream.resize(offset + count, ObjParser::None);
+        else
+            stream.insert(stream.end(), appended.begin(), appended.end());
+    }
+
+    template<typename T>
+    static void MergeStream(std::vector<T>& merged, std::vector<T>& chunk, size_t total)
+    {
+        if (merged.empty())
+        {
+            merged = std::move(chunk);
+            merged.reserve(total);
+        }
+        else
+        {
+            merged.insert(merged.end(), chunk.begin(), chunk.end());
+            chunk = {};
+        }
+    }
+
+    static void MergeChunks(std::vector<ObjChunk>& chunks, ObjData& data)
+    {
+        size_t positions = 0, texCoords = 0, normals = 0;
+        for (const auto& chunk : chunks)
+        {
+            positions += chunk.Positions.size();
+            texCoords += chunk.TexCoords.size();
+            normals += chunk.Normals.size();
+        }
+
+        ObjGroup* open = nullptr;
+        std::string name;
+
+        for (auto& chunk : chunks)
+        {
+            int64_t base = (int64_t)data.Positions.size();
+            int64_t texCoordBase = (int64_t)data.TexCoords.size();
+            int64_t normalBase = (int64_t)data.Normals.size();
+            MergeStream(data.Positions, chunk.Positions, positions);
+            MergeStream(data.TexCoords, chunk.TexCoords, texCoords);
+            MergeStream(data.Normals, chunk.Normals, normals);
+
+            for (auto& group : chunk.Groups)
+            {
+                if (group.InheritsName)
+                    group.Group.Name = name;
+
+                uint32_t offset = 0;
+                if (group.Continues && open)
+                {
+                    offset = (uint32_t)open->Indexes.size();
+                    size_t count = group.Group.Indexes.size();
+                    open->Indexes.insert(open->Indexes.end(), group.Group.Indexes.begin(), group.Group.Indexes.end());
+                    AppendAttribute(open->TexCoordIndexes, offset, group.Group.TexCoordIndexes, count);
+                    AppendAttribute(open->NormalIndexes, offset, group.Group.NormalIndexes, count);
+                }
+                else
+                {
+                    open = &data.Groups.emplace_back(std::move(group.Group));
+                }
+
+                for (const auto& [slot, index] : group.Relative)
+                    open->Indexes[offset + slot] = (uint32_t)(base + index);
+                for (const auto& [slot, index] : group.RelativeTexCoords)
+                    open->TexCoordIndexes[offset + slot] = (uint32_t)(texCoordBase + index);
+                for (const auto& [slot, index] : group.RelativeNormals)
+                    open->NormalIndexes[offset + slot] = (uint32_t)(normalBase + index);
+            }
+
+            if (chunk.HasName)
+                name = chunk.LastName;
+
+            data.MaterialLibs.insert(data.MaterialLibs.end(), chunk.MaterialLibs.begin(), chunk.MaterialLibs.end());
+        }
+    }
+
+    bool ObjParser::Parse(const char* begin, const char* end, ObjData& data, ThreadPool* pool, ImportProgress* progress)
+    {
+        size_t size = end - begin;
+        size_t count = 1;
+        if (pool && size > ParallelThreshold)
+            count = std::max<size_t>(1, std::min<size_t>(size / s_MinChunkSize, (pool->GetThreadCount() + 1) * 4));
+
+        // Split on line starts so no statement is cut in two
+        std::vector<const char*> bounds(count + 1);
+        bounds[0] = begin;
+        bounds[count] = end;
+        for (size_t i = 1; i < count; ++i)
+        {
+            const char* at = std::max(begin + size * i / count, bounds[i - 1]);
+            const char* eol = (const char*)memchr(at, '\n', end - at);
+            bounds[i] = eol ? eol + 1 : end;
+        }
+
+        std::vector<ObjChunk> chunks(count);
+        std::atomic<bool> completed{ true };
+        if (count == 1)
+        {
+            completed = ParseChunk(begin, end, chunks[0], progress);
+        }
+        else
+        {
+            pool->ParallelFor(count, [&](size_t i) {
+                if (!ParseChunk(bounds[i], bounds[i + 1], chunks[i], progress))
+                    completed = false;
+            });
+        }
+
+        if (!completed)
+            return false;
+
+        MergeChunks(chunks, data);
+
+        size_t removed = RemoveInvalidTriangles(data);
+        if (removed)
+        {
+            LOG_WARN("Dropped %zu triangles referencing missing vertices", removed);
+        }
+        return true;
+    }
+
+    size_t ObjParser::RemoveInvalidTriangles(ObjData& data)
+    {
+        size_t removed = 0;
+        size_t positions = data.Positions.size();
+        for (auto& group : data.Groups)
+        {
+            std::vector<uint32_t>& indexes = group.Indexes;
+            bool texCoords = !group.TexCoordIndexes.empty(), normals = !group.NormalIndexes.empty();
+
+            size_t kept = 0;
+            for (size_t t = 0; t + 3 <= indexes.size(); t += 3)
+            {
+                if (indexes[t] >= positions || indexes[t + 1] >= positions || indexes[t + 2] >= positions)
+                {
+                    removed++;
+                    continue;
+                }
+
+                for (size_t corner = 0; corner < 3; ++corner)
+                {
+                    indexes[kept + corner] = indexes[t + corner];
+                    if (texCoords)
+                        group.TexCoordIndexes[kept + corner] = group.TexCoordIndexes[t + corner];
+                    if (normals)
+                        group.NormalIndexes[kept + corner] = group.NormalIndexes[t + corner];
+                }
+                kept += 3;
+            }
+
+            indexes.resize(kept);
+            if (texCoords)
+                group.TexCoordIndexes.resize(kept);
+            if (normals)
+                group.NormalIndexes.resize(kept);
+        }
+
+        return removed;
+    }
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Base.h"
+#include "ImportData.h"
+#include <glm/glm.hpp>
+
+namespace GLMV {
+
+    class ThreadPool;
+    struct ImportProgress;
+
+    // Faces sharing a material, triangulated, with zero based indexes.
+    // TexCoordIndexes and NormalIndexes are either empty, when no face of
+    // the group referenced that attribute, or one per corner like Indexes
+    // with ObjParser::None for the corners that did not.
+    struct ObjGroup
+    {
+        std::string Name;
+        std::string Material;
+        std::vector<uint32_t> Indexes;
+        std::vector<uint32_t> TexCoordIndexes;
+        std::vector<uint32_t> NormalIndexes;
+    };
+
+    // Raw contents of an obj file, before any mesh processing
+    struct ObjData
+    {
+        std::vector<glm::vec3> Positions;
+        std::vector<glm::vec2> TexCoords;
+        std::vector<glm::vec3> Normals;
+        std::vector<ObjGroup> Groups;
+        std::vector<std::string> MaterialLibs;
+        // Filled by backends that read the mtl files themselves, with the
+        // files they may have read
+        MaterialMap Materials;
+        std::vector<std::string> MaterialFiles;
+    };
+
+    class ObjParser
+    {
+        public:
+            // Files larger than this are split in line aligned chunks
+            // and parsed on the pool, when one is given.
+            static constexpr size_t ParallelThreshold = 4 * 1024 * 1024;
+            // Attribute index of a corner that has none
+            static constexpr uint32_t None = UINT32_MAX;
+
+            // Returns false if the import was cancelled through `progress`
+            static bool Parse(const char* begin, const char* end, ObjData& data, ThreadPool* pool = nullptr, ImportProgress* progress = nullptr);
+
+            // Drops the triangles referencing a position the file does not
+            // have, `f 0` or an out of range index in a malformed file, so
+            // every index in data.Groups is valid. Returns how many.
+            static size_t RemoveInvalidTriangles(ObjData& data);
+    };
+
+}
@@ -0,0 +1,642 @@
+#include "ObjStreamer.h"
+#include "ChunkStore.h"
+#include "ImportCache.h"
+#include "MappedFile.h"
+#include "Tokenizer.h"
+#include "Core/ThreadPool.h"
+#include "Core/Geometry/Extents.h"
+#include "Core/Geometry/NormalGenerator.h"
+
+#include <cfloat>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace GLMV {
+
+    // Line aligned pieces of the file parsed by one task
+    static constexpr size_t s_SpanSize = 8 * 1024 * 1024;
+    // Resolution of the position histogram along the longest side
+    static constexpr int s_GridSize = 128;
+    static constexpr size_t s_BlockSize = 1 << 20;
+
+    struct ObjSpan
+    {
+        const char* Begin;
+        const char* End;
+        // Positions of all the spans before this one
+        uint64_t PositionsBefore = 0;
+    };
+
+    // A triangle by global position index, tagged with the chunk it goes to
+    struct BinnedTriangle
+    {
+        uint32_t Chunk;
+        uint32_t Index[3];
+    };
+
+    // Where the triangles of one chunk were spilled
+    struct SpillRun
+    {
+        uint64_t Offset;
+        uint64_t Count;
+    };
+
+    // Scratch file removed when the import is done with it
+    struct TemporaryFile
+    {
+        std::string Path;
+
+        TemporaryFile(const std::string& path) : Path(path) {}
+        ~TemporaryFile()
+        {
+            std::error_code error;
+            std::filesystem::remove(Path, error);
+        }
+    };
+
+    // State of a single streaming import
+    struct ObjStreamContext
+    {
+        ImportOptions Options;
+        ImportProgress* Progress = nullptr;
+        ThreadPool* Pool = nullptr;
+        // Spans processed at the same time
+        size_t Batch = 1;
+
+        Ref<MappedFile> File;
+        std::vector<ObjSpan> Spans;
+
+        uint64_t PositionCount = 0;
+        uint64_t TriangleCount = 0;
+        glm::vec3 Min{ FLT_MAX }, Max{ -FLT_MAX };
+
+        // Histogram cells, and the chunk each of them belongs to
+        int Dims[3] = { 1, 1, 1 };
+        glm::vec3 CellScale{ 0.0f };
+        std::vector<uint32_t> ChunkOfCell;
+        uint32_t ChunkCount = 0;
+
+        bool IsCancelled() const { return Progress && Progress->IsCancelled(); }
+
+        size_t CellOf(const glm::vec3& point) const
+        {
+            glm::vec3 cell = (point - Min) * CellScale;
+            int x = std::clamp((int)cell.x, 0, Dims[0] - 1);
+            int y = std::clamp((int)cell.y, 0, Dims[1] - 1);
+            int z = std::clamp((int)cell.z, 0, Dims[2] - 1);
+            return ((size_t)z * Dims[1] + y) * Dims[0] + x;
+        }
+    };
+
+    static std::vector<ObjSpan> SplitSpans(const MappedFile& file)
+    {
+        std::vector<ObjSpan> spans;
+        const char* begin = file.begin();
+        while (begin < file.end())
+        {
+            const char* end = begin + std::min<size_t>(s_SpanSize, file.end() - begin);
+            if (end < file.end())
+            {
+                const char* eol = (const char*)memchr(end, '\n', file.end() - end);
+                end = eol ? eol + 1 : file.end();
+            }
+            spans.push_back({ begin, end });
+            begin = end;
+        }
+        return spans;
+    }
+
+    struct SpanPositions
+    {
+        std::vector<glm::vec3> Positions;
+        uint64_t Triangles = 0;
+        glm::vec3 Min{ FLT_MAX }, Max{ -FLT_MAX };
+    };
+
+    static void ParsePositions(const ObjSpan& span, SpanPositions& out)
+    {
+        Tokenizer tokenizer(span.Begin, span.End);
+        while (!tokenizer.AtEnd())
+        {
+            std::string_view token = tokenizer.Token();
+            if (token == "v")
+            {
+                glm::vec3 position(0.0f);
+                tokenizer.Float(position.x);
+                tokenizer.Float(position.y);
+                tokenizer.Float(position.z);
+                out.Positions.push_back(position);
+                out.Min = glm::min(out.Min, position);
+                out.Max = glm::max(out.Max, position);
+            }
+            else if (token == "f")
+            {
+                uint64_t corners = 0;
+                for (; !tokenizer.AtLineEnd(); ++corners)
+                    tokenizer.SkipToken();
+                if (corners >= 3)
+                    out.Triangles += corners - 2;
+            }
+            tokenizer.NextLine();
+        }
+    }
+
+    // Pass 1: positions go to the spool file in file order, and every span
+    // learns how many positions came before it for relative face indexes
+    static bool SpoolPositions(ObjStreamContext& context, const std::string& path)
+    {
+        std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        for (size_t first = 0; first < context.Spans.size(); first += context.Batch)
+        {
+            size_t count = std::min(context.Batch, context.Spans.size() - first);
+            std::vector<SpanPositions> parsed(count);
+            context.Pool->ParallelFor(count, [&](size_t i) { ParsePositions(context.Spans[first + i], parsed[i]); });
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                context.Spans[first + i].PositionsBefore = context.PositionCount;
+                context.PositionCount += parsed[i].Positions.size();
+                context.TriangleCount += parsed[i].Triangles;
+                context.Min = glm::min(context.Min, parsed[i].Min);
+                context.Max = glm::max(context.Max, parsed[i].Max);
+                out.write((const char*)parsed[i].Positions.data(), parsed[i].Positions.size() * sizeof(glm::vec3));
+            }
+
+            const char* begin = context.Spans[first].Begin;
+            const char* end = context.Spans[first + count - 1].End;
+            context.File->Discard(begin, end);
+
+            if (context.Progress)
+            {
+                context.Progress->BytesRead += end - begin;
+                if (context.IsCancelled())
+                    return false;
+            }
+        }
+
+        out.close();
+        return (bool)out;
+    }
+
+    // Splits the histogram into boxes of about `target` positions each,
+    // cutting the longest side at the median every time, so dense areas
+    // get small chunks and sparse ones large chunks
+    static void Partition(ObjStreamContext& context, const std::vector<uint32_t>& histogram, uint64_t target)
+    {
+        struct Box
+        {
+            int Lo[3], Hi[3];
+        };
+
+        const int* dims = context.Dims;
+        context.ChunkOfCell.assign(histogram.size(), 0);
+        context.ChunkCount = 0;
+
+        std::vector<Box> stack = { { { 0, 0, 0 }, { dims[0], dims[1], dims[2] } } };
+        while (!stack.empty())
+        {
+            Box box = stack.back();
+            stack.pop_back();
+
+            int axis = 0;
+            for (int a = 1; a < 3; ++a)
+            {
+                if (box.Hi[a] - box.Lo[a] > box.Hi[axis] - box.Lo[axis])
+                    axis = a;
+            }
+
+            std::vector<uint64_t> slices(box.Hi[axis] - box.Lo[axis], 0);
+            uint64_t total = 0;
+            for (int z = box.Lo[2]; z < box.Hi[2]; ++z)
+                for (int y = box.Lo[1]; y < box.Hi[1]; ++y)
+                    for (int x = box.Lo[0]; x < box.Hi[0]; ++x)
+                    {
+                        uint32_t count = histogram[((size_t)z * dims[1] + y) * dims[0] + x];
+                        int cell[3] = { x, y, z };
+                        slices[cell[axis] - box.Lo[axis]] += count;
+                        total += count;
+                    }
+
+            if (total > target && slices.size() > 1)
+            {
+                int split = box.Lo[axis] + 1;
+                uint64_t below = slices[0];
+                while (split < box.Hi[axis] - 1 && below + slices[split - box.Lo[axis]] <= total / 2)
+                    below += slices[split++ - box.Lo[axis]];
+
+                Box low = box, high = box;
+                low.Hi[axis] = split;
+                high.Lo[axis] = split;
+                stack.push_back(high);
+                stack.push_back(low);
+                continue;
+            }
+
+            // A leaf. Cells without positions still need an owner, large
+            // triangles can have their centroid there.
+            for (int z = box.Lo[2]; z < box.Hi[2]; ++z)
+                for (int y = box.Lo[1]; y < box.Hi[1]; ++y)
+                    for (int x = box.Lo[0]; x < box.Hi[0]; ++x)
+                        context.ChunkOfCell[((size_t)z * dims[1] + y) * dims[0] + x] = context.ChunkCount;
+            context.ChunkCount++;
+        }
+    }
+
+    // Histogram of the spooled positions over a grid fitted to the bounds,
+    // then the chunks from it
+    static void BuildChunks(ObjStreamContext& context, const MappedFile& positions)
+    {
+        glm::vec3 size = context.Max - context.Min;
+        float longest = glm::compMax(size);
+        for (int a = 0; a < 3; ++a)
+        {
+            context.Dims[a] = longest > 0.0f ? std::max(1, (int)std::ceil(s_GridSize * size[a] / longest)) : 1;
+            context.CellScale[a] = size[a] > 0.0f ? context.Dims[a] / size[a] : 0.0f;
+        }
+
+        size_t cells = (size_t)context.Dims[0] * context.Dims[1] * context.Dims[2];
+        Scope<std::atomic<uint32_t>[]> counts(new std::atomic<uint32_t>[cells]());
+
+        const glm::vec3* data = (const glm::vec3*)positions.Data();
+        ParallelForBlocks(context.Pool, context.PositionCount, s_BlockSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                counts[context.CellOf(data[i])].fetch_add(1, std::memory_order_relaxed);
+            positions.Discard((const char*)(data + begin), (const char*)(data + end));
+        });
+
+        std::vector<uint32_t> histogram(cells);
+        for (size_t i = 0; i < cells; ++i)
+            histogram[i] = counts[i].load(std::memory_order_relaxed);
+
+        // meshes have about half as many vertices as triangles
+        Partition(context, histogram, std::max<uint64_t>(context.Options.ChunkTriangles / 2, 1));
+    }
+
+    static void BinTriangles(const ObjStreamContext& context, const ObjSpan& span, const glm::vec3* positions, std::vector<BinnedTriangle>& out)
+    {
+        Tokenizer tokenizer(span.Begin, span.End);
+        uint64_t local = 0;
+        std::vector<uint32_t> face;
+
+        while (!tokenizer.AtEnd())
+        {
+            std::string_view token = tokenizer.Token();
+            if (token == "v")
+            {
+                ++local;
+            }
+            else if (token == "f")
+            {
+                face.clear();
+                bool valid = true;
+                while (!tokenizer.AtLineEnd())
+                {
+                    int64_t v = 0;
+                    if (!tokenizer.Int(v) || v == 0)
+                    {
+                        tokenizer.SkipToken();
+                        continue;
+                    }
+                    // texcoord and normal references are not used
+                    tokenizer.SkipToken();
+
+                    int64_t index = v > 0 ? v - 1 : (int64_t)(span.PositionsBefore + local) + v;
+                    if (index < 0 || (uint64_t)index >= context.PositionCount)
+                        valid = false;
+                    face.push_back((uint32_t)index);
+                }
+
+                if (valid)
+                {
+                    for (size_t i = 2; i < face.size(); ++i)
+                    {
+                        BinnedTriangle& triangle = out.emplace_back();
+                        triangle.Index[0] = face[0];
+                        triangle.Index[1] = face[i - 1];
+                        triangle.Index[2] = face[i];
+                        glm::vec3 centroid = (positions[face[0]] + positions[face[i - 1]] + positions[face[i]]) / 3.0f;
+                        triangle.Chunk = context.ChunkOfCell[context.CellOf(centroid)];
+                    }
+                }
+            }
+            tokenizer.NextLine();
+        }
+    }
+
+    // Writes the buffered triangles grouped by chunk
+    static bool Spill(const ObjStreamContext& context, std::vector<BinnedTriangle>& buffered, std::ofstream& out, uint64_t& written, std::vector<std::vector<SpillRun>>& runs)
+    {
+        std::vector<uint64_t> offsets(context.ChunkCount + 1, 0);
+        for (const auto& triangle : buffered)
+            offsets[triangle.Chunk + 1]++;
+        for (uint32_t c = 0; c < context.ChunkCount; ++c)
+            offsets[c + 1] += offsets[c];
+
+        std::vector<uint32_t> sorted(buffered.size() * 3);
+        std::vector<uint64_t> next(offsets.begin(), offsets.end() - 1);
+        for (const auto& triangle : buffered)
+            memcpy(&sorted[next[triangle.Chunk]++ * 3], triangle.Index, sizeof(triangle.Index));
+        buffered.clear();
+
+        for (uint32_t c = 0; c < context.ChunkCount; ++c)
+        {
+            uint64_t count = offsets[c + 1] - offsets[c];
+            if (count)
+                runs[c].push_back({ written + offsets[c] * 3 * sizeof(uint32_t), count });
+        }
+
+        out.write((const char*)sorted.data(), sorted.size() * sizeof(uint32_t));
+        written += sorted.size() * sizeof(uint32_t);
+        return (bool)out;
+    }
+
+    // Pass 2: every triangle goes to the chunk its centroid falls in,
+    // buffered up to half the memory budget and then spilled
+    static bool SpillTriangles(ObjStreamContext& context, const MappedFile& positions, const std::string& path, std::vector<std::vector<SpillRun>>& runs)
+    {
+        std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        const glm::vec3* data = (const glm::vec3*)positions.Data();
+        const size_t limit = std::max<uint64_t>(context.Options.StreamMemory / 2 / sizeof(BinnedTriangle), 1);
+        std::vector<BinnedTriangle> buffered;
+        uint64_t written = 0;
+        runs.assign(context.ChunkCount, {});
+
+        for (size_t first = 0; first < context.Spans.size(); first += context.Batch)
+        {
+            size_t count = std::min(context.Batch, context.Spans.size() - first);
+            std::vector<std::vector<BinnedTriangle>> binned(count);
+            context.Pool->ParallelFor(count, [&](size_t i) { BinTriangles(context, context.Spans[first + i], data, binned[i]); });
+
+            for (auto& triangles : binned)
+            {
+                if (context.Progress)
+                    context.Progress->Triangles += triangles.size();
+                buffered.insert(buffered.end(), triangles.begin(), triangles.end());
+                triangles = {};
+            }
+
+            if (buffered.size() >= limit && !Spill(context, buffered, out, written, runs))
+                return false;
+
+            const char* begin = context.Spans[first].Begin;
+            const char* end = context.Spans[first + count - 1].End;
+            context.File->Discard(begin, end);
+            positions.Discard(positions.begin(), positions.end());
+
+            if (context.Progress)
+            {
+                context.Progress->BytesRead += end - begin;
+                if (context.IsCancelled())
+                    return false;
+            }
+        }
+
+        if (!buffered.empty() && !Spill(context, buffered, out, written, runs))
+            return false;
+
+        out.close();
+        return (bool)out;
+    }
+
+    struct BuiltChunk
+    {
+        std::vector<glm::vec3> Vertices;
+        std::vector<uint32_t> Indexes;
+        std::pair<glm::vec3, glm::vec3> Bounds;
+    };
+
+    static void BuildChunk(const ObjStreamContext& context, const MappedFile& positions, const MappedFile& spill, const std::vector<SpillRun>& runs, BuiltChunk& chunk)
+    {
+        std::vector<uint32_t> corners;
+        for (const auto& run : runs)
+        {
+            const uint32_t* begin = (const uint32_t*)(spill.Data() + run.Offset);
+            corners.insert(corners.end(), begin, begin + run.Count * 3);
+            spill.Discard((const char*)begin, (const char*)(begin + run.Count * 3));
+        }
+
+        // same placement as CenterAndScale over the whole model
+        const glm::vec3* data = (const glm::vec3*)positions.Data();
+        const glm::vec3 center = (context.Min + context.Max) * 0.5f;
+        const float extent = glm::compMax(context.Max - context.Min);
+        const float factor = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+        std::vector<glm::vec3> vertex;
+        std::vector<uint32_t>& indexes = chunk.Indexes;
+        if (context.Options.WeldVertices)
+        {
+            // corners of the same position share a vertex
+            std::vector<uint32_t> unique = corners;
+            std::sort(unique.begin(), unique.end());
+            unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+            indexes.resize(corners.size());
+            for (size_t i = 0; i < corners.size(); ++i)
+                indexes[i] = (uint32_t)(std::lower_bound(unique.begin(), unique.end(), corners[i]) - unique.begin());
+
+            vertex.resize(unique.size());
+            for (size_t i = 0; i < unique.size(); ++i)
+                vertex[i] = (data[unique[i]] - center) * factor;
+        }
+        else
+        {
+            // one vertex per corner, which gives flat shading
+            vertex.resize(corners.size());
+            indexes.resize(corners.size());
+            for (size_t i = 0; i < corners.size(); ++i)
+            {
+                vertex[i] = (data[corners[i]] - center) * factor;
+                indexes[i] = (uint32_t)i;
+            }
+        }
+        corners = {};
+
+        // Chunk local, so normals are not smoothed across chunk borders
+        std::vector<glm::vec3> normals;
+        NormalGenerator::Generate(vertex.data(), vertex.size(), indexes.data(), indexes.size(), context.Options.Normals, normals);
+
+        chunk.Vertices.resize(vertex.size() * 2);
+        for (size_t i = 0; i < vertex.size(); ++i)
+        {
+            chunk.Vertices[i * 2] = vertex[i];
+            chunk.Vertices[i * 2 + 1] = normals[i];
+        }
+        chunk.Bounds = GetExtents(vertex.data(), sizeof(glm::vec3), vertex.size());
+    }
+
+    // Pass 3: chunks are built a few at a time and appended to the store
+    static bool WriteChunks(ObjStreamContext& context, const MappedFile& positions, const MappedFile& spill, const std::vector<std::vector<SpillRun>>& runs, ChunkStoreWriter& writer)
+    {
+        std::vector<uint32_t> filled;
+        for (uint32_t c = 0; c < context.ChunkCount; ++c)
+        {
+            if (!runs[c].empty())
+                filled.push_back(c);
+        }
+
+        // a chunk peaks at around 64 bytes per triangle while it is built
+        uint64_t chunkMemory = std::max<uint64_t>((uint64_t)context.Options.ChunkTriangles * 64, 1);
+        size_t batch = (size_t)std::clamp<uint64_t>(context.Options.StreamMemory / chunkMemory, 1, context.Pool->GetThreadCount() + 1);
+
+        for (size_t first = 0; first < filled.size(); first += batch)
+        {
+            size_t count = std::min(batch, filled.size() - first);
+            std::vector<BuiltChunk> built(count);
+            context.Pool->ParallelFor(count, [&](size_t i) { BuildChunk(context, positions, spill, runs[filled[first + i]], built[i]); });
+
+            for (auto& chunk : built)
+                writer.Add(chunk.Vertices, chunk.Indexes, chunk.Bounds);
+            positions.Discard(positions.begin(), positions.end());
+
+            if (!writer.IsValid() || context.IsCancelled())
+                return false;
+        }
+
+        return writer.Finish();
+    }
+
+    static bool Build(ObjStreamContext& context, const std::string& path, uint64_t key, const std::string& storePath)
+    {
+        std::string filename = std::filesystem::path(path).filename().u8string();
+
+        context.File = MappedFile::Create(path);
+        if (!context.File->IsValid())
+        {
+            LOG_ERROR("Could not open obj file '%s'", path.c_str());
+            return false;
+        }
+
+        if (context.Progress)
+            context.Progress->BytesTotal += context.File->Size() * 2;
+
+        context.Spans = SplitSpans(*context.File);
+
+        TemporaryFile positionsFile(storePath + ".positions.tmp");
+        if (!SpoolPositions(context, positionsFile.Path))
+        {
+            if (!context.IsCancelled())
+            {
+                LOG_ERROR("Could not spool the positions of '%s'", filename.c_str());
+            }
+            return false;
+        }
+
+        if (context.TriangleCount == 0 || context.PositionCount == 0)
+        {
+            LOG_ERROR("No faces found in obj file '%s'", filename.c_str());
+            return false;
+        }
+        if (context.PositionCount > UINT32_MAX)
+        {
+            LOG_ERROR("Too many positions in obj file '%s' (%llu)", filename.c_str(), (unsigned long long)context.PositionCount);
+            return false;
+        }
+
+        Ref<MappedFile> positions = MappedFile::Create(positionsFile.Path);
+        if (!positions->IsValid())
+            return false;
+
+        BuildChunks(context, *positions);
+        LOG_INFO("Streaming '%s': %llu positions, %llu triangles in %u chunks", filename.c_str(),
+            (unsigned long long)context.PositionCount, (unsigned long long)context.TriangleCount, context.ChunkCount);
+
+        TemporaryFile spillFile(storePath + ".triangles.tmp");
+        std::vector<std::vector<SpillRun>> runs;
+        if (!SpillTriangles(context, *positions, spillFile.Path, runs))
+        {
+            if (!context.IsCancelled())
+            {
+                LOG_ERROR("Could not spill the triangles of '%s'", filename.c_str());
+            }
+            return false;
+        }
+        context.File = nullptr;
+
+        if (context.Progress)
+            context.Progress->Stage = ImportStage::Processing;
+
+        Ref<MappedFile> spill = MappedFile::Create(spillFile.Path);
+        if (!spill->IsValid())
+            return false;
+
+        ChunkStoreWriter writer(storePath, key);
+        if (!writer.IsValid() || !WriteChunks(context, *positions, *spill, runs, writer))
+        {
+            if (!context.IsCancelled())
+            {
+                LOG_ERROR("Could not write the chunk store of '%s'", filename.c_str());
+            }
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ObjStreamer::Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress)
+    {
+        std::filesystem::path filepath = path.c_str();
+        std::string filename = filepath.filename().u8string();
+
+        // The store lives in the import cache directory under the cache key
+        uint64_t key;
+        if (!ImportCache::GetKey(path, options, key))
+        {
+            LOG_ERROR("Could not open obj file '%s'", filepath.u8string().c_str());
+            return false;
+        }
+        key = key * 31 + options.ChunkTriangles;
+
+        std::error_code error;
+        std::filesystem::create_directories(ImportCache::GetDirectory(), error);
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key);
+        std::string storePath = (std::filesystem::path(ImportCache::GetDirectory()) / hex).u8string() + ".chunks";
+
+        Ref<ChunkStore> store = options.UseCache ? ChunkStore::Open(storePath, key) : nullptr;
+        if (store)
+        {
+            LOG_INFO("Imported '%s' from chunk store", filename.c_str());
+        }
+        else
+        {
+            ObjStreamContext context;
+            context.Options = options;
+            context.Progress = progress;
+            context.Pool = &ThreadPool::Get();
+            context.Batch = context.Pool->GetThreadCount() + 1;
+
+            if (!Build(context, path, key, storePath))
+                return false;
+
+            store = ChunkStore::Open(storePath, key);
+            if (!store)
+            {
+                LOG_ERROR("Could not open the chunk store of '%s'", filename.c_str());
+                return false;
+            }
+        }
+
+        result.Path = path;
+        const auto& chunks = store->GetChunks();
+        for (uint32_t i = 0; i < chunks.size(); ++i)
+        {
+            Ref<MeshNode> node = CreateRef<MeshNode>();
+            node->Name = filepath.stem().u8string() + "_" + std::to_string(i);
+            node->Mesh_ = Mesh::Create();
+            *node->Mesh_->BoundingBox = { chunks[i].Min, chunks[i].Max };
+            node->Store = store;
+            node->Chunk = i;
+            result.Meshes.push_back(node);
+        }
+
+        return true;
+    }
+
+}
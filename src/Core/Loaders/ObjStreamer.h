@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Base.h"
+#include "ImportOptions.h"
+#include "ImportData.h"
+
+namespace GLMV {
+
+    // Out of core obj import for files larger than memory. Positions are
+    // spooled to disk, triangles are binned into spatial chunks on disk, and
+    // every chunk is then built on its own into a ChunkStore, so memory use
+    // is bounded by ImportOptions::StreamMemory rather than the file size.
+    // Only positions and faces are read: normals are generated per chunk.
+    class ObjStreamer
+    {
+        public:
+            // Builds the chunk store of the file, or reuses the one of an
+            // earlier import, and returns one node per chunk whose mesh stays
+            // empty until the scene pages it in
+            static bool Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress = nullptr);
+    };
+
+}
@@ -0,0 +1,686 @@
+#include "Ply.h"
+#include "MappedFile.h"
+#include "Importer.h"
+#include "Tokenizer.h"
+#include "Core/ThreadPool.h"
+#include "Core/Geometry/Extents.h"
+#include "Core/Geometry/NormalGenerator.h"
+#include "Core/Renderer/Mesh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+
+namespace GLMV {
+
+    enum class PlyFormat
+    {
+        Ascii = 0, BinaryLittleEndian, BinaryBigEndian
+    };
+
+    enum class PlyType : uint8_t
+    {
+        None = 0, Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64
+    };
+
+    struct PlyProperty
+    {
+        std::string Name;
+        PlyType Type = PlyType::None;
+        // Type of the item count of a list, None for scalars
+        PlyType CountType = PlyType::None;
+        // Byte offset inside a fixed size binary record
+        uint32_t Offset = 0;
+
+        bool IsList() const { return CountType != PlyType::None; }
+    };
+
+    struct PlyElement
+    {
+        std::string Name;
+        uint64_t Count = 0;
+        std::vector<PlyProperty> Properties;
+        // Size of a binary record, 0 when lists make it vary
+        uint32_t Stride = 0;
+
+        int Find(std::string_view name) const
+        {
+            for (size_t i = 0; i < Properties.size(); ++i)
+            {
+                if (Properties[i].Name == name)
+                    return (int)i;
+            }
+            return -1;
+        }
+    };
+
+    struct PlyHeader
+    {
+        PlyFormat Format = PlyFormat::Ascii;
+        std::vector<PlyElement> Elements;
+        // Where the records of the first element start
+        size_t DataOffset = 0;
+    };
+
+    // State of a single ply import
+    struct PlyContext
+    {
+        PlyHeader Header;
+        const char* Data = nullptr;
+        const char* End = nullptr;
+        uint64_t VertexCount = 0;
+
+        // Interleaved position and normal, like Mesh::Vertices
+        std::vector<glm::vec3> Vertices;
+        std::vector<glm::vec4> Colors;
+        std::vector<uint32_t> Indexes;
+        bool HasNormals = false;
+
+        bool IsBinary() const { return Header.Format != PlyFormat::Ascii; }
+        // Binary data is converted assuming a little endian host
+        bool IsSwapped() const { return Header.Format == PlyFormat::BinaryBigEndian; }
+        size_t Remaining() const { return End - Data; }
+    };
+
+    // Records handed to one ParallelFor index
+    static constexpr size_t s_BlockSize = 1 << 16;
+
+    static uint32_t SizeOf(PlyType type)
+    {
+        switch (type)
+        {
+            case PlyType::Int8:
+            case PlyType::UInt8:   return 1;
+            case PlyType::Int16:
+            case PlyType::UInt16:  return 2;
+            case PlyType::Int32:
+            case PlyType::UInt32:
+            case PlyType::Float32: return 4;
+            case PlyType::Float64: return 8;
+            default:               return 0;
+        }
+    }
+
+    static PlyType ParseType(std::string_view name)
+    {
+        if (name == "char" || name == "int8")       return PlyType::Int8;
+        if (name == "uchar" || name == "uint8")     return PlyType::UInt8;
+        if (name == "short" || name == "int16")     return PlyType::Int16;
+        if (name == "ushort" || name == "uint16")   return PlyType::UInt16;
+        if (name == "int" || name == "int32")       return PlyType::Int32;
+        if (name == "uint" || name == "uint32")     return PlyType::UInt32;
+        if (name == "float" || name == "float32")   return PlyType::Float32;
+        if (name == "double" || name == "float64")  return PlyType::Float64;
+        return PlyType::None;
+    }
+
+    static bool IsInteger(PlyType type)
+    {
+        return type != PlyType::None && type != PlyType::Float32 && type != PlyType::Float64;
+    }
+
+    // Maps integer color channels to [0, 1]
+    static float ColorScale(PlyType type)
+    {
+        switch (type)
+        {
+            case PlyType::Int8:   return 1.0f / INT8_MAX;
+            case PlyType::UInt8:  return 1.0f / UINT8_MAX;
+            case PlyType::Int16:  return 1.0f / INT16_MAX;
+            case PlyType::UInt16: return 1.0f / UINT16_MAX;
+            case PlyType::Int32:  return 1.0f / (float)INT32_MAX;
+            case PlyType::UInt32: return 1.0f / (float)UINT32_MAX;
+            default:              return 1.0f;
+        }
+    }
+
+    template<typename T>
+    static T LoadScalar(const char* data, bool swap)
+    {
+        char bytes[sizeof(T)];
+        memcpy(bytes, data, sizeof(T));
+        if (swap)
+            std::reverse(bytes, bytes + sizeof(T));
+
+        T value;
+        memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    static double LoadBinary(const char* data, PlyType type, bool swap)
+    {
+        switch (type)
+        {
+            case PlyType::Int8:    return (int8_t)*data;
+            case PlyType::UInt8:   return (uint8_t)*data;
+            case PlyType::Int16:   return LoadScalar<int16_t>(data, swap);
+            case PlyType::UInt16:  return LoadScalar<uint16_t>(data, swap);
+            case PlyType::Int32:   return LoadScalar<int32_t>(data, swap);
+            case PlyType::UInt32:  return LoadScalar<uint32_t>(data, swap);
+            case PlyType::Float32: return LoadScalar<float>(data, swap);
+            case PlyType::Float64: return LoadScalar<double>(data, swap);
+            default:               return 0.0;
+        }
+    }
+
+    // Negative and oversized indexes become UINT32_MAX, which is never valid
+    static uint32_t ToIndex(double value)
+    {
+        return value >= 0.0 && value < (double)UINT32_MAX ? (uint32_t)value : UINT32_MAX;
+    }
+
+    static bool ParseHeader(const char* begin, const char* end, PlyHeader& header)
+    {
+        Tokenizer tokenizer(begin, end);
+        if (tokenizer.Token() != "ply")
+            return false;
+        tokenizer.NextLine();
+
+        bool hasFormat = false;
+        while (!tokenizer.AtEnd())
+        {
+            std::string_view token = tokenizer.Token();
+
+            if (token == "format")
+            {
+                std::string_view format = tokenizer.Token();
+                if (format == "ascii")
+                    header.Format = PlyFormat::Ascii;
+                else if (format == "binary_little_endian")
+                    header.Format = PlyFormat::BinaryLittleEndian;
+                else if (format == "binary_big_endian")
+                    header.Format = PlyFormat::BinaryBigEndian;
+                else
+                    return false;
+                hasFormat = true;
+            }
+            else if (token == "element")
+            {
+                PlyElement& element = header.Elements.emplace_back();
+                element.Name = tokenizer.Token();
+                std::string_view count = tokenizer.Token();
+                if (std::from_chars(count.data(), count.data() + count.size(), element.Count).ec != std::errc())
+                    return false;
+            }
+            else if (token == "property")
+            {
+                if (header.Elements.empty())
+                    return false;
+
+                PlyProperty property;
+                std::string_view type = tokenizer.Token();
+                if (type == "list")
+                {
+                    property.CountType = ParseType(tokenizer.Token());
+                    if (!IsInteger(property.CountType))
+                        return false;
+                    type = tokenizer.Token();
+                }
+
+                property.Type = ParseType(type);
+                property.Name = tokenizer.Token();
+                if (property.Type == PlyType::None)
+                    return false;
+
+                header.Elements.back().Properties.push_back(property);
+            }
+            else if (token == "end_header")
+            {
+                tokenizer.NextLine();
+                header.DataOffset = tokenizer.GetPosition() - begin;
+
+                for (auto& element : header.Elements)
+                {
+                    uint32_t offset = 0;
+                    bool fixed = true;
+                    for (auto& property : element.Properties)
+                    {
+                        property.Offset = offset;
+                        offset += SizeOf(property.Type);
+                        fixed = fixed && !property.IsList();
+                    }
+                    element.Stride = fixed ? offset : 0;
+                }
+
+                return hasFormat;
+            }
+
+            // comment, obj_info and unknown keywords
+            tokenizer.NextLine();
+        }
+
+        return false;
+    }
+
+    // Reads ascii records, and binary ones with lists, one after the other
+    // since the start of a record is only known once the previous one was
+    // read
+    class PlyRecordReader
+    {
+        public:
+            PlyRecordReader(const PlyContext& context)
+                : m_Tokenizer(context.Data, context.End), m_Current(context.Data), m_End(context.End),
+                  m_Binary(context.IsBinary()), m_Swap(context.IsSwapped()) {}
+
+            const char* GetPosition() const { return m_Binary ? m_Current : m_Tokenizer.GetPosition(); }
+
+            // Scalars go to values[property], the items of the list property
+            // `list` are appended to items and any other list is skipped
+            bool Read(const PlyElement& element, double* values, int list, std::vector<uint32_t>& items)
+            {
+                return m_Binary ? ReadBinary(element, values, list, items) : ReadAscii(element, values, list, items);
+            }
+
+        private:
+            bool ReadBinary(const PlyElement& element, double* values, int list, std::vector<uint32_t>& items)
+            {
+                for (size_t p = 0; p < element.Properties.size(); ++p)
+                {
+                    const PlyProperty& property = element.Properties[p];
+                    if (!property.IsList())
+                    {
+                        uint32_t size = SizeOf(property.Type);
+                        if ((size_t)(m_End - m_Current) < size)
+                            return false;
+                        values[p] = LoadBinary(m_Current, property.Type, m_Swap);
+                        m_Current += size;
+                        continue;
+                    }
+
+                    uint32_t countSize = SizeOf(property.CountType), itemSize = SizeOf(property.Type);
+                    if ((size_t)(m_End - m_Current) < countSize)
+                        return false;
+                    double count = LoadBinary(m_Current, property.CountType, m_Swap);
+                    m_Current += countSize;
+                    if (count < 0.0 || count * itemSize > (double)(m_End - m_Current))
+                        return false;
+
+                    if ((int)p == list)
+                    {
+                        for (size_t i = 0; i < (size_t)count; ++i)
+                            items.push_back(ToIndex(LoadBinary(m_Current + i * itemSize, property.Type, m_Swap)));
+                    }
+                    m_Current += (size_t)count * itemSize;
+                }
+
+                return true;
+            }
+
+            bool ReadAscii(const PlyElement& element, double* values, int list, std::vector<uint32_t>& items)
+            {
+                // one record per line, blank lines do not count
+                while (!m_Tokenizer.AtEnd() && m_Tokenizer.AtLineEnd())
+                    m_Tokenizer.NextLine();
+
+                for (size_t p = 0; p < element.Properties.size(); ++p)
+                {
+                    const PlyProperty& property = element.Properties[p];
+                    if (!property.IsList())
+                    {
+                        if (!ReadValue(property.Type, values[p]))
+                            return false;
+                        continue;
+                    }
+
+                    int count = 0;
+                    if (!m_Tokenizer.Int(count) || count < 0)
+                        return false;
+
+                    for (int i = 0; i < count; ++i)
+                    {
+                        double value;
+                        if (!ReadValue(property.Type, value))
+                            return false;
+                        if ((int)p == list)
+                            items.push_back(ToIndex(value));
+                    }
+                }
+
+                m_Tokenizer.NextLine();
+                return true;
+            }
+
+            bool ReadValue(PlyType type, double& value)
+            {
+                if (IsInteger(type))
+                {
+                    int integer;
+                    if (!m_Tokenizer.Int(integer))
+                        return false;
+                    value = integer;
+                }
+                else
+                {
+                    float real;
+                    if (!m_Tokenizer.Float(real))
+                        return false;
+                    value = real;
+                }
+                return true;
+            }
+
+        private:
+            Tokenizer m_Tokenizer;
+            const char* m_Current;
+            const char* m_End;
+            bool m_Binary;
+            bool m_Swap;
+    };
+
+    // The vertex layout of Mesh::Vertices, which binary little endian files
+    // often have as is
+    static bool MatchesMeshLayout(const PlyElement& element)
+    {
+        static const char* names[] = { "x", "y", "z", "nx", "ny", "nz" };
+        if (element.Properties.size() != std::size(names))
+            return false;
+
+        for (size_t i = 0; i < std::size(names); ++i)
+        {
+            if (element.Properties[i].Name != names[i] || element.Properties[i].Type != PlyType::Float32)
+                return false;
+        }
+        return true;
+    }
+
+    static bool SkipElement(PlyContext& context, const PlyElement& element)
+    {
+        if (context.IsBinary() && element.Stride)
+        {
+            if (element.Count > context.Remaining() / element.Stride)
+                return false;
+            context.Data += element.Count * element.Stride;
+            return true;
+        }
+
+        PlyRecordReader reader(context);
+        std::vector<double> values(element.Properties.size());
+        std::vector<uint32_t> items;
+        for (uint64_t i = 0; i < element.Count; ++i)
+        {
+            if (!reader.Read(element, values.data(), -1, items))
+                return false;
+        }
+
+        context.Data = reader.GetPosition();
+        return true;
+    }
+
+    static bool ReadVertices(PlyContext& context, const PlyElement& element)
+    {
+        int position[3] = { element.Find("x"), element.Find("y"), element.Find("z") };
+        int normal[3] = { element.Find("nx"), element.Find("ny"), element.Find("nz") };
+        int color[4] = { element.Find("red"), element.Find("green"), element.Find("blue"), element.Find("alpha") };
+        if (position[0] < 0 || position[1] < 0 || position[2] < 0)
+            return false;
+
+        // Every record takes at least a byte, which keeps a broken count
+        // from allocating more than the file could hold
+        if (element.Count > context.Remaining() || (context.IsBinary() && element.Stride && element.Count > context.Remaining() / element.Stride))
+            return false;
+
+        bool hasNormals = normal[0] >= 0 && normal[1] >= 0 && normal[2] >= 0;
+        bool hasColors = color[0] >= 0 && color[1] >= 0 && color[2] >= 0;
+
+        float scale[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (int c = 0; c < 4; ++c)
+        {
+            if (color[c] >= 0)
+                scale[c] = ColorScale(element.Properties[color[c]].Type);
+        }
+
+        size_t count = (size_t)element.Count;
+        context.Vertices.assign(count * 2, glm::vec3(0.0f));
+        if (hasColors)
+            context.Colors.resize(count);
+        context.HasNormals = hasNormals;
+
+        auto assign = [&](size_t i, const auto& value) {
+            context.Vertices[i * 2] = glm::vec3(value(position[0]), value(position[1]), value(position[2]));
+            if (hasNormals)
+                context.Vertices[i * 2 + 1] = glm::vec3(value(normal[0]), value(normal[1]), value(normal[2]));
+            if (hasColors)
+            {
+                context.Colors[i] = glm::vec4(value(color[0]) * scale[0], value(color[1]) * scale[1], value(color[2]) * scale[2],
+                    color[3] >= 0 ? value(color[3]) * scale[3] : 1.0f);
+            }
+        };
+
+        if (context.IsBinary() && element.Stride)
+        {
+            const char* data = context.Data;
+            uint32_t stride = element.Stride;
+            if (!context.IsSwapped() && MatchesMeshLayout(element))
+            {
+                memcpy(context.Vertices.data(), data, count * stride);
+            }
+            else
+            {
+                bool swap = context.IsSwapped();
+                ParallelForBlocks(&ThreadPool::Get(), count, s_BlockSize, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        const char* record = data + i * stride;
+                        assign(i, [&](int p) {
+                            const PlyProperty& property = element.Properties[p];
+                            return (float)LoadBinary(record + property.Offset, property.Type, swap);
+                        });
+                    }
+                });
+            }
+
+            context.Data += count * stride;
+            return true;
+        }
+
+        PlyRecordReader reader(context);
+        std::vector<double> values(element.Properties.size());
+        std::vector<uint32_t> items;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!reader.Read(element, values.data(), -1, items))
+                return false;
+            assign(i, [&](int p) { return (float)values[p]; });
+        }
+
+        context.Data = reader.GetPosition();
+        return true;
+    }
+
+    // Binary little endian triangles with a one byte count and 32 bit
+    // indexes, the usual output of scanners. Every record is then 13 bytes
+    // and they are read in parallel. Returns false, with nothing consumed,
+    // as soon as a face turns out not to be a triangle.
+    static bool ReadTriangles(PlyContext& context, const PlyElement& element)
+    {
+        if (context.Header.Format != PlyFormat::BinaryLittleEndian || element.Properties.size() != 1)
+            return false;
+
+        const PlyProperty& property = element.Properties[0];
+        if (SizeOf(property.CountType) != 1 || SizeOf(property.Type) != 4 || !IsInteger(property.Type))
+            return false;
+
+        const size_t stride = 1 + 3 * sizeof(uint32_t);
+        if (element.Count > context.Remaining() / stride)
+            return false;
+
+        size_t count = (size_t)element.Count;
+        const char* data = context.Data;
+        std::vector<uint32_t>& indexes = context.Indexes;
+        indexes.resize(count * 3);
+
+        std::atomic<bool> triangles{ true };
+        ParallelForBlocks(&ThreadPool::Get(), count, s_BlockSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end && triangles.load(std::memory_order_relaxed); ++i)
+            {
+                const char* record = data + i * stride;
+                if ((uint8_t)record[0] != 3)
+                {
+                    triangles = false;
+                    return;
+                }
+                memcpy(indexes.data() + i * 3, record + 1, 3 * sizeof(uint32_t));
+            }
+        });
+
+        if (!triangles)
+        {
+            indexes.clear();
+            return false;
+        }
+
+        context.Data += count * stride;
+        return true;
+    }
+
+    static bool ReadFaces(PlyContext& context, const PlyElement& element)
+    {
+        int list = element.Find("vertex_indices");
+        if (list < 0)
+            list = element.Find("vertex_index");
+        if (list < 0 || !element.Properties[list].IsList())
+            return SkipElement(context, element);
+
+        if (!ReadTriangles(context, element))
+        {
+            PlyRecordReader reader(context);
+            std::vector<double> values(element.Properties.size());
+            std::vector<uint32_t> items;
+            std::vector<uint32_t>& indexes = context.Indexes;
+            indexes.reserve((size_t)element.Count * 3);
+
+            for (uint64_t i = 0; i < element.Count; ++i)
+            {
+                items.clear();
+                if (!reader.Read(element, values.data(), list, items))
+                    return false;
+
+                // triangulated as a fan, points and lines are dropped
+                for (size_t k = 1; k + 1 < items.size(); ++k)
+                    indexes.insert(indexes.end(), { items[0], items[k], items[k + 1] });
+            }
+
+            context.Data = reader.GetPosition();
+        }
+
+        uint64_t vertexCount = context.VertexCount;
+        return std::all_of(context.Indexes.begin(), context.Indexes.end(), [vertexCount](uint32_t idx) { return idx < vertexCount; });
+    }
+
+    bool PlyLoader::Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress)
+    {
+        std::filesystem::path filepath = path.c_str();
+        std::string filename = filepath.filename().u8string();
+
+        Ref<MappedFile> file = MappedFile::Create(path);
+        if (!file->IsValid())
+        {
+            LOG_ERROR("Could not open ply file '%s'", filepath.u8string().c_str());
+            return false;
+        }
+
+        if (progress)
+            progress->BytesTotal += file->Size();
+
+        PlyContext context;
+        if (!ParseHeader(file->begin(), file->end(), context.Header))
+        {
+            LOG_ERROR("Invalid ply header in '%s'", filename.c_str());
+            return false;
+        }
+
+        auto& elements = context.Header.Elements;
+        auto vertexElement = std::find_if(elements.begin(), elements.end(), [](const PlyElement& element) { return element.Name == "vertex"; });
+        if (vertexElement == elements.end() || vertexElement->Count == 0 || vertexElement->Count >= UINT32_MAX)
+        {
+            LOG_ERROR("No vertices found in ply file '%s'", filename.c_str());
+            return false;
+        }
+
+        context.VertexCount = vertexElement->Count;
+        context.Data = file->begin() + context.Header.DataOffset;
+        context.End = file->end();
+        if (progress)
+            progress->BytesRead += context.Header.DataOffset;
+
+        for (const auto& element : elements)
+        {
+            if (progress && progress->IsCancelled())
+                return false;
+
+            const char* start = context.Data;
+            bool read;
+            if (element.Name == "vertex")
+                read = ReadVertices(context, element);
+            else if (element.Name == "face")
+                read = ReadFaces(context, element);
+            else
+                read = SkipElement(context, element);
+
+            if (!read)
+            {
+                LOG_ERROR("Could not read the %s element of '%s'", element.Name.c_str(), filename.c_str());
+                return false;
+            }
+
+            if (progress)
+                progress->BytesRead += context.Data - start;
+        }
+
+        if (progress)
+        {
+            progress->Triangles += context.Indexes.size() / 3;
+            progress->Stage = ImportStage::Processing;
+        }
+
+        Ref<Mesh> mesh = Mesh::Create();
+        std::vector<glm::vec3>& vertices = *mesh->Vertices;
+        std::vector<glm::vec3>& positions = *mesh->Vertex;
+        vertices = std::move(context.Vertices);
+        *mesh->Indexes = std::move(context.Indexes);
+        *mesh->Colors = std::move(context.Colors);
+
+        size_t count = vertices.size() / 2;
+        positions.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            positions[i] = vertices[i * 2];
+
+        const std::vector<uint32_t>& indexes = *mesh->Indexes;
+        if (!context.HasNormals && !indexes.empty())
+        {
+            std::vector<glm::vec3> normals;
+            NormalGenerator::Generate(positions.data(), count, indexes.data(), indexes.size(), options.Normals, normals, &ThreadPool::Get());
+            for (size_t i = 0; i < count; ++i)
+                vertices[i * 2 + 1] = normals[i];
+        }
+
+        // scaling
+        CenterAndScale(positions.data(), sizeof(glm::vec3), count, 1);
+        for (size_t i = 0; i < count; ++i)
+            vertices[i * 2] = positions[i];
+
+        *mesh->Normals = vertices;
+        *mesh->BoundingBox = GetExtents(positions.data(), sizeof(glm::vec3), count);
+
+        Ref<MeshNode> node = CreateRef<MeshNode>();
+        node->Mesh_ = mesh;
+        node->Name = filepath.stem().u8string();
+
+        result.Path = path;
+        result.Meshes.push_back(node);
+
+        if (indexes.empty())
+        {
+            LOG_INFO("Imported '%s': %zu points, no faces", filename.c_str(), count);
+        }
+        else
+        {
+            LOG_INFO("Imported '%s': %zu vertices, %zu triangles", filename.c_str(), count, indexes.size() / 3);
+        }
+
+        return true;
+    }
+
+}
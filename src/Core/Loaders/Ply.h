@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Base.h"
+#include "ImportOptions.h"
+#include "ImportData.h"
+#include <Core/Scene/Scene.h>
+
+namespace GLMV {
+
+    // Stanford PLY files in ascii or binary encoding. Reads positions,
+    // normals and colors of the vertex element and the polygons of the face
+    // element, fanned into triangles the same way as obj faces. Files
+    // without faces come in as point clouds.
+    class PlyLoader
+    {
+        public:
+            // Reads the file without touching the scene, so it can run on a
+            // worker thread
+            static bool Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress = nullptr);
+    };
+}
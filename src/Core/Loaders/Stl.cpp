@@ -0,0 +1,249 @@
+#include "Stl.h"
+#include "MappedFile.h"
+#include "ImportCache.h"
+#include "Importer.h"
+#include "Tokenizer.h"
+#include "Core/ThreadPool.h"
+#include "Core/Geometry/Extents.h"
+#include "Core/Geometry/NormalGenerator.h"
+#include "Core/Geometry/VertexWelder.h"
+#include "Core/Renderer/Mesh.h"
+
+#include <cstring>
+#include <filesystem>
+
+namespace GLMV {
+
+    // 80 byte header and the triangle count, then one record per triangle:
+    // facet normal, three corners and a 16 bit attribute
+    static constexpr size_t s_HeaderSize = 84;
+    static constexpr size_t s_RecordSize = 50;
+    static constexpr size_t s_BlockSize = 1 << 16;
+
+    static uint32_t GetTriangleCount(const MappedFile& file)
+    {
+        uint32_t triangles;
+        memcpy(&triangles, file.Data() + 80, sizeof(triangles));
+        return triangles;
+    }
+
+    // Binary files may start with "solid" as well, so the size decides
+    static bool IsBinary(const MappedFile& file)
+    {
+        if (file.Size() < s_HeaderSize)
+            return false;
+
+        uint64_t expected = s_HeaderSize + (uint64_t)GetTriangleCount(file) * s_RecordSize;
+        if (expected == file.Size())
+            return true;
+
+        // some exporters pad the end of the file
+        return expected < file.Size() && strncmp(file.Data(), "solid", 5) != 0;
+    }
+
+    // Materialise style "COLOR=" rgba bytes in the header give the color
+    // of the whole part
+    static Ref<Material> GetHeaderColor(const MappedFile& file)
+    {
+        static const char tag[] = "COLOR=";
+        const size_t tagSize = sizeof(tag) - 1;
+
+        for (size_t i = 0; i + tagSize + 4 <= 80; ++i)
+        {
+            if (memcmp(file.Data() + i, tag, tagSize) != 0)
+                continue;
+
+            const uint8_t* rgba = (const uint8_t*)file.Data() + i + tagSize;
+            Ref<Material> material = CreateRef<Material>();
+            material->Name = "COLOR";
+            material->Diffuse = glm::vec3(rgba[0], rgba[1], rgba[2]) / 255.0f;
+            return material;
+        }
+
+        return nullptr;
+    }
+
+    static bool ParseAscii(const char* begin, const char* end, std::vector<glm::vec3>& corners)
+    {
+        Tokenizer tokenizer(begin, end);
+        if (tokenizer.Token() != "solid")
+            return false;
+
+        for (tokenizer.NextLine(); !tokenizer.AtEnd(); tokenizer.NextLine())
+        {
+            if (tokenizer.Token() != "vertex")
+                continue;
+
+            glm::vec3 corner;
+            if (!tokenizer.Float(corner.x) || !tokenizer.Float(corner.y) || !tokenizer.Float(corner.z))
+                return false;
+            corners.push_back(corner);
+        }
+
+        return corners.size() % 3 == 0;
+    }
+
+    bool StlLoader::Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress)
+    {
+        std::filesystem::path filepath = path.c_str();
+
+        ImportResult imported;
+        imported.Path = path;
+
+        if (options.UseCache && ImportCache::Load(path, options, imported.Meshes, imported.Materials, imported.Dependencies))
+        {
+            LOG_INFO("Imported '%s' from cache", filepath.filename().u8string().c_str());
+        }
+        else
+        {
+            if (!Process(path, options, imported, progress))
+                return false;
+
+            if (options.UseCache)
+                ImportCache::Store(path, options, imported.Meshes, imported.Materials, imported.Dependencies);
+        }
+
+        result = std::move(imported);
+        return true;
+    }
+
+    bool StlLoader::Process(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress)
+    {
+        std::filesystem::path filepath = path.c_str();
+        std::string filename = filepath.filename().u8string();
+
+        Ref<MappedFile> file = MappedFile::Create(path);
+        if (!file->IsValid())
+        {
+            LOG_ERROR("Could not open stl file '%s'", filepath.u8string().c_str());
+            return false;
+        }
+
+        if (progress)
+            progress->BytesTotal += file->Size();
+
+        // Binary corners are read straight from the mapping, ascii ones
+        // are parsed into corners first
+        PositionStream positions;
+        std::vector<glm::vec3> corners;
+        Ref<Material> material;
+
+        if (IsBinary(*file))
+        {
+            positions.Data = file->Data() + s_HeaderSize + sizeof(glm::vec3);
+            positions.Count = (size_t)GetTriangleCount(*file) * 3;
+            positions.GroupSize = 3;
+            positions.GroupStride = s_RecordSize;
+            material = GetHeaderColor(*file);
+        }
+        else
+        {
+            if (!ParseAscii(file->begin(), file->end(), corners))
+            {
+                LOG_ERROR("Invalid stl file '%s'", filename.c_str());
+                return false;
+            }
+
+            positions.Data = (const char*)corners.data();
+            positions.Count = corners.size();
+        }
+
+        if (positions.Count == 0 || positions.Count >= 0x80000000u)
+        {
+            LOG_ERROR("Unsupported triangle count in stl file '%s'", filename.c_str());
+            return false;
+        }
+
+        if (progress)
+        {
+            progress->BytesRead += file->Size();
+            progress->Triangles += positions.Count / 3;
+            progress->Stage = ImportStage::Processing;
+            if (progress->IsCancelled())
+                return false;
+        }
+
+        ThreadPool& pool = ThreadPool::Get();
+        Ref<Mesh> mesh = Mesh::Create();
+        std::vector<glm::vec3>& vertex = *mesh->Vertex;
+        std::vector<uint32_t>& indexes = *mesh->Indexes;
+
+        if (options.WeldVertices)
+        {
+            VertexWelder::Weld(positions, vertex, indexes, &pool);
+
+            if (options.WeldEpsilon > 0.0f)
+            {
+                std::vector<uint32_t> remap;
+                size_t count = VertexWelder::WeldPositions(vertex, options.WeldEpsilon, remap);
+
+                // keep the representatives only
+                std::vector<uint32_t> slots(vertex.size(), UINT32_MAX);
+                std::vector<glm::vec3> kept;
+                kept.reserve(count);
+                for (auto& idx : indexes)
+                {
+                    uint32_t& slot = slots[remap[idx]];
+                    if (slot == UINT32_MAX)
+                    {
+                        slot = (uint32_t)kept.size();
+                        kept.push_back(vertex[remap[idx]]);
+                    }
+                    idx = slot;
+                }
+                LOG_INFO("Welded %zu positions into %zu (epsilon %g)", vertex.size(), kept.size(), options.WeldEpsilon);
+                vertex = std::move(kept);
+            }
+        }
+        else
+        {
+            // one vertex per corner, which gives flat shading
+            vertex.resize(positions.Count);
+            indexes.resize(positions.Count);
+            ParallelForBlocks(&pool, positions.Count, s_BlockSize, [&](size_t begin, size_t end) {
+                positions.ForEach(begin, end, [&](size_t i, const glm::vec3& position) {
+                    vertex[i] = position;
+                    indexes[i] = (uint32_t)i;
+                });
+            });
+        }
+
+        corners = {};
+        file = nullptr;
+
+        if (progress && progress->IsCancelled())
+            return false;
+
+        std::vector<glm::vec3> normals;
+        NormalGenerator::Generate(vertex.data(), vertex.size(), indexes.data(), indexes.size(), options.Normals, normals, &pool);
+
+        // scaling
+        CenterAndScale(vertex.data(), sizeof(glm::vec3), vertex.size(), 1);
+
+        std::vector<glm::vec3>& vertices = *mesh->Vertices;
+        vertices.resize(vertex.size() * 2);
+        ParallelForBlocks(&pool, vertex.size(), s_BlockSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                vertices[i * 2] = vertex[i];
+                vertices[i * 2 + 1] = normals[i];
+            }
+        });
+        *mesh->Normals = vertices;
+        *mesh->BoundingBox = GetExtents(vertex.data(), sizeof(glm::vec3), vertex.size());
+
+        Ref<MeshNode> node = CreateRef<MeshNode>();
+        node->Mesh_ = mesh;
+        node->Name = filepath.stem().u8string();
+        if (material)
+        {
+            node->Material_ = material->Name;
+            result.Materials[material->Name] = material;
+        }
+        result.Meshes.push_back(node);
+
+        LOG_INFO("Imported '%s': %zu corners -> %zu vertices (%.2fx fewer)", filename.c_str(), indexes.size(), vertex.size(), (double)indexes.size() / vertex.size());
+        return true;
+    }
+
+}
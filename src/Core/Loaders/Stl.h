@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Base.h"
+#include "ImportOptions.h"
+#include "ImportData.h"
+#include <Core/Scene/Scene.h>
+
+namespace GLMV {
+
+    // Binary and ascii STL files. Triangles are stored without sharing
+    // vertices, so their corners are welded by position into an indexed
+    // mesh. Facet normals are ignored and smooth ones generated instead.
+    class StlLoader
+    {
+        public:
+            // Reads the file without touching the scene, so it can run on a
+            // worker thread
+            static bool Import(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress = nullptr);
+        private:
+            static bool Process(const std::string& path, const ImportOptions& options, ImportResult& result, ImportProgress* progress);
+    };
+}
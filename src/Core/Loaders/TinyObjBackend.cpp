@@ -0,0 +1,134 @@
+#include "ObjBackend.h"
+#include "ImportData.h"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+#include <filesystem>
+
+namespace GLMV {
+
+    bool TinyObjBackend::Parse(const std::string& path, ObjData& data, ImportProgress* progress)
+    {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(path, error);
+        if (progress && !error)
+            progress->BytesTotal += size;
+
+        // Polygons are fanned below, the same way ObjParser does, so both
+        // backends produce the same triangles
+        tinyobj::ObjReaderConfig config;
+        config.triangulate = false;
+        config.vertex_color = false;
+        config.mtl_search_path = std::filesystem::path(path).parent_path().u8string();
+
+        tinyobj::ObjReader reader;
+        if (!reader.ParseFromFile(path, config))
+        {
+            LOG_ERROR("tinyobjloader: %s", reader.Error().c_str());
+            return false;
+        }
+
+        if (progress)
+        {
+            progress->BytesRead += size;
+            if (progress->IsCancelled())
+                return false;
+        }
+
+        const tinyobj::attrib_t& attrib = reader.GetAttrib();
+        const glm::vec3* positions = (const glm::vec3*)attrib.vertices.data();
+        const glm::vec2* texCoords = (const glm::vec2*)attrib.texcoords.data();
+        const glm::vec3* normals = (const glm::vec3*)attrib.normals.data();
+        data.Positions.assign(positions, positions + attrib.vertices.size() / 3);
+        data.TexCoords.assign(texCoords, texCoords + attrib.texcoords.size() / 2);
+        data.Normals.assign(normals, normals + attrib.normals.size() / 3);
+
+        const auto& materials = reader.GetMaterials();
+        for (const auto& source : materials)
+        {
+            Ref<Material> material = CreateRef<Material>();
+            material->Name = source.name;
+            material->Diffuse = { source.diffuse[0], source.diffuse[1], source.diffuse[2] };
+            material->Opacity = source.dissolve;
+            data.Materials[source.name] = material;
+        }
+
+        // tinyobjloader does not report which mtllib files it opened, every
+        // mtl file next to the obj stands in for them
+        for (const auto& entry : std::filesystem::directory_iterator(config.mtl_search_path.empty() ? "." : config.mtl_search_path, error))
+        {
+            if (entry.path().extension() == ".mtl")
+                data.MaterialFiles.push_back(entry.path().u8string());
+        }
+
+        // One group per run of faces with the same material inside a shape
+        uint64_t triangles = 0;
+        for (const auto& shape : reader.GetShapes())
+        {
+            const tinyobj::mesh_t& mesh = shape.mesh;
+            ObjGroup* group = nullptr;
+            int material = -2;
+            bool hasTexCoords = false, hasNormals = false;
+
+            auto finish = [&]() {
+                if (!group)
+                    return;
+                if (!hasTexCoords)
+                    group->TexCoordIndexes.clear();
+                if (!hasNormals)
+                    group->NormalIndexes.clear();
+            };
+
+            size_t offset = 0;
+            for (size_t face = 0; face < mesh.num_face_vertices.size(); ++face)
+            {
+                size_t count = mesh.num_face_vertices[face];
+                const tinyobj::index_t* corners = mesh.indices.data() + offset;
+                offset += count;
+                if (count < 3)
+                    continue;
+
+                int id = face < mesh.material_ids.size() ? mesh.material_ids[face] : -1;
+                if (!group || id != material)
+                {
+                    finish();
+                    group = &data.Groups.emplace_back();
+                    group->Name = shape.name;
+                    group->Material = id >= 0 && id < (int)materials.size() ? materials[id].name : std::string();
+                    material = id;
+                    hasTexCoords = hasNormals = false;
+                }
+
+                auto push = [&](const tinyobj::index_t& corner) {
+                    group->Indexes.push_back((uint32_t)corner.vertex_index);
+                    group->TexCoordIndexes.push_back(corner.texcoord_index < 0 ? ObjParser::None : (uint32_t)corner.texcoord_index);
+                    group->NormalIndexes.push_back(corner.normal_index < 0 ? ObjParser::None : (uint32_t)corner.normal_index);
+                    hasTexCoords |= corner.texcoord_index >= 0;
+                    hasNormals |= corner.normal_index >= 0;
+                };
+
+                for (size_t i = 2; i < count; ++i)
+                {
+                    push(corners[0]);
+                    push(corners[i - 1]);
+                    push(corners[i]);
+                }
+                triangles += count - 2;
+            }
+
+            finish();
+        }
+
+        if (progress)
+            progress->Triangles += triangles;
+
+        size_t removed = ObjParser::RemoveInvalidTriangles(data);
+        if (removed)
+        {
+            LOG_WARN("Dropped %zu triangles referencing missing vertices", removed);
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Base.h"
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+namespace GLMV {
+
+    // Walks a text buffer in place, one line at a time, without allocating.
+    // Used by the loaders that read mapped files.
+    class Tokenizer
+    {
+        public:
+            Tokenizer(const char* begin, const char* end)
+                : m_Current(begin), m_End(end) {}
+
+            bool AtEnd() const { return m_Current >= m_End; }
+            const char* GetPosition() const { return m_Current; }
+
+            bool AtLineEnd()
+            {
+                SkipSpaces();
+                return m_Current >= m_End || *m_Current == '\n' || *m_Current == '\r';
+            }
+
+            void SkipSpaces()
+            {
+                while (m_Current < m_End && (*m_Current == ' ' || *m_Current == '\t'))
+                    ++m_Current;
+            }
+
+            // Moves past the next '\n'
+            void NextLine()
+            {
+                const char* eol = (const char*)memchr(m_Current, '\n', m_End - m_Current);
+                m_Current = eol ? eol + 1 : m_End;
+            }
+
+            // Next run of non blank characters on this line
+            std::string_view Token()
+            {
+                SkipSpaces();
+                const char* start = m_Current;
+                while (m_Current < m_End && !IsDelimiter(*m_Current))
+                    ++m_Current;
+                return std::string_view(start, m_Current - start);
+            }
+
+            // Moves to the end of the token the cursor is in
+            void SkipToken()
+            {
+                while (m_Current < m_End && !IsDelimiter(*m_Current))
+                    ++m_Current;
+            }
+
+            // Whatever is left on this line, without surrounding blanks
+            std::string_view Rest()
+            {
+                SkipSpaces();
+                const char* start = m_Current;
+                while (m_Current < m_End && *m_Current != '\n' && *m_Current != '\r')
+                    ++m_Current;
+                const char* stop = m_Current;
+                while (stop > start && (stop[-1] == ' ' || stop[-1] == '\t'))
+                    --stop;
+                return std::string_view(start, stop - start);
+            }
+
+            bool Consume(char c)
+            {
+                if (m_Current < m_End && *m_Current == c)
+                {
+                    ++m_Current;
+                    return true;
+                }
+                return false;
+            }
+
+            bool Float(float& value)
+            {
+                SkipSpaces();
+                // from_chars rejects an explicit plus sign
+                if (m_Current < m_End && *m_Current == '+')
+                    ++m_Current;
+                auto result = std::from_chars(m_Current, m_End, value);
+                if (result.ec != std::errc())
+                    return false;
+                m_Current = result.ptr;
+                return true;
+            }
+
+            template<typename T>
+            bool Int(T& value)
+            {
+                SkipSpaces();
+                if (m_Current < m_End && *m_Current == '+')
+                    ++m_Current;
+                auto result = std::from_chars(m_Current, m_End, value);
+                if (result.ec != std::errc())
+                    return false;
+                m_Current = result.ptr;
+                return true;
+            }
+
+        private:
+            static bool IsDelimiter(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+            const char* m_Current;
+            const char* m_End;
+    };
+
+}
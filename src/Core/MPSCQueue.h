@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace GLMV {
+
+    // Unbounded lock-free queue for many producers and a single consumer
+    // (Vyukov's intrusive MPSC queue with a stub node). Push never blocks,
+    // Pop is only called from the consumer thread.
+    template<typename T>
+    class MPSCQueue
+    {
+        public:
+            MPSCQueue()
+            {
+                Node* stub = new Node();
+                m_Head.store(stub, std::memory_order_relaxed);
+                m_Tail = stub;
+            }
+
+            ~MPSCQueue()
+            {
+                T value;
+                while (Pop(value)) {}
+                delete m_Tail;
+            }
+
+            MPSCQueue(const MPSCQueue&) = delete;
+            MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+            void Push(T value)
+            {
+                Node* node = new Node();
+                node->Value = std::move(value);
+                Node* previous = m_Head.exchange(node, std::memory_order_acq_rel);
+                previous->Next.store(node, std::memory_order_release);
+            }
+
+            bool Pop(T& value)
+            {
+                Node* next = m_Tail->Next.load(std::memory_order_acquire);
+                if (!next)
+                    return false;
+
+                value = std::move(next->Value);
+                delete m_Tail;
+                m_Tail = next;
+                return true;
+            }
+
+        private:
+            struct Node
+            {
+                std::atomic<Node*> Next{ nullptr };
+                T Value{};
+            };
+
+            std::atomic<Node*> m_Head;
+            Node* m_Tail;
+    };
+
+}
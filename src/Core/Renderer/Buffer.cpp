@@ -12,6 +12,12 @@ namespace GLMV {
         glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
     }
 
+    VertexBuffer::VertexBuffer(uint32_t size)
+    {
+        glCreateBuffers(1, &m_RendererID);
+        glNamedBufferData(m_RendererID, size, nullptr, GL_STATIC_DRAW);
+    }
+
     VertexBuffer::~VertexBuffer()
     {
         glDeleteBuffers(1, &m_RendererID);
@@ -27,12 +33,26 @@ namespace GLMV {
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
-    IndexBuffer::IndexBuffer(uint32_t* indices, uint32_t count)
-        : m_Count(count)
+    void VertexBuffer::SetData(const void* data, uint32_t size, uint32_t offset)
+    {
+        glNamedBufferSubData(m_RendererID, offset, size, data);
+    }
+
+    IndexBuffer::IndexBuffer(uint32_t* indices, uint32_t count, IndexType type)
+        : m_Count(count), m_Type(type)
     {
         glCreateBuffers(1, &m_RendererID);
         glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
-        glBufferData(GL_ARRAY_BUFFER, count * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, count * IndexTypeSize(type), type == IndexType::UInt32 ? indices : nullptr, GL_STATIC_DRAW);
+        if (type == IndexType::UInt16)
+            SetData(indices, count);
+    }
+
+    IndexBuffer::IndexBuffer(uint32_t count, IndexType type)
+        : m_Count(count), m_Type(type)
+    {
+        glCreateBuffers(1, &m_RendererID);
+        glNamedBufferData(m_RendererID, count * IndexTypeSize(type), nullptr, GL_STATIC_DRAW);
     }
 
     IndexBuffer::~IndexBuffer()
@@ -49,4 +69,91 @@ namespace GLMV {
     {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
+
+    void IndexBuffer::SetData(const uint32_t* indices, uint32_t count, uint32_t offset)
+    {
+        if (m_Type == IndexType::UInt32)
+        {
+            glNamedBufferSubData(m_RendererID, offset * sizeof(uint32_t), count * sizeof(uint32_t), indices);
+            return;
+        }
+
+        std::vector<uint16_t> narrowed(indices, indices + count);
+        glNamedBufferSubData(m_RendererID, offset * sizeof(uint16_t), count * sizeof(uint16_t), narrowed.data());
+    }
+
+    UniformBuffer::UniformBuffer(uint32_t size, uint32_t binding)
+    {
+        glCreateBuffers(1, &m_RendererID);
+        glNamedBufferData(m_RendererID, size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_RendererID);
+    }
+
+    UniformBuffer::~UniformBuffer()
+    {
+        glDeleteBuffers(1, &m_RendererID);
+    }
+
+    void UniformBuffer::SetData(const void* data, uint32_t size, uint32_t offset)
+    {
+        glNamedBufferSubData(m_RendererID, offset, size, data);
+    }
+
+    StorageBuffer::StorageBuffer(uint32_t size, uint32_t binding)
+        : m_Capacity(size)
+    {
+        glCreateBuffers(1, &m_RendererID);
+        glNamedBufferData(m_RendererID, size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_RendererID);
+    }
+
+    StorageBuffer::~StorageBuffer()
+    {
+        glDeleteBuffers(1, &m_RendererID);
+    }
+
+    void StorageBuffer::SetData(const void* data, uint32_t size)
+    {
+        if (size > m_Capacity)
+        {
+            // Doubling keeps reallocations rare while the scene grows
+            m_Capacity = std::max(size, m_Capacity * 2);
+            glNamedBufferData(m_RendererID, m_Capacity, nullptr, GL_DYNAMIC_DRAW);
+        }
+
+        // Orphans the storage the previous frame may still be reading
+        glInvalidateBufferData(m_RendererID);
+        glNamedBufferSubData(m_RendererID, 0, size, data);
+    }
+
+
+    IndirectBuffer::IndirectBuffer(uint32_t size)
+        : m_Capacity(size)
+    {
+        glCreateBuffers(1, &m_RendererID);
+        glNamedBufferData(m_RendererID, size, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    IndirectBuffer::~IndirectBuffer()
+    {
+        glDeleteBuffers(1, &m_RendererID);
+    }
+
+    void IndirectBuffer::Bind() const
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_RendererID);
+    }
+
+    void IndirectBuffer::SetData(const void* data, uint32_t size)
+    {
+        if (size > m_Capacity)
+        {
+            m_Capacity = std::max(size, m_Capacity * 2);
+            glNamedBufferData(m_RendererID, m_Capacity, nullptr, GL_DYNAMIC_DRAW);
+        }
+
+        glInvalidateBufferData(m_RendererID);
+        glNamedBufferSubData(m_RendererID, 0, size, data);
+    }
+
 }
@@ -4,7 +4,11 @@ namespace GLMV {
 
     enum class ShaderDataType
     {
-        None = 0, Float, Float2, Float3, Float4, Mat3, Mat4, Int, Int2, Int3, Int4, Bool
+        None = 0, Float, Float2, Float3, Float4, Mat3, Mat4, Int, Int2, Int3, Int4, Bool,
+        // Packed vertex formats, read as floats by the shader. Set
+        // BufferElement::Normalized for the integer ones to map them to
+        // [0, 1] or [-1, 1].
+        UShort4, Short2, Int2101010, Half2
     };
 
     static uint32_t ShaderDataTypeSize(ShaderDataType type)
@@ -22,6 +26,10 @@ namespace GLMV {
             case ShaderDataType::Int3:     return 4 * 3;
             case ShaderDataType::Int4:     return 4 * 4;
             case ShaderDataType::Bool:     return 1;
+            case ShaderDataType::UShort4:  return 2 * 4;
+            case ShaderDataType::Short2:   return 2 * 2;
+            case ShaderDataType::Int2101010: return 4;
+            case ShaderDataType::Half2:    return 2 * 2;
         }
 
         GLMV_ASSERT(false, "Unknown ShaderDataType!");
@@ -58,6 +66,10 @@ namespace GLMV {
                 case ShaderDataType::Int3:    return 3;
                 case ShaderDataType::Int4:    return 4;
                 case ShaderDataType::Bool:    return 1;
+                case ShaderDataType::UShort4: return 4;
+                case ShaderDataType::Short2:  return 2;
+                case ShaderDataType::Int2101010: return 4;
+                case ShaderDataType::Half2:   return 2;
             }
 
             GLMV_ASSERT(false, "Unknown ShaderDataType!");
@@ -105,37 +117,118 @@ namespace GLMV {
     {
         public:
             VertexBuffer(float* vertices, uint32_t size);
+            VertexBuffer(uint32_t size);
             virtual ~VertexBuffer();
 
             virtual void Bind() const;
             virtual void Unbind() const;
 
+            virtual void SetData(const void* data, uint32_t size, uint32_t offset = 0);
+
             virtual const BufferLayout& GetLayout() const { return m_Layout; }
             virtual void SetLayout(const BufferLayout& layout) { m_Layout = layout; }
 
+            virtual uint32_t GetRendererID() const { return m_RendererID; }
+
             static Ref<VertexBuffer> Create(float* vertices, uint32_t size) { return CreateRef<VertexBuffer>(vertices, size); }
+            static Ref<VertexBuffer> Create(uint32_t size) { return CreateRef<VertexBuffer>(size); }
 
         private:
             uint32_t m_RendererID;
             BufferLayout m_Layout;
     };
 
+    // Width of the indexes in an IndexBuffer
+    enum class IndexType
+    {
+        UInt16 = 0, UInt32
+    };
+
+    static uint32_t IndexTypeSize(IndexType type)
+    {
+        return type == IndexType::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
     class IndexBuffer
     {
         public:
-            IndexBuffer(uint32_t* indices, uint32_t count);
+            // UInt16 buffers take 32 bit indexes as well and narrow them,
+            // every index must be below 65536
+            IndexBuffer(uint32_t* indices, uint32_t count, IndexType type = IndexType::UInt32);
+            IndexBuffer(uint32_t count, IndexType type = IndexType::UInt32);
             virtual ~IndexBuffer();
 
             virtual void Bind() const;
             virtual void Unbind() const;
 
+            virtual void SetData(const uint32_t* indices, uint32_t count, uint32_t offset = 0);
+
             virtual uint32_t GetCount() const { return m_Count; }
+            virtual IndexType GetType() const { return m_Type; }
+            virtual uint32_t GetRendererID() const { return m_RendererID; }
 
-            static Ref<IndexBuffer> Create(uint32_t* indices, uint32_t size) { return CreateRef<IndexBuffer>(indices, size); }
+            static Ref<IndexBuffer> Create(uint32_t* indices, uint32_t size, IndexType type = IndexType::UInt32) { return CreateRef<IndexBuffer>(indices, size, type); }
+            static Ref<IndexBuffer> Create(uint32_t count, IndexType type = IndexType::UInt32) { return CreateRef<IndexBuffer>(count, type); }
 
         private:
             uint32_t m_RendererID;
             uint32_t m_Count;
+            IndexType m_Type;
+    };
+
+    // Block of uniforms shared by every shader that declares it with
+    // layout(binding = ...) at the same binding
+    class UniformBuffer
+    {
+        public:
+            UniformBuffer(uint32_t size, uint32_t binding);
+            virtual ~UniformBuffer();
+
+            virtual void SetData(const void* data, uint32_t size, uint32_t offset = 0);
+
+            static Ref<UniformBuffer> Create(uint32_t size, uint32_t binding) { return CreateRef<UniformBuffer>(size, binding); }
+
+        private:
+            uint32_t m_RendererID;
+    };
+
+    // Shader storage buffer at a fixed binding, grown to whatever is set
+    class StorageBuffer
+    {
+        public:
+            StorageBuffer(uint32_t size, uint32_t binding);
+            virtual ~StorageBuffer();
+
+            // Replaces the whole content, reallocating when it grew
+            virtual void SetData(const void* data, uint32_t size);
+
+            virtual uint32_t GetCapacity() const { return m_Capacity; }
+
+            static Ref<StorageBuffer> Create(uint32_t size, uint32_t binding) { return CreateRef<StorageBuffer>(size, binding); }
+
+        private:
+            uint32_t m_RendererID;
+            uint32_t m_Capacity;
+    };
+
+    // DrawElementsIndirectCommand array for glMultiDrawElementsIndirect,
+    // grown to whatever is set
+    class IndirectBuffer
+    {
+        public:
+            IndirectBuffer(uint32_t size);
+            virtual ~IndirectBuffer();
+
+            virtual void Bind() const;
+
+            // Replaces the whole content, reallocating when it grew
+            virtual void SetData(const void* data, uint32_t size);
+
+            static Ref<IndirectBuffer> Create(uint32_t size) { return CreateRef<IndirectBuffer>(size); }
+
+        private:
+            uint32_t m_RendererID;
+            uint32_t m_Capacity;
     };
 
 }
@@ -0,0 +1,165 @@
+#include "GeometryPool.h"
+#include "Renderer.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+namespace GLMV {
+
+    // Elements the buffers of a new pool hold
+    static constexpr uint32_t s_InitialVertices = 1 << 16;
+    static constexpr uint32_t s_InitialIndexes = 1 << 18;
+
+    RangeAllocator::RangeAllocator(uint32_t capacity)
+    {
+        Grow(capacity);
+    }
+
+    uint32_t RangeAllocator::Allocate(uint32_t count)
+    {
+        for (auto it = m_Free.begin(); it != m_Free.end(); ++it)
+        {
+            if (it->second < count)
+                continue;
+
+            uint32_t offset = it->first;
+            uint32_t left = it->second - count;
+            m_Free.erase(it);
+            if (left > 0)
+                m_Free[offset + count] = left;
+            return offset;
+        }
+
+        return Invalid;
+    }
+
+    void RangeAllocator::Free(uint32_t offset, uint32_t count)
+    {
+        if (count == 0)
+            return;
+
+        auto next = m_Free.lower_bound(offset);
+        if (next != m_Free.end() && offset + count == next->first)
+        {
+            count += next->second;
+            next = m_Free.erase(next);
+        }
+
+        if (next != m_Free.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                previous->second += count;
+                return;
+            }
+        }
+
+        m_Free[offset] = count;
+    }
+
+    void RangeAllocator::Grow(uint32_t capacity)
+    {
+        if (capacity <= m_Capacity)
+            return;
+
+        uint32_t added = capacity - m_Capacity;
+        uint32_t offset = m_Capacity;
+        m_Capacity = capacity;
+        Free(offset, added);
+    }
+
+    GeometryPool::GeometryPool(const BufferLayout& layout, IndexType indexType, bool colors)
+        : m_Layout(layout), m_IndexType(indexType), m_Colors(colors)
+    {
+        Resize(s_InitialVertices, s_InitialIndexes);
+    }
+
+    PoolAllocation GeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount)
+    {
+        PoolAllocation allocation;
+        allocation.VertexCount = vertexCount;
+        allocation.IndexCount = indexCount;
+
+        allocation.BaseVertex = m_Vertices.Allocate(vertexCount);
+        allocation.FirstIndex = m_Indexes.Allocate(indexCount);
+        if (allocation.BaseVertex != RangeAllocator::Invalid && allocation.FirstIndex != RangeAllocator::Invalid)
+            return allocation;
+
+        // Doubling, or more for meshes larger than the pool
+        if (allocation.BaseVertex != RangeAllocator::Invalid)
+            m_Vertices.Free(allocation.BaseVertex, vertexCount);
+        if (allocation.FirstIndex != RangeAllocator::Invalid)
+            m_Indexes.Free(allocation.FirstIndex, indexCount);
+
+        Resize(std::max(m_Vertices.GetCapacity() * 2, m_Vertices.GetCapacity() + vertexCount),
+            std::max(m_Indexes.GetCapacity() * 2, m_Indexes.GetCapacity() + indexCount));
+
+        allocation.BaseVertex = m_Vertices.Allocate(vertexCount);
+        allocation.FirstIndex = m_Indexes.Allocate(indexCount);
+        return allocation;
+    }
+
+    void GeometryPool::Free(const PoolAllocation& allocation)
+    {
+        m_Vertices.Free(allocation.BaseVertex, allocation.VertexCount);
+        m_Indexes.Free(allocation.FirstIndex, allocation.IndexCount);
+    }
+
+    void GeometryPool::SetVertices(const PoolAllocation& allocation, const void* data)
+    {
+        uint32_t stride = m_Layout.GetStride();
+        m_VertexBuffer->SetData(data, allocation.VertexCount * stride, allocation.BaseVertex * stride);
+    }
+
+    void GeometryPool::SetColors(const PoolAllocation& allocation, const glm::vec4* colors)
+    {
+        if (m_ColorBuffer)
+            m_ColorBuffer->SetData(colors, allocation.VertexCount * sizeof(glm::vec4), allocation.BaseVertex * sizeof(glm::vec4));
+    }
+
+    void GeometryPool::SetIndexes(const PoolAllocation& allocation, const uint32_t* indexes)
+    {
+        m_IndexBuffer->SetData(indexes, allocation.IndexCount, allocation.FirstIndex);
+    }
+
+    void GeometryPool::Resize(uint32_t vertexCapacity, uint32_t indexCapacity)
+    {
+        uint32_t stride = m_Layout.GetStride();
+        Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create(vertexCapacity * stride);
+        Ref<VertexBuffer> colorBuffer = m_Colors ? VertexBuffer::Create(vertexCapacity * (uint32_t)sizeof(glm::vec4)) : nullptr;
+        Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(indexCapacity, m_IndexType);
+
+        // Meshes already in the pool keep their offsets
+        if (m_VertexBuffer)
+        {
+            uint32_t vertices = m_Vertices.GetCapacity(), indexes = m_Indexes.GetCapacity();
+            glCopyNamedBufferSubData(m_VertexBuffer->GetRendererID(), vertexBuffer->GetRendererID(), 0, 0, vertices * stride);
+            if (colorBuffer)
+                glCopyNamedBufferSubData(m_ColorBuffer->GetRendererID(), colorBuffer->GetRendererID(), 0, 0, vertices * sizeof(glm::vec4));
+            glCopyNamedBufferSubData(m_IndexBuffer->GetRendererID(), indexBuffer->GetRendererID(), 0, 0, indexes * IndexTypeSize(m_IndexType));
+        }
+
+        m_Vertices.Grow(vertexCapacity);
+        m_Indexes.Grow(indexCapacity);
+
+        vertexBuffer->SetLayout(m_Layout);
+        m_VertexArray = VertexArray::Create();
+        m_VertexArray->AddVertexBuffer(vertexBuffer);
+        if (colorBuffer)
+        {
+            colorBuffer->SetLayout({
+                { ShaderDataType::Float4, "a_Color" }
+            });
+            m_VertexArray->AddVertexBuffer(colorBuffer);
+        }
+        m_VertexArray->SetIndexBuffer(indexBuffer);
+        Renderer::CheckLayout(*m_VertexArray);
+
+        m_VertexBuffer = vertexBuffer;
+        m_ColorBuffer = colorBuffer;
+        m_IndexBuffer = indexBuffer;
+    }
+
+}
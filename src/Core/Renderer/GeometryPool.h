@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Renderer/VertexArray.h"
+
+#include <glm/glm.hpp>
+#include <map>
+
+namespace GLMV {
+
+    // First fit allocator over a range of elements, for suballocating buffers
+    class RangeAllocator
+    {
+        public:
+            static constexpr uint32_t Invalid = ~0u;
+
+            RangeAllocator(uint32_t capacity = 0);
+
+            // Offset of count contiguous free elements, Invalid when there
+            // is no such range
+            uint32_t Allocate(uint32_t count);
+            void Free(uint32_t offset, uint32_t count);
+
+            // Adds free elements at the end
+            void Grow(uint32_t capacity);
+            uint32_t GetCapacity() const { return m_Capacity; }
+
+        private:
+            // Offset -> size of every free range, neighbours always merged
+            std::map<uint32_t, uint32_t> m_Free;
+            uint32_t m_Capacity = 0;
+    };
+
+    // Where one mesh lives in a GeometryPool
+    struct PoolAllocation
+    {
+        uint32_t BaseVertex = 0;
+        uint32_t VertexCount = 0;
+        uint32_t FirstIndex = 0;
+        uint32_t IndexCount = 0;
+    };
+
+    // Vertex, color and index buffers that many meshes of the same layout
+    // share behind one VertexArray, so all of them draw with a single
+    // glMultiDrawElementsIndirect. Indexes stay relative to the mesh and
+    // are offset by BaseVertex when drawn.
+    class GeometryPool
+    {
+        public:
+            GeometryPool(const BufferLayout& layout, IndexType indexType, bool colors);
+
+            // Room for a mesh, growing the buffers when it does not fit
+            PoolAllocation Allocate(uint32_t vertexCount, uint32_t indexCount);
+            void Free(const PoolAllocation& allocation);
+
+            // Stride bytes per vertex, as laid out by the pool's BufferLayout
+            void SetVertices(const PoolAllocation& allocation, const void* data);
+            void SetColors(const PoolAllocation& allocation, const glm::vec4* colors);
+            void SetIndexes(const PoolAllocation& allocation, const uint32_t* indexes);
+
+            // Replaced whenever the buffers grow
+            const Ref<VertexArray>& GetVertexArray() const { return m_VertexArray; }
+            IndexType GetIndexType() const { return m_IndexType; }
+            bool HasColors() const { return m_Colors; }
+            const BufferLayout& GetLayout() const { return m_Layout; }
+
+        private:
+            void Resize(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+        private:
+            BufferLayout m_Layout;
+            IndexType m_IndexType;
+            bool m_Colors;
+
+            RangeAllocator m_Vertices;
+            RangeAllocator m_Indexes;
+
+            Ref<VertexBuffer> m_VertexBuffer;
+            Ref<VertexBuffer> m_ColorBuffer;
+            Ref<IndexBuffer> m_IndexBuffer;
+            Ref<VertexArray> m_VertexArray;
+    };
+
+}
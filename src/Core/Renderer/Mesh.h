@@ -6,6 +6,39 @@
 
 namespace GLMV {
 
+    // How MeshCache lays out positions and normals in GPU memory. The CPU
+    // streams stay floats either way.
+    enum class VertexFormat
+    {
+        // 3 floats each, 24 bytes
+        Float = 0,
+        // 16 bit positions in the bounding box, octahedral normals in 2x16 bits, 12 bytes
+        Octahedral16,
+        // 16 bit positions in the bounding box, normals in 10:10:10:2, 12 bytes
+        Packed1010102
+    };
+
+    // Part of the index buffer, in indexes
+    struct IndexRange
+    {
+        uint32_t Offset;
+        uint32_t Count;
+    };
+
+    // Cluster of at most a few dozen vertices whose triangles are one
+    // contiguous range of Mesh::Indexes, with the bounds to cull it by
+    struct Meshlet
+    {
+        uint32_t IndexOffset;
+        uint32_t IndexCount;
+        glm::vec3 Center;
+        float Radius;
+        // Every triangle normal lies within the cone around ConeAxis whose
+        // half angle has ConeCutoff as sine, 1 when the cone is too wide
+        glm::vec3 ConeAxis;
+        float ConeCutoff;
+    };
+
     class Mesh
     {
         public:
@@ -15,7 +48,14 @@ namespace GLMV {
             Ref<std::vector<uint32_t>> Indexes;
             Ref<std::vector<glm::vec3>> Normals;
             Ref<std::vector<glm::vec3>> Vertex;
+            // One per vertex, empty when the source had none
+            Ref<std::vector<glm::vec2>> TexCoords;
+            // One per vertex, empty when the source had none
+            Ref<std::vector<glm::vec4>> Colors;
             Ref<std::pair< glm::vec3, glm::vec3 >> BoundingBox;
+            // Empty unless Meshlets::Build ordered Indexes into clusters
+            Ref<std::vector<Meshlet>> Meshlets;
+            VertexFormat Format = VertexFormat::Float;
            // std::vector<Texture> textures;
 
             static Ref<Mesh> Create() {
@@ -24,10 +64,18 @@ namespace GLMV {
                 ret->Indexes = CreateRef<std::vector<uint32_t>>();
                 ret->Normals = CreateRef<std::vector<glm::vec3>>();
                 ret->Vertex = CreateRef<std::vector<glm::vec3>>();
+                ret->TexCoords = CreateRef<std::vector<glm::vec2>>();
+                ret->Colors = CreateRef<std::vector<glm::vec4>>();
                 ret->BoundingBox = CreateRef<std::pair< glm::vec3, glm::vec3 >>();
+                ret->Meshlets = CreateRef<std::vector<Meshlet>>();
                 return ret;
             }
+
+            // Call after editing the streams so the GPU copy gets re-uploaded
+            void MarkDirty() { ++m_Revision; }
+            uint64_t GetRevision() const { return m_Revision; }
         private:
+            uint64_t m_Revision = 0;
 
     };
 
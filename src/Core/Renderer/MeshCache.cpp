@@ -0,0 +1,268 @@
+#include "MeshCache.h"
+#include "Renderer.h"
+
+#include "Core/Geometry/VertexQuantizer.h"
+
+namespace GLMV {
+
+    std::unordered_map<const Mesh*, MeshCache::Entry> MeshCache::s_Entries;
+    std::vector<MeshCache::Pool> MeshCache::s_Pools;
+    bool MeshCache::s_Pooled = false;
+
+    // 16 bit indexes whenever they reach every vertex
+    static IndexType GetIndexType(size_t vertexCount)
+    {
+        return vertexCount <= 0xffff ? IndexType::UInt16 : IndexType::UInt32;
+    }
+
+    MeshCache::Entry& MeshCache::GetEntry(const Ref<Mesh>& mesh)
+    {
+        Entry& entry = s_Entries[mesh.get()];
+
+        // A freed mesh can hand its address to a new one before Collect runs,
+        // so an expired owner means the entry is stale as well.
+        if (entry.Owner.expired() || entry.Revision != mesh->GetRevision())
+        {
+            Release(entry);
+            entry.Owner = mesh;
+            entry.Revision = mesh->GetRevision();
+            entry.Mesh_ = nullptr;
+            entry.Vertex = nullptr;
+            entry.WireFrame = nullptr;
+            entry.PendingVertices = nullptr;
+            entry.PendingIndexes = nullptr;
+            entry.PendingColors = nullptr;
+            entry.Packed.clear();
+            entry.Packed.shrink_to_fit();
+            entry.VertexOffset = 0;
+            entry.IndexOffset = 0;
+            entry.ColorOffset = 0;
+        }
+
+        return entry;
+    }
+
+    void MeshCache::Release(Entry& entry)
+    {
+        if (entry.Pooled.Pool)
+            entry.Pooled.Pool->Free(entry.Pooled.Allocation);
+        entry.Pooled = {};
+    }
+
+    BufferLayout MeshCache::GetVertexLayout(VertexFormat format)
+    {
+        if (format == VertexFormat::Float)
+        {
+            return {
+                { ShaderDataType::Float3, "a_Position" },
+                { ShaderDataType::Float3, "a_Normal" }
+            };
+        }
+
+        // Positions in [0, 1] of the box, see VertexQuantizer::GetPositionDecode
+        return {
+            { ShaderDataType::UShort4, "a_Position", true },
+            { format == VertexFormat::Octahedral16 ? ShaderDataType::Short2 : ShaderDataType::Int2101010, "a_Normal", true }
+        };
+    }
+
+    GeometryPool& MeshCache::GetPool(VertexFormat format, IndexType indexes, bool colors)
+    {
+        for (auto& pool : s_Pools)
+        {
+            if (pool.Format == format && pool.Indexes == indexes && pool.Colors == colors)
+                return *pool.Geometry;
+        }
+
+        s_Pools.push_back({ format, indexes, colors, CreateScope<GeometryPool>(GetVertexLayout(format), indexes, colors) });
+        return *s_Pools.back().Geometry;
+    }
+
+    const PooledMesh& MeshCache::GetPooled(const Ref<Mesh>& mesh)
+    {
+        Entry& entry = GetEntry(mesh);
+        const std::vector<uint32_t>& indices = *mesh->Indexes;
+        if (entry.Pooled.Pool || indices.empty())
+            return entry.Pooled;
+
+        size_t vertexCount = mesh->Vertices->size() / 2;
+        bool colors = mesh->Colors->size() == vertexCount;
+        GeometryPool& pool = GetPool(mesh->Format, GetIndexType(vertexCount), colors);
+
+        PoolAllocation allocation = pool.Allocate((uint32_t)vertexCount, (uint32_t)indices.size());
+        if (mesh->Format == VertexFormat::Float)
+        {
+            pool.SetVertices(allocation, mesh->Vertices->data());
+        }
+        else
+        {
+            std::vector<uint8_t> packed;
+            VertexQuantizer::Encode(*mesh, mesh->Format, packed);
+            pool.SetVertices(allocation, packed.data());
+        }
+        if (colors)
+            pool.SetColors(allocation, mesh->Colors->data());
+        pool.SetIndexes(allocation, indices.data());
+
+        entry.Pooled = { &pool, allocation };
+        return entry.Pooled;
+    }
+
+    bool MeshCache::Upload(const Ref<Mesh>& mesh, size_t& budget)
+    {
+        Entry& entry = GetEntry(mesh);
+        if (s_Pooled)
+        {
+            if (!entry.Pooled.Pool)
+            {
+                const PoolAllocation& allocation = GetPooled(mesh).Allocation;
+                size_t size = allocation.VertexCount * VertexQuantizer::GetStride(mesh->Format) + allocation.IndexCount * sizeof(uint32_t);
+                budget -= std::min(budget, size);
+            }
+            return true;
+        }
+
+        if (entry.Mesh_)
+            return true;
+
+        const std::vector<uint32_t>& indices = *mesh->Indexes;
+        const std::vector<glm::vec4>& colors = *mesh->Colors;
+        bool packed = mesh->Format != VertexFormat::Float;
+        size_t vertexBytes = mesh->Vertices->size() / 2 * VertexQuantizer::GetStride(mesh->Format);
+        IndexType indexType = GetIndexType(mesh->Vertices->size() / 2);
+        size_t indexSize = IndexTypeSize(indexType);
+        size_t indexBytes = indices.size() * indexSize;
+        size_t colorBytes = colors.size() * sizeof(glm::vec4);
+
+        if (!entry.PendingVertices)
+        {
+            // Encoded once, then sliced like the float stream
+            if (packed)
+                VertexQuantizer::Encode(*mesh, mesh->Format, entry.Packed);
+
+            entry.PendingVertices = VertexBuffer::Create((uint32_t)vertexBytes);
+            entry.PendingIndexes = IndexBuffer::Create((uint32_t)indices.size(), indexType);
+            if (colorBytes)
+                entry.PendingColors = VertexBuffer::Create((uint32_t)colorBytes);
+        }
+
+        if (entry.VertexOffset < vertexBytes && budget > 0)
+        {
+            size_t size = std::min(budget, vertexBytes - entry.VertexOffset);
+            const uint8_t* vertices = packed ? entry.Packed.data() : (const uint8_t*)mesh->Vertices->data();
+            entry.PendingVertices->SetData(vertices + entry.VertexOffset, (uint32_t)size, (uint32_t)entry.VertexOffset);
+            entry.VertexOffset += size;
+            budget -= size;
+        }
+
+        if (entry.IndexOffset < indexBytes && budget >= indexSize)
+        {
+            // Index slices are counted in whole indexes
+            size_t size = std::min(budget, indexBytes - entry.IndexOffset) & ~(indexSize - 1);
+            entry.PendingIndexes->SetData(indices.data() + entry.IndexOffset / indexSize, (uint32_t)(size / indexSize), (uint32_t)(entry.IndexOffset / indexSize));
+            entry.IndexOffset += size;
+            budget -= size;
+        }
+
+        if (entry.ColorOffset < colorBytes && budget > 0)
+        {
+            size_t size = std::min(budget, colorBytes - entry.ColorOffset);
+            entry.PendingColors->SetData((const uint8_t*)colors.data() + entry.ColorOffset, (uint32_t)size, (uint32_t)entry.ColorOffset);
+            entry.ColorOffset += size;
+            budget -= size;
+        }
+
+        if (entry.VertexOffset < vertexBytes || entry.IndexOffset < indexBytes || entry.ColorOffset < colorBytes)
+            return false;
+
+        entry.PendingVertices->SetLayout(GetVertexLayout(mesh->Format));
+
+        entry.Mesh_ = VertexArray::Create();
+        entry.Mesh_->AddVertexBuffer(entry.PendingVertices);
+        entry.Mesh_->SetIndexBuffer(entry.PendingIndexes);
+
+        // Without this buffer a_Color keeps the white set in Renderer::Init
+        if (entry.PendingColors)
+        {
+            entry.PendingColors->SetLayout({
+                { ShaderDataType::Float4, "a_Color" }
+            });
+            entry.Mesh_->AddVertexBuffer(entry.PendingColors);
+        }
+        Renderer::CheckLayout(*entry.Mesh_);
+
+        entry.PendingVertices = nullptr;
+        entry.PendingIndexes = nullptr;
+        entry.PendingColors = nullptr;
+        entry.Packed.clear();
+        entry.Packed.shrink_to_fit();
+        return true;
+    }
+
+    const Ref<VertexArray>& MeshCache::GetMesh(const Ref<Mesh>& mesh)
+    {
+        // Finishes whatever a budgeted upload left behind
+        size_t budget = SIZE_MAX;
+        Upload(mesh, budget);
+
+        return s_Entries[mesh.get()].Mesh_;
+    }
+
+    const Ref<VertexArray>& MeshCache::GetVertex(const Ref<Mesh>& mesh)
+    {
+        Entry& entry = GetEntry(mesh);
+        if (!entry.Vertex)
+        {
+            Ref<std::vector<glm::vec3>> vertices = mesh->Vertex;
+
+            entry.Vertex = VertexArray::Create();
+            Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create((float*)vertices->data(), vertices->size() * sizeof(glm::vec3));
+            vertexBuffer->SetLayout({
+                { ShaderDataType::Float3, "a_Position" },
+            });
+            entry.Vertex->AddVertexBuffer(vertexBuffer);
+            Renderer::CheckLayout(*entry.Vertex);
+        }
+
+        return entry.Vertex;
+    }
+
+    const Ref<VertexArray>& MeshCache::GetWireFrame(const Ref<Mesh>& mesh)
+    {
+        Entry& entry = GetEntry(mesh);
+        if (!entry.WireFrame)
+        {
+            Ref<std::vector<uint32_t>> indices = mesh->Indexes;
+
+            // Share the position buffer with the point view
+            entry.WireFrame = VertexArray::Create();
+            entry.WireFrame->AddVertexBuffer(GetVertex(mesh)->GetVertexBuffers()[0]);
+
+            Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(indices->data(), indices->size(), GetIndexType(mesh->Vertex->size()));
+            entry.WireFrame->SetIndexBuffer(indexBuffer);
+        }
+
+        return entry.WireFrame;
+    }
+
+    void MeshCache::Collect()
+    {
+        for (auto it = s_Entries.begin(); it != s_Entries.end();)
+        {
+            if (it->second.Owner.expired())
+            {
+                Release(it->second);
+                it = s_Entries.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    void MeshCache::Clear()
+    {
+        s_Entries.clear();
+        s_Pools.clear();
+    }
+
+}
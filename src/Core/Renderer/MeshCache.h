@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Renderer/Mesh.h"
+#include "Core/Renderer/VertexArray.h"
+#include "Core/Renderer/GeometryPool.h"
+
+namespace GLMV {
+
+    // A mesh suballocated from the GeometryPool of its layout
+    struct PooledMesh
+    {
+        GeometryPool* Pool = nullptr;
+        PoolAllocation Allocation;
+    };
+
+    // Keeps the GPU copy of every Mesh alive between frames, so a mesh is
+    // uploaded once and only re-uploaded after Mesh::MarkDirty().
+    class MeshCache
+    {
+        public:
+            // Interleaved position/normal buffer with indexes, plus a color
+            // buffer when the mesh has vertex colors. Laid out in the
+            // Mesh::Format of the mesh, with 16 bit indexes when the mesh
+            // has at most 65535 vertices.
+            static const Ref<VertexArray>& GetMesh(const Ref<Mesh>& mesh);
+            // Positions only, drawn as points
+            static const Ref<VertexArray>& GetVertex(const Ref<Mesh>& mesh);
+            // Positions with indexes, drawn as lines
+            static const Ref<VertexArray>& GetWireFrame(const Ref<Mesh>& mesh);
+
+            // The same buffers in the pool shared by every mesh of the same
+            // Mesh::Format, index type and vertex colors, uploaded on first
+            // use. Pool is null for meshes without indexes.
+            static const PooledMesh& GetPooled(const Ref<Mesh>& mesh);
+
+            // Copies at most `budget` bytes of the mesh buffer into GPU memory
+            // and subtracts what was sent. Returns true once GetMesh() can be
+            // served without further uploads. While pooled, uploads into the
+            // pool in one go instead.
+            static bool Upload(const Ref<Mesh>& mesh, size_t& budget);
+
+            // Whether meshes are drawn from the pools, so Upload fills those
+            static void SetPooled(bool pooled) { s_Pooled = pooled; }
+            static bool IsPooled() { return s_Pooled; }
+
+            // Frees the GPU objects of meshes that are no longer referenced
+            static void Collect();
+            static void Clear();
+
+            static size_t GetSize() { return s_Entries.size(); }
+        private:
+            struct Entry
+            {
+                std::weak_ptr<Mesh> Owner;
+                uint64_t Revision = 0;
+                Ref<VertexArray> Mesh_;
+                Ref<VertexArray> Vertex;
+                Ref<VertexArray> WireFrame;
+
+                // Partially uploaded buffers of Mesh_
+                Ref<VertexBuffer> PendingVertices;
+                Ref<IndexBuffer> PendingIndexes;
+                Ref<VertexBuffer> PendingColors;
+                size_t VertexOffset = 0;
+                size_t IndexOffset = 0;
+                size_t ColorOffset = 0;
+                // Encoded vertices of a mesh with a packed VertexFormat
+                std::vector<uint8_t> Packed;
+
+                PooledMesh Pooled;
+            };
+
+            struct Pool
+            {
+                VertexFormat Format;
+                IndexType Indexes;
+                bool Colors;
+                Scope<GeometryPool> Geometry;
+            };
+
+            static Entry& GetEntry(const Ref<Mesh>& mesh);
+            static void Release(Entry& entry);
+            static BufferLayout GetVertexLayout(VertexFormat format);
+            static GeometryPool& GetPool(VertexFormat format, IndexType indexes, bool colors);
+
+            static std::unordered_map<const Mesh*, Entry> s_Entries;
+            static std::vector<Pool> s_Pools;
+            static bool s_Pooled;
+    };
+
+}
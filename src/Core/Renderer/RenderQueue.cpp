@@ -0,0 +1,94 @@
+#include "RenderQueue.h"
+
+#include <cstring>
+
+namespace GLMV {
+
+    static_assert(RenderQueue::PassBits + RenderQueue::ShaderBits + RenderQueue::VertexArrayBits + RenderQueue::MeshBits
+        + RenderQueue::MaterialBits + RenderQueue::DepthBits == 64, "Sort key fields must fill 64 bits");
+
+    // Bits per radix sort digit, and digits in a key
+    static constexpr uint32_t s_DigitBits = 8;
+    static constexpr uint32_t s_Digits = 64 / s_DigitBits;
+    static constexpr uint32_t s_Buckets = 1 << s_DigitBits;
+
+    static uint64_t Field(uint32_t value, uint32_t bits)
+    {
+        return value & ((1ull << bits) - 1);
+    }
+
+    // Positive floats order like their bit patterns, so the top bits below
+    // the sign keep the order at a precision relative to the depth
+    static uint32_t QuantizeDepth(float depth)
+    {
+        if (!(depth > 0.0f))
+            return 0;
+
+        uint32_t bits;
+        memcpy(&bits, &depth, sizeof(bits));
+        return bits >> (31 - RenderQueue::DepthBits);
+    }
+
+    uint64_t RenderQueue::MakeKey(RenderPass pass, uint32_t shader, uint32_t vertexArray, uint32_t mesh, uint32_t material, float depth)
+    {
+        uint64_t key = Field((uint32_t)pass, PassBits);
+        key = (key << ShaderBits) | Field(shader, ShaderBits);
+
+        uint32_t quantized = QuantizeDepth(depth);
+        if (pass == RenderPass::Transparent)
+        {
+            // Farthest first
+            key = (key << DepthBits) | Field(~quantized, DepthBits);
+            key = (key << VertexArrayBits) | Field(vertexArray, VertexArrayBits);
+            key = (key << MeshBits) | Field(mesh, MeshBits);
+            return (key << MaterialBits) | Field(material, MaterialBits);
+        }
+
+        key = (key << VertexArrayBits) | Field(vertexArray, VertexArrayBits);
+        key = (key << MeshBits) | Field(mesh, MeshBits);
+        key = (key << MaterialBits) | Field(material, MaterialBits);
+        return (key << DepthBits) | Field(quantized, DepthBits);
+    }
+
+    const std::vector<RenderPacket>& RenderQueue::Sort()
+    {
+        size_t count = m_Packets.size();
+        if (count < 2)
+            return m_Packets;
+
+        // Every digit's histogram in a single read of the keys
+        std::vector<uint32_t> counts(s_Digits * s_Buckets, 0);
+        for (const auto& packet : m_Packets)
+        {
+            for (uint32_t d = 0; d < s_Digits; ++d)
+                counts[d * s_Buckets + ((packet.Key >> (d * s_DigitBits)) & (s_Buckets - 1))]++;
+        }
+
+        m_Scratch.resize(count);
+        for (uint32_t d = 0; d < s_Digits; ++d)
+        {
+            uint32_t* digit = &counts[d * s_Buckets];
+            uint32_t shift = d * s_DigitBits;
+
+            // Most fields are narrower than their digits or the same for the
+            // whole frame, such digits leave the order as it is
+            if (digit[(m_Packets[0].Key >> shift) & (s_Buckets - 1)] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (uint32_t b = 0; b < s_Buckets; ++b)
+            {
+                uint32_t size = digit[b];
+                digit[b] = offset;
+                offset += size;
+            }
+
+            for (const auto& packet : m_Packets)
+                m_Scratch[digit[(packet.Key >> shift) & (s_Buckets - 1)]++] = packet;
+            m_Packets.swap(m_Scratch);
+        }
+
+        return m_Packets;
+    }
+
+}
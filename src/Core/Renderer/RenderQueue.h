@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Base.h"
+
+namespace GLMV {
+
+    // Opaque draws go first, transparent ones blend over them
+    enum class RenderPass : uint32_t
+    {
+        Opaque = 0, Transparent
+    };
+
+    // A draw as the queue orders it, Command indexing the caller's own
+    // list of recorded draws
+    struct RenderPacket
+    {
+        uint64_t Key;
+        uint32_t Command;
+    };
+
+    // Draw packets ordered by 64 bit sort keys. Fields are packed most
+    // significant first, so sorting the keys as integers groups draws by
+    // the state they bind:
+    //
+    //   Opaque:      pass | shader | vertex array | mesh | material | depth
+    //   Transparent: pass | shader | far depth    | vertex array | mesh | material
+    //
+    // Opaque draws of one mesh go front to back, transparent draws go back
+    // to front regardless of what they bind. Ids wider than their field
+    // wrap around, which only costs batching.
+    class RenderQueue
+    {
+        public:
+            static constexpr uint32_t PassBits = 2;
+            static constexpr uint32_t ShaderBits = 4;
+            static constexpr uint32_t VertexArrayBits = 14;
+            static constexpr uint32_t MeshBits = 14;
+            static constexpr uint32_t MaterialBits = 10;
+            static constexpr uint32_t DepthBits = 20;
+
+            // Depth is the distance to the camera, anything below 0 counts as 0
+            static uint64_t MakeKey(RenderPass pass, uint32_t shader, uint32_t vertexArray, uint32_t mesh, uint32_t material, float depth);
+            static RenderPass GetPass(uint64_t key) { return (RenderPass)(key >> (64 - PassBits)); }
+
+            void Submit(uint64_t key, uint32_t command) { m_Packets.push_back({ key, command }); }
+            // Stable LSD radix sort, packets with equal keys keep the order
+            // they were submitted in
+            const std::vector<RenderPacket>& Sort();
+            void Clear() { m_Packets.clear(); }
+
+            bool IsEmpty() const { return m_Packets.empty(); }
+            size_t GetSize() const { return m_Packets.size(); }
+
+        private:
+            std::vector<RenderPacket> m_Packets;
+            std::vector<RenderPacket> m_Scratch;
+    };
+
+}
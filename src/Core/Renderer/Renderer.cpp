@@ -1,12 +1,106 @@
 #include "Renderer.h"
+#include "MeshCache.h"
+#include "RenderQueue.h"
 
 #include <glad/glad.h>
 
+#include <algorithm>
+
 namespace GLMV {
 
     static Ref<Shader> s_TriangleShader, s_DefaultShader;
+
+    // Uniform handles, resolved once in Init
+    struct DefaultUniforms
+    {
+        Uniform<glm::mat4> Transform;
+        Uniform<glm::vec4> Color;
+
+        void Resolve(const Shader& shader)
+        {
+            Transform = shader.GetUniform<glm::mat4>("u_Transform");
+            Color = shader.GetUniform<glm::vec4>("u_Color");
+        }
+    };
+
+    static DefaultUniforms s_DefaultUniforms;
+
+    // Buffer bindings shared with the shaders
+    static constexpr uint32_t s_CameraBinding = 0;
+    static constexpr uint32_t s_DrawsBinding = 1;
+
+    // One element of the Draws storage buffer of Mesh.glsl, std430
+    struct DrawData
+    {
+        glm::mat4 Transform;
+        glm::vec4 Color;
+        int32_t EntityID;
+        int32_t NormalEncoding;
+        int32_t Padding[2];
+    };
+    static_assert(sizeof(DrawData) == 96, "DrawData must match the std430 layout of Mesh.glsl");
+
+    // Mesh draw recorded until EndScene, its DrawData at Draw. Either
+    // from its own vertex array, or from a pool at BaseVertex and FirstIndex.
+    struct DrawCommand
+    {
+        Ref<VertexArray> Mesh;
+        GeometryPool* Pool;
+        uint32_t BaseVertex;
+        uint32_t FirstIndex;
+        GLenum Mode;
+        uint32_t Draw;
+        uint32_t FirstRange;
+        uint32_t RangeCount;
+    };
+
+    // As glMultiDrawElementsIndirect reads it
+    struct DrawElementsIndirectCommand
+    {
+        uint32_t Count;
+        uint32_t InstanceCount;
+        uint32_t FirstIndex;
+        int32_t BaseVertex;
+        uint32_t BaseInstance;
+    };
+
+    // Shader field of the sort keys, every recorded draw uses s_TriangleShader
+    static constexpr uint32_t s_TriangleShaderKey = 0;
+
+    // Commands [First, Last) of one draw call, Indirect ones into the
+    // indirect buffer when pooled
+    struct DrawBatch
+    {
+        size_t First;
+        size_t Last;
+        uint32_t Indirect;
+        uint32_t IndirectCount;
+    };
+
+    static Ref<UniformBuffer> s_CameraBuffer;
+    static Ref<StorageBuffer> s_DrawBuffer;
+    static std::vector<DrawData> s_Draws;
+    // s_Draws in the order EndScene draws them
+    static std::vector<DrawData> s_Instances;
+    static std::vector<DrawCommand> s_Commands;
+    // s_Commands in key order
+    static std::vector<DrawCommand> s_Sorted;
+    static RenderQueue s_Queue;
+    // Per frame sort key ids of vertex arrays and pools, and of the meshes
+    // in them by base vertex
+    static std::unordered_map<const void*, uint32_t> s_VertexArrayIds;
+    static std::unordered_map<uint64_t, uint32_t> s_MeshIds;
+    static glm::vec3 s_CameraPosition;
+    static std::vector<IndexRange> s_Ranges;
+    static std::vector<DrawBatch> s_Batches;
+    static std::vector<DrawElementsIndirectCommand> s_Indirect;
+    static Ref<IndirectBuffer> s_IndirectBuffer;
+    static bool s_MultiDrawIndirect = false;
+    static RenderStats s_Stats;
+    static Ref<VertexArray> s_CubeVertexArray;
     Scope<Renderer::SceneData> Renderer::s_SceneData = CreateScope<Renderer::SceneData>();
     static bool s_Fill = true;
+    static bool s_BackfaceCulling = true;
 
     void Renderer::Init()
     {
@@ -15,52 +109,318 @@ namespace GLMV {
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_CULL_FACE);
 
+        // a_Color of meshes without vertex colors, attribute values set
+        // here are used whenever the array is disabled in a vertex array
+        glVertexAttrib4f(2, 1.0f, 1.0f, 1.0f, 1.0f);
+
         s_TriangleShader = Shader::Create("assets/shaders/Mesh.glsl");
         s_DefaultShader = Shader::Create("assets/shaders/Default.glsl");
+        s_DefaultUniforms.Resolve(*s_DefaultShader);
+
+        if (!s_TriangleShader->GetReflection().StorageBlocks.count("Draws"))
+        {
+            LOG_ERROR("Mesh shader has no Draws storage block");
+        }
+
+        s_CameraBuffer = UniformBuffer::Create(sizeof(SceneData), s_CameraBinding);
+        s_DrawBuffer = StorageBuffer::Create(1024 * sizeof(DrawData), s_DrawsBinding);
+        s_IndirectBuffer = IndirectBuffer::Create(1024 * sizeof(DrawElementsIndirectCommand));
+
+        float vertices[] =
+        { //     UNIT CUBE      COORDINATES         
+            0.500000, -0.500000, -0.500000,
+            0.500000, -0.500000,  0.500000,
+           -0.500000, -0.500000,  0.500000,
+           -0.500000, -0.500000, -0.500000,
+            0.500000,  0.500000, -0.500000,
+            0.500000,  0.500000,  0.500000,
+           -0.500000,  0.500000,  0.500000,
+           -0.500000,  0.500000, -0.500000,
+        };
+
+        uint32_t indices[] =
+        {
+            1,2,3,
+            7,6,5,
+            4,5,1,
+            5,6,2,
+            2,6,7,
+            0,3,7,
+            0,1,3,
+            4,7,5,
+            0,4,1,
+            1,5,2,
+            3,2,7,
+            4,0,7
+        };
+
+        s_CubeVertexArray = VertexArray::Create();
+        Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create(vertices, sizeof(vertices));
+        vertexBuffer->SetLayout({
+            { ShaderDataType::Float3, "a_Position" },
+            });
+        s_CubeVertexArray->AddVertexBuffer(vertexBuffer);
+
+        Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(indices, sizeof(indices) / sizeof(uint32_t));
+        s_CubeVertexArray->SetIndexBuffer(indexBuffer);
+        CheckLayout(*s_CubeVertexArray);
+    }
+
+    bool Renderer::CheckLayout(const VertexArray& vertexArray)
+    {
+        bool valid = s_TriangleShader->CheckLayout(vertexArray);
+        return s_DefaultShader->CheckLayout(vertexArray) && valid;
     }
 
     void Renderer::Shutdown()
     {
+        MeshCache::Clear();
+        s_CubeVertexArray = nullptr;
+        s_Commands.clear();
+        s_Sorted.clear();
+        s_Queue.Clear();
+        s_CameraBuffer = nullptr;
+        s_DrawBuffer = nullptr;
+        s_IndirectBuffer = nullptr;
     }
 
     void Renderer::BeginScene(Camera& camera)
     {
         s_SceneData->ViewProjectionMatrix = camera.GetViewProjection();
+        s_CameraBuffer->SetData(s_SceneData.get(), sizeof(SceneData));
+        s_CameraPosition = camera.GetPosition();
+    }
+
+    static GLenum IndexTypeToOpenGL(IndexType type)
+    {
+        return type == IndexType::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    // Same mesh, mode and single index range, so one instanced draw covers both
+    static bool CanInstance(const DrawCommand& a, const DrawCommand& b)
+    {
+        return a.Mesh == b.Mesh && a.Pool == b.Pool && a.BaseVertex == b.BaseVertex && a.FirstIndex == b.FirstIndex
+            && a.Mode == b.Mode && a.RangeCount == 1 && b.RangeCount == 1
+            && s_Ranges[a.FirstRange].Offset == s_Ranges[b.FirstRange].Offset
+            && s_Ranges[a.FirstRange].Count == s_Ranges[b.FirstRange].Count;
     }
 
     void Renderer::EndScene()
     {
+        s_Stats = {};
+        if (s_Commands.empty())
+            return;
+
+        // Opaque draws of the same vertex array or pool next to each other,
+        // so they bind it once and entities sharing a mesh become instances,
+        // then transparent ones back to front
+        s_Sorted.clear();
+        s_Sorted.reserve(s_Commands.size());
+        for (const auto& packet : s_Queue.Sort())
+            s_Sorted.push_back(std::move(s_Commands[packet.Command]));
+        s_Commands.swap(s_Sorted);
+        s_Sorted.clear();
+        s_Queue.Clear();
+        s_VertexArrayIds.clear();
+        s_MeshIds.clear();
+
+        // Every transform, color and id of the frame in one upload, in draw
+        // order. Instance i of a draw finds its own at gl_BaseInstance + i.
+        s_Instances.resize(s_Commands.size());
+        for (size_t i = 0; i < s_Commands.size(); ++i)
+            s_Instances[i] = s_Draws[s_Commands[i].Draw];
+        s_DrawBuffer->SetData(s_Instances.data(), (uint32_t)(s_Instances.size() * sizeof(DrawData)));
+
+        // Instanced runs, and for pools every run of one pool and mode in
+        // a single multi draw
+        s_Batches.clear();
+        s_Indirect.clear();
+        for (size_t first = 0, last; first < s_Commands.size(); first = last)
+        {
+            const DrawCommand& command = s_Commands[first];
+            last = first + 1;
+            while (last < s_Commands.size() && CanInstance(command, s_Commands[last]))
+                last++;
+
+            const DrawCommand* previous = s_Batches.empty() ? nullptr : &s_Commands[s_Batches.back().First];
+            if (!command.Pool || !previous || previous->Pool != command.Pool || previous->Mode != command.Mode)
+                s_Batches.push_back({ first, last, (uint32_t)s_Indirect.size(), 0 });
+            s_Batches.back().Last = last;
+
+            if (!command.Pool)
+                continue;
+
+            for (uint32_t r = command.FirstRange; r < command.FirstRange + command.RangeCount; ++r)
+            {
+                s_Indirect.push_back({ s_Ranges[r].Count, (uint32_t)(last - first), command.FirstIndex + s_Ranges[r].Offset,
+                    (int32_t)command.BaseVertex, (uint32_t)first });
+                s_Batches.back().IndirectCount++;
+            }
+        }
+
+        if (!s_Indirect.empty())
+        {
+            s_IndirectBuffer->SetData(s_Indirect.data(), (uint32_t)(s_Indirect.size() * sizeof(DrawElementsIndirectCommand)));
+            s_IndirectBuffer->Bind();
+        }
+
+        s_TriangleShader->Bind();
+        s_Stats.MeshDraws = (uint32_t)s_Commands.size();
+
+        const VertexArray* bound = nullptr;
+        for (const auto& batch : s_Batches)
+        {
+            const DrawCommand& command = s_Commands[batch.First];
+            const Ref<VertexArray>& vertexArray = command.Pool ? command.Pool->GetVertexArray() : command.Mesh;
+            if (vertexArray.get() != bound)
+            {
+                vertexArray->Bind();
+                bound = vertexArray.get();
+                s_Stats.Binds++;
+            }
+
+            IndexType type = vertexArray->GetIndexBuffer()->GetType();
+            if (command.Pool)
+            {
+                const void* offset = (const void*)((size_t)batch.Indirect * sizeof(DrawElementsIndirectCommand));
+                glMultiDrawElementsIndirect(command.Mode, IndexTypeToOpenGL(type), offset, (GLsizei)batch.IndirectCount, 0);
+                s_Stats.DrawCalls++;
+                continue;
+            }
+
+            for (uint32_t r = command.FirstRange; r < command.FirstRange + command.RangeCount; ++r)
+            {
+                const void* offset = (const void*)((size_t)s_Ranges[r].Offset * IndexTypeSize(type));
+                glDrawElementsInstancedBaseInstance(command.Mode, s_Ranges[r].Count, IndexTypeToOpenGL(type), offset,
+                    (GLsizei)(batch.Last - batch.First), (GLuint)batch.First);
+                s_Stats.DrawCalls++;
+            }
+        }
+
+        s_Draws.clear();
+        s_Commands.clear();
+        s_Ranges.clear();
+    }
+
+    // NormalEncoding of Mesh.glsl, from the a_Normal type MeshCache
+    // picked for the mesh's VertexFormat
+    static int GetNormalEncoding(const Ref<VertexArray>& vertexArray)
+    {
+        const auto& elements = vertexArray->GetVertexBuffers()[0]->GetLayout().GetElements();
+        if (elements.size() < 2)
+            return 0;
+
+        switch (elements[1].Type)
+        {
+            case ShaderDataType::Short2:     return 1;
+            case ShaderDataType::Int2101010: return 2;
+            default:                         return 0;
+        }
+    }
+
+    // Dense id of key, in the order keys are first seen this frame
+    template<typename K>
+    static uint32_t GetKeyId(std::unordered_map<K, uint32_t>& ids, const K& key)
+    {
+        return ids.emplace(key, (uint32_t)ids.size()).first->second;
+    }
+
+    // center is where the mesh is in its own space, for the depth of the draw
+    static void Submit(const DrawCommand& command, const glm::mat4& transform, const glm::vec4& color, int id, uint32_t material,
+        const glm::vec3& center, int normalEncoding, const IndexRange* ranges, size_t count)
+    {
+        const void* source = command.Pool ? (const void*)command.Pool : (const void*)command.Mesh.get();
+        uint32_t vertexArray = GetKeyId(s_VertexArrayIds, source);
+        uint32_t mesh = GetKeyId(s_MeshIds, ((uint64_t)vertexArray << 32) | command.BaseVertex);
+
+        RenderPass pass = color.a < 1.0f ? RenderPass::Transparent : RenderPass::Opaque;
+        float depth = glm::length(glm::vec3(transform * glm::vec4(center, 1.0f)) - s_CameraPosition);
+        s_Queue.Submit(RenderQueue::MakeKey(pass, s_TriangleShaderKey, vertexArray, mesh, material, depth), (uint32_t)s_Commands.size());
+
+        s_Commands.push_back(command);
+        s_Commands.back().Mode = s_Fill ? GL_TRIANGLES : GL_LINE_LOOP;
+        s_Commands.back().Draw = (uint32_t)s_Draws.size();
+        s_Commands.back().FirstRange = (uint32_t)s_Ranges.size();
+        s_Commands.back().RangeCount = (uint32_t)count;
+
+        s_Draws.push_back({ transform, color, id, normalEncoding });
+        s_Ranges.insert(s_Ranges.end(), ranges, ranges + count);
+    }
+
+    static void Submit(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color, int id, uint32_t material,
+        const glm::vec3& center, const IndexRange* ranges, size_t count)
+    {
+        DrawCommand command = {};
+        command.Mesh = vertexArray;
+        Submit(command, transform, color, id, material, center, GetNormalEncoding(vertexArray), ranges, count);
+    }
+
+    // From the shared pool when drawing with multi draw indirect, else
+    // from the mesh's own vertex array
+    static void Submit(const Ref<Mesh>& mesh, const glm::mat4& transform, const glm::vec4& color, int id, uint32_t material,
+        const IndexRange* ranges, size_t count)
+    {
+        // Packed positions are fractions of the box, the transform scales them back
+        const auto& box = *mesh->BoundingBox;
+        glm::vec3 center = mesh->Format == VertexFormat::Float ? (box.first + box.second) * 0.5f : glm::vec3(0.5f);
+
+        if (!s_MultiDrawIndirect)
+        {
+            Submit(MeshCache::GetMesh(mesh), transform, color, id, material, center, ranges, count);
+            return;
+        }
+
+        const PooledMesh& pooled = MeshCache::GetPooled(mesh);
+        if (!pooled.Pool)
+            return;
+
+        DrawCommand command = {};
+        command.Pool = pooled.Pool;
+        command.BaseVertex = pooled.Allocation.BaseVertex;
+        command.FirstIndex = pooled.Allocation.FirstIndex;
+        Submit(command, transform, color, id, material, center, GetNormalEncoding(pooled.Pool->GetVertexArray()), ranges, count);
     }
 
     void Renderer::DrawMesh(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color, const int& id)
     {
-        s_TriangleShader->Bind();
-        s_TriangleShader->UploadUniformMat4("u_ViewProjection", s_SceneData->ViewProjectionMatrix);
-        s_TriangleShader->UploadUniformMat4("u_Transform", transform);
-        s_TriangleShader->UploadUniformFloat4("u_Color", color);
-        s_TriangleShader->UploadUniformInt("u_EntityID", id);
+        IndexRange all = { 0, vertexArray->GetIndexBuffer()->GetCount() };
+        Submit(vertexArray, transform, color, id, 0, glm::vec3(0.0f), &all, 1);
+    }
 
-        vertexArray->Bind();
-        glDrawElements(s_Fill? GL_TRIANGLES : GL_LINE_LOOP, vertexArray->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr);
+    void Renderer::DrawMesh(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color, const int& id, const std::vector<IndexRange>& ranges)
+    {
+        if (!ranges.empty())
+            Submit(vertexArray, transform, color, id, 0, glm::vec3(0.0f), ranges.data(), ranges.size());
+    }
+
+    void Renderer::DrawMesh(const Ref<Mesh>& mesh, const glm::mat4& transform, const glm::vec4& color, const int& id, uint32_t material)
+    {
+        IndexRange all = { 0, (uint32_t)mesh->Indexes->size() };
+        Submit(mesh, transform, color, id, material, &all, 1);
+    }
+
+    void Renderer::DrawMesh(const Ref<Mesh>& mesh, const glm::mat4& transform, const glm::vec4& color, const int& id, uint32_t material, const std::vector<IndexRange>& ranges)
+    {
+        if (!ranges.empty())
+            Submit(mesh, transform, color, id, material, ranges.data(), ranges.size());
     }
 
     void Renderer::DrawMesh(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color)
     {
         s_DefaultShader->Bind();
-        s_DefaultShader->UploadUniformMat4("u_ViewProjection", s_SceneData->ViewProjectionMatrix);
-        s_DefaultShader->UploadUniformMat4("u_Transform", transform);
-        s_DefaultShader->UploadUniformFloat4("u_Color", color);
+        s_DefaultShader->Set(s_DefaultUniforms.Transform, transform);
+        s_DefaultShader->Set(s_DefaultUniforms.Color, color);
 
+        const Ref<IndexBuffer>& indexBuffer = vertexArray->GetIndexBuffer();
         vertexArray->Bind();
-        glDrawElements(GL_LINE_LOOP, vertexArray->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr);
+        glDrawElements(GL_LINE_LOOP, indexBuffer->GetCount(), IndexTypeToOpenGL(indexBuffer->GetType()), nullptr);
     }
 
     void Renderer::DrawLines(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color, size_t size)
     {
         s_DefaultShader->Bind();
-        s_DefaultShader->UploadUniformMat4("u_ViewProjection", s_SceneData->ViewProjectionMatrix);
-        s_DefaultShader->UploadUniformMat4("u_Transform", transform);
-        s_DefaultShader->UploadUniformFloat4("u_Color", color);
+        s_DefaultShader->Set(s_DefaultUniforms.Transform, transform);
+        s_DefaultShader->Set(s_DefaultUniforms.Color, color);
 
         vertexArray->Bind();
         glDrawArrays(GL_LINES, 0, size * 2);
@@ -69,9 +429,8 @@ namespace GLMV {
     void Renderer::DrawPoints(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color, size_t size)
     {
         s_DefaultShader->Bind();
-        s_DefaultShader->UploadUniformMat4("u_ViewProjection", s_SceneData->ViewProjectionMatrix);
-        s_DefaultShader->UploadUniformMat4("u_Transform", transform);
-        s_DefaultShader->UploadUniformFloat4("u_Color", color);
+        s_DefaultShader->Set(s_DefaultUniforms.Transform, transform);
+        s_DefaultShader->Set(s_DefaultUniforms.Color, color);
 
         vertexArray->Bind();
         glDrawArrays(GL_POINTS, 0, size);
@@ -80,55 +439,42 @@ namespace GLMV {
     void Renderer::DrawCube(const glm::mat4& transform, const glm::vec4& color)
     {
         s_DefaultShader->Bind();
-        s_DefaultShader->UploadUniformMat4("u_ViewProjection", s_SceneData->ViewProjectionMatrix);
-        s_DefaultShader->UploadUniformMat4("u_Transform", transform);
-        s_DefaultShader->UploadUniformFloat4("u_Color", color);
+        s_DefaultShader->Set(s_DefaultUniforms.Transform, transform);
+        s_DefaultShader->Set(s_DefaultUniforms.Color, color);
 
-        float vertices[] =
-        { //     UNIT CUBE      COORDINATES         
-            0.500000, -0.500000, -0.500000,
-            0.500000, -0.500000,  0.500000,
-           -0.500000, -0.500000,  0.500000,
-           -0.500000, -0.500000, -0.500000,
-            0.500000,  0.500000, -0.500000,
-            0.500000,  0.500000,  0.500000,
-           -0.500000,  0.500000,  0.500000,
-           -0.500000,  0.500000, -0.500000,
-        };
+        s_CubeVertexArray->Bind();
+        glDrawElements(GL_LINE_LOOP, s_CubeVertexArray->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr);
+    }
 
-        uint32_t indices[] =
-        {
-            1,2,3,
-            7,6,5,
-            4,5,1,
-            5,6,2,
-            2,6,7,
-            0,3,7,
-            0,1,3,
-            4,7,5,
-            0,4,1,
-            1,5,2,
-            3,2,7,
-            4,0,7
-        };
+    void Renderer::SetFill(bool fill)
+    {
+        s_Fill = fill;
+    }
 
-        auto vertexArray = VertexArray::Create();
-        Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create(vertices, sizeof(vertices));
-        vertexBuffer->SetLayout({
-            { ShaderDataType::Float3, "a_Position" },
-            });
-        vertexArray->AddVertexBuffer(vertexBuffer);
+    bool Renderer::GetFill()
+    {
+        return s_Fill;
+    }
 
-        Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(indices, sizeof(indices));
-        vertexArray->SetIndexBuffer(indexBuffer);
+    void Renderer::SetMultiDrawIndirect(bool multiDrawIndirect)
+    {
+        s_MultiDrawIndirect = multiDrawIndirect;
+        MeshCache::SetPooled(multiDrawIndirect);
+    }
 
-        vertexArray->Bind();
-        glDrawElements(GL_LINE_LOOP, vertexArray->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr);
+    bool Renderer::GetMultiDrawIndirect()
+    {
+        return s_MultiDrawIndirect;
     }
 
-    void Renderer::SetFill(bool fill)
+    const RenderStats& Renderer::GetStats()
     {
-        s_Fill = fill;
+        return s_Stats;
+    }
+
+    bool Renderer::GetBackfaceCulling()
+    {
+        return s_BackfaceCulling;
     }
 
     void Renderer::SetPointSize(float size)
@@ -156,6 +502,7 @@ namespace GLMV {
 
     void Renderer::SetBackfaceCulling(bool backfaceculling)
     {
+        s_BackfaceCulling = backfaceculling;
         if (backfaceculling)
             glEnable(GL_CULL_FACE);
         else
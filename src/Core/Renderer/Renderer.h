@@ -3,9 +3,21 @@
 #include "Core/Renderer/Camera.h"
 #include "Core/Renderer/Shader.h"
 #include "Core/Renderer/VertexArray.h"
+#include "Core/Renderer/Mesh.h"
 
 namespace GLMV {
 
+    // Mesh draws of the last EndScene
+    struct RenderStats
+    {
+        // Recorded by DrawMesh, a draw call each without batching
+        uint32_t MeshDraws = 0;
+        // Issued after instancing and multi draw indirect
+        uint32_t DrawCalls = 0;
+        // Vertex arrays bound, once per run of draws sharing one
+        uint32_t Binds = 0;
+    };
+
     class Renderer
     {
         public:
@@ -14,10 +26,28 @@ namespace GLMV {
 
             static void OnWindowResize(uint32_t width, uint32_t height);
 
+            // Uploads the camera to the uniform buffer every shader reads it from
             static void BeginScene(Camera& camera);
+            // Draws the meshes recorded since BeginScene
             static void EndScene();
 
+            // Logs where the layout of vertexArray does not feed the inputs
+            // of the renderer's shaders. Layouts stay as they are built, so
+            // this runs once where a vertex array is created, not per bind.
+            static bool CheckLayout(const VertexArray& vertexArray);
+
+            // Recorded and drawn in EndScene, after one upload of every
+            // transform, color and id of the frame. Draws go through a
+            // RenderQueue: opaque ones grouped by vertex array, where draws of
+            // the same index range become instances of one draw call, then
+            // those with a color alpha below 1 back to front.
             static void DrawMesh(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color, const int& id);
+            // Only the given parts of the index buffer, in one multi draw
+            static void DrawMesh(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color, const int& id, const std::vector<IndexRange>& ranges);
+            // The mesh from MeshCache, or from its shared pool with multi draw
+            // indirect. Draws of one mesh are sorted by material.
+            static void DrawMesh(const Ref<Mesh>& mesh, const glm::mat4& transform, const glm::vec4& color, const int& id, uint32_t material);
+            static void DrawMesh(const Ref<Mesh>& mesh, const glm::mat4& transform, const glm::vec4& color, const int& id, uint32_t material, const std::vector<IndexRange>& ranges);
             static void DrawMesh(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color);
             static void DrawLines(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color, size_t size = 1);
             static void DrawPoints(const Ref<VertexArray>& vertexArray, const glm::mat4& transform, const glm::vec4& color, size_t size = 1);
@@ -27,12 +57,20 @@ namespace GLMV {
             static void SetZBuffer(bool zbuffer);
             static void SetBackfaceCulling(bool backfaceculling);
             static void SetFill(bool fill);
+            static bool GetBackfaceCulling();
+            static bool GetFill();
+            // Draws meshes from a few shared buffers, every pool and mode
+            // in one glMultiDrawElementsIndirect
+            static void SetMultiDrawIndirect(bool multiDrawIndirect);
+            static bool GetMultiDrawIndirect();
+            static const RenderStats& GetStats();
             static void SetPointSize(float size);
             static void SetLineSize(float size);
 
             static void SetClearColor(const glm::vec4& color);
             static void Clear();
         private:
+            // Camera block of the shaders, std140
             struct SceneData
             {
                 glm::mat4 ViewProjectionMatrix;
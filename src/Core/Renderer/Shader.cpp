@@ -1,5 +1,6 @@
 #include "Shader.h"
 
+#include <cstring>
 #include <fstream>
 #include <glad/glad.h>
 
@@ -18,6 +19,41 @@ namespace GLMV {
         return 0;
     }
 
+    static ShaderDataType ShaderDataTypeFromOpenGL(GLenum type)
+    {
+        switch (type)
+        {
+            case GL_FLOAT:       return ShaderDataType::Float;
+            case GL_FLOAT_VEC2:  return ShaderDataType::Float2;
+            case GL_FLOAT_VEC3:  return ShaderDataType::Float3;
+            case GL_FLOAT_VEC4:  return ShaderDataType::Float4;
+            case GL_FLOAT_MAT3:  return ShaderDataType::Mat3;
+            case GL_FLOAT_MAT4:  return ShaderDataType::Mat4;
+            case GL_INT:         return ShaderDataType::Int;
+            case GL_INT_VEC2:    return ShaderDataType::Int2;
+            case GL_INT_VEC3:    return ShaderDataType::Int3;
+            case GL_INT_VEC4:    return ShaderDataType::Int4;
+            case GL_BOOL:        return ShaderDataType::Bool;
+            // Samplers are set through their texture unit
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_CUBE: return ShaderDataType::Int;
+        }
+
+        return ShaderDataType::None;
+    }
+
+    // Name of a program resource, without the [0] of arrays
+    static std::string GetResourceName(GLuint program, GLenum interface, GLuint index, GLint length)
+    {
+        std::string name(length, '\0');
+        glGetProgramResourceName(program, interface, index, length, nullptr, &name[0]);
+        name.resize(strlen(name.c_str()));
+
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            name.resize(name.size() - 3);
+        return name;
+    }
+
     Shader::Shader(const std::string& filepath)
     {
         std::string source = ReadFile(filepath);
@@ -83,6 +119,9 @@ namespace GLMV {
 
     void Shader::Compile(const std::unordered_map<GLenum, std::string>& shaderSources)
     {
+        for (auto& kv : shaderSources)
+            m_Source += kv.second;
+
         GLuint program = glCreateProgram();
         std::vector<GLenum> glShaderIDs(shaderSources.size());
         for (auto& kv : shaderSources)
@@ -148,6 +187,122 @@ namespace GLMV {
 
         for (auto id : glShaderIDs)
             glDetachShader(program, id);
+
+        Reflect();
+    }
+
+    void Shader::Reflect()
+    {
+        GLuint program = m_RendererID;
+
+        const GLenum variableProperties[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE };
+        auto variables = [&](GLenum interface, std::unordered_map<std::string, ShaderReflection::Variable>& result)
+        {
+            GLint count = 0;
+            glGetProgramInterfaceiv(program, interface, GL_ACTIVE_RESOURCES, &count);
+            for (GLint i = 0; i < count; ++i)
+            {
+                GLint values[4];
+                glGetProgramResourceiv(program, interface, i, 4, variableProperties, 4, nullptr, values);
+
+                // Block members and built-ins have no location
+                if (values[2] < 0)
+                    continue;
+
+                result[GetResourceName(program, interface, i, values[0])] = { values[2], ShaderDataTypeFromOpenGL(values[1]), values[3] };
+            }
+        };
+
+        const GLenum blockProperties[] = { GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+        auto blocks = [&](GLenum interface, std::unordered_map<std::string, ShaderReflection::Block>& result)
+        {
+            GLint count = 0;
+            glGetProgramInterfaceiv(program, interface, GL_ACTIVE_RESOURCES, &count);
+            for (GLint i = 0; i < count; ++i)
+            {
+                GLint values[3];
+                glGetProgramResourceiv(program, interface, i, 3, blockProperties, 3, nullptr, values);
+                result[GetResourceName(program, interface, i, values[0])] = { (uint32_t)i, (uint32_t)values[1], (uint32_t)values[2] };
+            }
+        };
+
+        variables(GL_UNIFORM, m_Reflection.Uniforms);
+        variables(GL_PROGRAM_INPUT, m_Reflection.Attributes);
+        blocks(GL_UNIFORM_BLOCK, m_Reflection.UniformBlocks);
+        blocks(GL_SHADER_STORAGE_BLOCK, m_Reflection.StorageBlocks);
+    }
+
+    int32_t Shader::FindUniform(const std::string& name, ShaderDataType type) const
+    {
+        auto it = m_Reflection.Uniforms.find(name);
+        if (it == m_Reflection.Uniforms.end())
+        {
+            // Declared but unused uniforms are dropped by the linker
+            if (m_Source.find(name) == std::string::npos)
+            {
+                LOG_ERROR("Shader %u has no uniform '%s'", m_RendererID, name.c_str());
+            }
+            return -1;
+        }
+
+        if (it->second.Type != type)
+        {
+            LOG_ERROR("Uniform '%s' of shader %u has another type than the one it is set with", name.c_str(), m_RendererID);
+            return -1;
+        }
+
+        return it->second.Location;
+    }
+
+    bool Shader::CheckLayout(const VertexArray& vertexArray) const
+    {
+        bool valid = true;
+        auto report = [&](const std::string& name, const char* problem)
+        {
+            valid = false;
+            if (m_LayoutErrors.insert(name).second)
+            {
+                LOG_ERROR("Vertex attribute '%s' of shader %u %s", name.c_str(), m_RendererID, problem);
+            }
+        };
+
+        // Locations as VertexArray::AddVertexBuffer hands them out
+        int32_t location = 0;
+        for (const auto& buffer : vertexArray.GetVertexBuffers())
+        {
+            for (const auto& element : buffer->GetLayout())
+            {
+                auto it = m_Reflection.Attributes.find(element.Name);
+                int32_t fed = location++;
+                if (it == m_Reflection.Attributes.end())
+                    continue;
+
+                switch (it->second.Type)
+                {
+                    case ShaderDataType::Float:
+                    case ShaderDataType::Float2:
+                    case ShaderDataType::Float3:
+                    case ShaderDataType::Float4:
+                    case ShaderDataType::Mat3:
+                    case ShaderDataType::Mat4:
+                        break;
+                    default:
+                        report(element.Name, "is not a float input, the vertex array only feeds floats");
+                        continue;
+                }
+
+                if (it->second.Location != fed)
+                    report(element.Name, "is at another location than the vertex array feeds it");
+            }
+        }
+
+        return valid;
+    }
+
+    int32_t Shader::FindUniform(const std::string& name) const
+    {
+        auto it = m_Reflection.Uniforms.find(name);
+        return it != m_Reflection.Uniforms.end() ? it->second.Location : -1;
     }
 
     void Shader::Bind() const
@@ -160,46 +315,74 @@ namespace GLMV {
         glUseProgram(0);
     }
 
+    void Shader::Set(const Uniform<int>& uniform, int value)
+    {
+        glProgramUniform1i(m_RendererID, uniform.Location, value);
+    }
+
+    void Shader::Set(const Uniform<float>& uniform, float value)
+    {
+        glProgramUniform1f(m_RendererID, uniform.Location, value);
+    }
+
+    void Shader::Set(const Uniform<glm::vec2>& uniform, const glm::vec2& value)
+    {
+        glProgramUniform2f(m_RendererID, uniform.Location, value.x, value.y);
+    }
+
+    void Shader::Set(const Uniform<glm::vec3>& uniform, const glm::vec3& value)
+    {
+        glProgramUniform3f(m_RendererID, uniform.Location, value.x, value.y, value.z);
+    }
+
+    void Shader::Set(const Uniform<glm::vec4>& uniform, const glm::vec4& value)
+    {
+        glProgramUniform4f(m_RendererID, uniform.Location, value.x, value.y, value.z, value.w);
+    }
+
+    void Shader::Set(const Uniform<glm::mat3>& uniform, const glm::mat3& matrix)
+    {
+        glProgramUniformMatrix3fv(m_RendererID, uniform.Location, 1, GL_FALSE, glm::value_ptr(matrix));
+    }
+
+    void Shader::Set(const Uniform<glm::mat4>& uniform, const glm::mat4& matrix)
+    {
+        glProgramUniformMatrix4fv(m_RendererID, uniform.Location, 1, GL_FALSE, glm::value_ptr(matrix));
+    }
+
     void Shader::UploadUniformInt(const std::string& name, int value)
     {
-        GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-        glUniform1i(location, value);
+        glUniform1i(FindUniform(name), value);
     }
 
     void Shader::UploadUniformFloat(const std::string& name, float value)
     {
-        GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-        glUniform1f(location, value);
+        glUniform1f(FindUniform(name), value);
     }
 
     void Shader::UploadUniformFloat2(const std::string& name, const glm::vec2& value)
     {
-        GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-        glUniform2f(location, value.x, value.y);
+        glUniform2f(FindUniform(name), value.x, value.y);
     }
 
     void Shader::UploadUniformFloat3(const std::string& name, const glm::vec3& value)
     {
-        GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-        glUniform3f(location, value.x, value.y, value.z);
+        glUniform3f(FindUniform(name), value.x, value.y, value.z);
     }
 
     void Shader::UploadUniformFloat4(const std::string& name, const glm::vec4& value)
     {
-        GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-        glUniform4f(location, value.x, value.y, value.z, value.w);
+        glUniform4f(FindUniform(name), value.x, value.y, value.z, value.w);
     }
 
     void Shader::UploadUniformMat3(const std::string& name, const glm::mat3& matrix)
     {
-        GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-        glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+        glUniformMatrix3fv(FindUniform(name), 1, GL_FALSE, glm::value_ptr(matrix));
     }
 
     void Shader::UploadUniformMat4(const std::string& name, const glm::mat4& matrix)
     {
-        GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+        glUniformMatrix4fv(FindUniform(name), 1, GL_FALSE, glm::value_ptr(matrix));
     }
 
 }
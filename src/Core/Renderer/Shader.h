@@ -1,12 +1,57 @@
 #pragma once
 
 #include "Base.h"
+#include "Core/Renderer/Buffer.h"
+#include "Core/Renderer/VertexArray.h"
 #include <glm/glm.hpp>
 
 typedef unsigned int GLenum;
 
 namespace GLMV {
 
+    template<typename T> constexpr ShaderDataType ShaderDataTypeOf() = delete;
+    template<> constexpr ShaderDataType ShaderDataTypeOf<int>() { return ShaderDataType::Int; }
+    template<> constexpr ShaderDataType ShaderDataTypeOf<float>() { return ShaderDataType::Float; }
+    template<> constexpr ShaderDataType ShaderDataTypeOf<glm::vec2>() { return ShaderDataType::Float2; }
+    template<> constexpr ShaderDataType ShaderDataTypeOf<glm::vec3>() { return ShaderDataType::Float3; }
+    template<> constexpr ShaderDataType ShaderDataTypeOf<glm::vec4>() { return ShaderDataType::Float4; }
+    template<> constexpr ShaderDataType ShaderDataTypeOf<glm::mat3>() { return ShaderDataType::Mat3; }
+    template<> constexpr ShaderDataType ShaderDataTypeOf<glm::mat4>() { return ShaderDataType::Mat4; }
+
+    // Location of a uniform of type T, looked up once. Setting an invalid
+    // one does nothing, as with any uniform the linker dropped.
+    template<typename T>
+    struct Uniform
+    {
+        int32_t Location = -1;
+
+        bool IsValid() const { return Location >= 0; }
+    };
+
+    // What linking the program left active, by name
+    struct ShaderReflection
+    {
+        struct Variable
+        {
+            int32_t Location;
+            ShaderDataType Type;
+            // Elements of an array, 1 otherwise
+            int32_t Size;
+        };
+
+        struct Block
+        {
+            uint32_t Index;
+            uint32_t Binding;
+            uint32_t Size;
+        };
+
+        std::unordered_map<std::string, Variable> Uniforms;
+        std::unordered_map<std::string, Variable> Attributes;
+        std::unordered_map<std::string, Block> UniformBlocks;
+        std::unordered_map<std::string, Block> StorageBlocks;
+    };
+
     class Shader
     {
         public:
@@ -20,6 +65,31 @@ namespace GLMV {
             virtual void Bind() const;
             virtual void Unbind() const;
 
+            const ShaderReflection& GetReflection() const { return m_Reflection; }
+
+            // Handle of the active uniform name. Logs once, here, when the
+            // sources do not declare it or declare it with another type;
+            // a declared uniform the linker dropped is silently invalid.
+            template<typename T>
+            Uniform<T> GetUniform(const std::string& name) const { return { FindUniform(name, ShaderDataTypeOf<T>()) }; }
+
+            // Whether the attributes of vertexArray reach the inputs of the
+            // same name: at their location, and as floats, which is all
+            // VertexArray feeds. Each mismatch is logged once. Attributes the
+            // shader does not read are fine.
+            bool CheckLayout(const VertexArray& vertexArray) const;
+
+            // Set on the program, bound or not
+            void Set(const Uniform<int>& uniform, int value);
+            void Set(const Uniform<float>& uniform, float value);
+            void Set(const Uniform<glm::vec2>& uniform, const glm::vec2& value);
+            void Set(const Uniform<glm::vec3>& uniform, const glm::vec3& value);
+            void Set(const Uniform<glm::vec4>& uniform, const glm::vec4& value);
+            void Set(const Uniform<glm::mat3>& uniform, const glm::mat3& matrix);
+            void Set(const Uniform<glm::mat4>& uniform, const glm::mat4& matrix);
+
+            // By name, for code off the hot path. Looked up in the reflected
+            // uniforms instead of asking the driver.
             void UploadUniformInt(const std::string& name, int value);
 
             void UploadUniformFloat(const std::string& name, float value);
@@ -33,8 +103,16 @@ namespace GLMV {
             std::string ReadFile(const std::string& filepath);
             std::unordered_map<GLenum, std::string> PreProcess(const std::string& source);
             void Compile(const std::unordered_map<GLenum, std::string>& shaderSources);
+            void Reflect();
+            int32_t FindUniform(const std::string& name, ShaderDataType type) const;
+            int32_t FindUniform(const std::string& name) const;
         private:
             uint32_t m_RendererID;
+            ShaderReflection m_Reflection;
+            // All stages, to tell undeclared uniforms from dropped ones
+            std::string m_Source;
+            // Attributes CheckLayout already logged
+            mutable std::unordered_set<std::string> m_LayoutErrors;
     };
 
 }
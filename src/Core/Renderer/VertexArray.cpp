@@ -19,6 +19,10 @@ namespace GLMV {
             case GLMV::ShaderDataType::Int3:     return GL_INT;
             case GLMV::ShaderDataType::Int4:     return GL_INT;
             case GLMV::ShaderDataType::Bool:     return GL_BOOL;
+            case GLMV::ShaderDataType::UShort4:  return GL_UNSIGNED_SHORT;
+            case GLMV::ShaderDataType::Short2:   return GL_SHORT;
+            case GLMV::ShaderDataType::Int2101010: return GL_INT_2_10_10_10_REV;
+            case GLMV::ShaderDataType::Half2:    return GL_HALF_FLOAT;
         }
 
         GLMV_ASSERT(false, "Unknown ShaderDataType!");
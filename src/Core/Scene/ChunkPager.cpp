@@ -0,0 +1,115 @@
+#include "ChunkPager.h"
+
+#include "Components.h"
+#include "Core/ThreadPool.h"
+#include "Core/Geometry/Extents.h"
+#include "Core/Loaders/ChunkStore.h"
+
+namespace GLMV {
+
+    // Reads in flight at once
+    static constexpr uint32_t s_MaxLoading = 4;
+    // Chunks swapped in per frame, each one is uploaded whole when drawn
+    static constexpr uint32_t s_MaxSwaps = 2;
+
+    // Points target at the streams of source, keeping its bounds, which
+    // streamed meshes know before their data is in
+    static void SwapStreams(Mesh& target, const Mesh& source)
+    {
+        target.Vertices = source.Vertices;
+        target.Indexes = source.Indexes;
+        target.Normals = source.Normals;
+        target.Vertex = source.Vertex;
+        target.TexCoords = source.TexCoords;
+        target.Colors = source.Colors;
+        target.Meshlets = source.Meshlets;
+        target.MarkDirty();
+    }
+
+    void ChunkPager::OnUpdate(entt::registry& registry, const Camera& camera)
+    {
+        Ref<LoadedChunk> loaded;
+        for (uint32_t swaps = 0; swaps < s_MaxSwaps && m_Loaded->Pop(loaded); ++swaps)
+        {
+            m_Loading--;
+
+            // The entity may be gone, or its handle reused by now
+            if (!registry.valid(loaded->Entity) || !registry.all_of<StreamedComponent, MeshComponent>(loaded->Entity))
+                continue;
+
+            auto& streamed = registry.get<StreamedComponent>(loaded->Entity);
+            auto& mesh = registry.get<MeshComponent>(loaded->Entity);
+            if (mesh.MeshVertex != loaded->Target)
+                continue;
+
+            SwapStreams(*mesh.MeshVertex, *loaded->Data);
+            streamed.Loading = false;
+            streamed.Resident = true;
+        }
+
+        struct Candidate
+        {
+            entt::entity Entity;
+            float Priority;
+            uint64_t Memory;
+        };
+
+        std::vector<Candidate> candidates;
+        auto view = registry.view<StreamedComponent, MeshComponent, TransformComponent>();
+        for (auto entity : view)
+        {
+            auto [streamed, mesh, transform] = view.get<StreamedComponent, MeshComponent, TransformComponent>(entity);
+            if (!streamed.Store || streamed.Chunk >= streamed.Store->GetChunks().size())
+                continue;
+
+            // Bounding sphere in world space, ranked by the angle it covers
+            const ChunkInfo& chunk = streamed.Store->GetChunks()[streamed.Chunk];
+            glm::vec3 center = glm::vec3(transform.GetTransform() * glm::vec4((chunk.Min + chunk.Max) * 0.5f, 1.0f));
+            float radius = glm::length(chunk.Max - chunk.Min) * 0.5f * glm::compMax(glm::abs(transform.Scale));
+            float distance = std::max(glm::length(center - camera.GetPosition()) - radius, 1e-4f);
+            candidates.push_back({ entity, radius / distance, chunk.GetMemory() });
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.Priority > b.Priority; });
+
+        // The best chunks up to the budget stay, everything after the first
+        // one that does not fit goes, so the resident set has no holes
+        m_Resident = 0;
+        uint64_t wanted = 0;
+        bool full = false;
+        for (const auto& candidate : candidates)
+        {
+            auto& streamed = registry.get<StreamedComponent>(candidate.Entity);
+            auto& mesh = registry.get<MeshComponent>(candidate.Entity);
+
+            full = full || wanted + candidate.Memory > m_Budget;
+            if (!full)
+            {
+                wanted += candidate.Memory;
+                if (streamed.Resident)
+                    m_Resident += candidate.Memory;
+                if (streamed.Resident || streamed.Loading || m_Loading >= s_MaxLoading)
+                    continue;
+
+                streamed.Loading = true;
+                m_Loading++;
+
+                Ref<LoadedChunk> job = CreateRef<LoadedChunk>();
+                job->Entity = candidate.Entity;
+                job->Target = mesh.MeshVertex;
+                ThreadPool::Get().Submit([job, store = streamed.Store, chunk = streamed.Chunk, queue = m_Loaded]()
+                {
+                    job->Data = store->Load(chunk);
+                    queue->Push(job);
+                });
+            }
+            else if (streamed.Resident)
+            {
+                Ref<Mesh> empty = Mesh::Create();
+                SwapStreams(*mesh.MeshVertex, *empty);
+                streamed.Resident = false;
+            }
+        }
+    }
+
+}
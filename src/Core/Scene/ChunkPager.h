@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/MPSCQueue.h"
+#include "Core/Renderer/Camera.h"
+#include "Core/Renderer/Mesh.h"
+
+#include "entt.hpp"
+
+namespace GLMV {
+
+    // Pages streamed chunks in and out of their meshes. Chunks are ranked by
+    // how large they appear from the camera, the best ones are kept resident
+    // up to the memory budget, the rest are dropped again. Reading a chunk
+    // happens on the thread pool, swapping it into the mesh on the main thread.
+    class ChunkPager
+    {
+        public:
+            ChunkPager() = default;
+
+            ChunkPager(const ChunkPager&) = delete;
+            ChunkPager& operator=(const ChunkPager&) = delete;
+
+            // Main thread only, once per frame before drawing
+            void OnUpdate(entt::registry& registry, const Camera& camera);
+
+            void SetBudget(uint64_t bytes) { m_Budget = bytes; }
+            uint64_t GetBudget() const { return m_Budget; }
+            uint64_t GetResidentBytes() const { return m_Resident; }
+        private:
+            struct LoadedChunk
+            {
+                entt::entity Entity;
+                Ref<Mesh> Target;
+                Ref<Mesh> Data;
+            };
+
+            uint64_t m_Budget = 2ull * 1024 * 1024 * 1024;
+            uint64_t m_Resident = 0;
+            uint32_t m_Loading = 0;
+            // Shared with the loads in flight, which may outlive the pager
+            Ref<MPSCQueue<Ref<LoadedChunk>>> m_Loaded = CreateRef<MPSCQueue<Ref<LoadedChunk>>>();
+    };
+
+}
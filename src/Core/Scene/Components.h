@@ -3,6 +3,10 @@
 #include "Core/UUID.h"
 #include "Core/Renderer/VertexArray.h"
 #include "Core/Renderer/Mesh.h"
+#include "Core/Renderer/MeshCache.h"
+#include "Core/Geometry/MeshOptimizer.h"
+#include "Core/Geometry/VertexQuantizer.h"
+#include "MaterialRegistry.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -13,6 +17,8 @@
 
 namespace GLMV {
 
+    class ChunkStore;
+
     struct IDComponent
     {
         UUID ID;
@@ -64,131 +70,86 @@ namespace GLMV {
         MeshComponent(const Ref<Mesh>& mesh, std::string name, std::filesystem::path path = "")
             : MeshVertex(mesh), Name(name), Filepath(path) {}
 
-        Ref<VertexArray> GetVertex() const
+        const Ref<VertexArray>& GetVertex() const
         {
-            Ref<VertexArray> VertexArray = VertexArray::Create();
-            Ref<std::vector<glm::vec3>> vertices = MeshVertex->Vertex;
-
-            Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create((float*)vertices->data(), vertices->size() * sizeof(glm::vec3));
-            BufferLayout layout = {
-                { ShaderDataType::Float3, "a_Position" },
-            };
-            vertexBuffer->SetLayout(layout);
-            VertexArray->AddVertexBuffer(vertexBuffer);
-            return VertexArray;
+            return MeshCache::GetVertex(MeshVertex);
         }
 
-        Ref<VertexArray> GetWireFrameMesh() const
+        const Ref<VertexArray>& GetWireFrameMesh() const
         {
-            Ref<VertexArray> VertexArray = VertexArray::Create();
-            Ref<std::vector<glm::vec3>> vertices = MeshVertex->Vertex;
-            Ref<std::vector<uint32_t>> indices = MeshVertex->Indexes;
-
-            Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create((float*)vertices->data(), vertices->size() * sizeof(glm::vec3));
-            BufferLayout layout = {
-                { ShaderDataType::Float3, "a_Position" },
-            };
-            vertexBuffer->SetLayout(layout);
-            VertexArray->AddVertexBuffer(vertexBuffer);
-
-            Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(indices->data(), indices->size());
-            VertexArray->SetIndexBuffer(indexBuffer);
-
-            return VertexArray;
+            return MeshCache::GetWireFrame(MeshVertex);
         }
 
-        Ref<VertexArray> GetMesh() const
+        const Ref<VertexArray>& GetMesh() const
         {
-#if 1
-            Ref<VertexArray> VertexArray = VertexArray::Create();
-            Ref<std::vector<glm::vec3>> vertices = MeshVertex->Vertices;
-            Ref<std::vector<uint32_t>> indices = MeshVertex->Indexes;
-
-            Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create((float*)vertices->data(), vertices->size() * sizeof(glm::vec3));
-            BufferLayout layout = {
-                { ShaderDataType::Float3, "a_Position" },
-                { ShaderDataType::Float3, "a_Normal" }
-            };
-            vertexBuffer->SetLayout(layout);
-            VertexArray->AddVertexBuffer(vertexBuffer);
-
-            Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(indices->data(), indices->size());
-            VertexArray->SetIndexBuffer(indexBuffer);
-
-            return VertexArray;
-#else
-             // Piramid
-         //  float vertices[] =
-         //  { //  COORDINATES     NORMALS  //
-         //      -0.5f, 0.0f,  0.5f,     0.83f, 0.70f, 0.44f,
-         //      -0.5f, 0.0f, -0.5f,     0.83f, 0.70f, 0.44f,
-         //       0.5f, 0.0f, -0.5f,     0.83f, 0.70f, 0.44f,
-         //       0.5f, 0.0f,  0.5f,     0.83f, 0.70f, 0.44f,
-         //       0.0f, 0.8f,  0.0f,     0.92f, 0.86f, 0.76f
-         //  };
-         //
-         //  uint32_t indices[] =
-         //  {
-         //      0, 1, 2,
-         //      0, 2, 3,
-         //      0, 1, 4,
-         //      1, 2, 4,
-         //      2, 3, 4,
-         //      3, 0, 4
-         //  };
-
-             // Cube
-            float vertices[] =
-            { //           COORDINATES         //          NORMALS              //
-                1.000000, -1.000000, -1.000000,  1.000000, -1.000000, -1.000000,
-                1.000000, -1.000000,  1.000000,  1.000000, -1.000000,  1.000000,
-               -1.000000, -1.000000,  1.000000, -1.000000, -1.000000,  1.000000,
-               -1.000000, -1.000000, -1.000000, -1.000000, -1.000000, -1.000000,
-                1.000000,  1.000000, -1.000000,  1.000000,  1.000000, -1.000000,
-                1.000000,  1.000000,  1.000000,  1.000000,  1.000000,  1.000000,
-               -1.000000,  1.000000,  1.000000, -1.000000,  1.000000,  1.000000,
-               -1.000000,  1.000000, -1.000000, -1.000000,  1.000000, -1.000000,
-            };
-
-            uint32_t indices[] =
-            {
-                1,2,3,
-                7,6,5,
-                4,5,1,
-                5,6,2,
-                2,6,7,
-                0,3,7,
-                0,1,3,
-                4,7,5,
-                0,4,1,
-                1,5,2,
-                3,2,7,
-                4,0,7
-            };
-
-            auto testVA = VertexArray::Create();
-            Ref<VertexBuffer> testVB = VertexBuffer::Create(vertices, sizeof(vertices));
-            testVB->SetLayout({
-                { ShaderDataType::Float3, "a_Position" },
-                { ShaderDataType::Float3, "a_Normal" }
-                });
-            testVA->AddVertexBuffer(testVB);
-
-            Ref<IndexBuffer> testIB = IndexBuffer::Create(indices, sizeof(indices));
-            testVA->SetIndexBuffer(testIB);
-            return testVA;
-#endif
+            return MeshCache::GetMesh(MeshVertex);
         }
     };
 
+    // Mesh whose data lives in a chunk store on disk. The scene pages it in
+    // and out of MeshVertex as the camera needs it.
+    struct StreamedComponent
+    {
+        Ref<ChunkStore> Store;
+        uint32_t Chunk = 0;
+        bool Resident = false;
+        bool Loading = false;
+
+        StreamedComponent() = default;
+        StreamedComponent(const StreamedComponent&) = default;
+        StreamedComponent(const Ref<ChunkStore>& store, uint32_t chunk)
+            : Store(store), Chunk(chunk) {}
+    };
+
+    // Vertex cache efficiency of the mesh before and after the import
+    // reordered it
+    struct VertexCacheComponent
+    {
+        VertexCacheStats Before;
+        VertexCacheStats After;
+
+        VertexCacheComponent() = default;
+        VertexCacheComponent(const VertexCacheComponent&) = default;
+        VertexCacheComponent(const VertexCacheStats& before, const VertexCacheStats& after)
+            : Before(before), After(after) {}
+    };
+
+    // Packed GPU vertex format of the mesh and the largest error it adds
+    struct QuantizationComponent
+    {
+        VertexFormat Format = VertexFormat::Float;
+        QuantizationError Error;
+
+        QuantizationComponent() = default;
+        QuantizationComponent(const QuantizationComponent&) = default;
+        QuantizationComponent(VertexFormat format, const QuantizationError& error)
+            : Format(format), Error(error) {}
+    };
+
+    // Simplified versions of the mesh of MeshComponent, coarsest last. The
+    // scene picks one per frame from the size of the entity on screen.
+    struct LodComponent
+    {
+        std::vector<Ref<Mesh>> Levels;
+        // 0 draws the mesh of MeshComponent, i draws Levels[i - 1]
+        uint32_t Active = 0;
+
+        LodComponent() = default;
+        LodComponent(const LodComponent&) = default;
+        LodComponent(const std::vector<Ref<Mesh>>& levels)
+            : Levels(levels) {}
+
+        uint32_t GetLevelCount() const { return (uint32_t)Levels.size() + 1; }
+    };
+
+    // The material itself lives in the MaterialRegistry of the scene
     struct MaterialComponent
     {
-        glm::vec4 Color{ 0.7f, 0.7f, 0.7f, 1.0f };
-        std::string Name;
+        MaterialHandle Material = MaterialRegistry::Default;
 
         MaterialComponent() = default;
         MaterialComponent(const MaterialComponent&) = default;
-        MaterialComponent(const glm::vec4 color, std::string Name = "Unnamed Mesh")
-            : Color(color), Name(Name) {}
+        MaterialComponent(MaterialHandle material)
+            : Material(material) {}
     };
 }
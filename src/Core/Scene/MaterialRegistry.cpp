@@ -0,0 +1,48 @@
+#include "MaterialRegistry.h"
+
+namespace GLMV {
+
+    MaterialRegistry::MaterialRegistry()
+    {
+        Intern({ "Default", glm::vec3(0.7f) });
+    }
+
+    // Name and the exact color and opacity bits, equal materials give equal keys
+    std::string MaterialRegistry::GetKey(const Material& material)
+    {
+        std::string key = material.Name;
+        key.push_back('\0');
+        key.append((const char*)&material.Diffuse, sizeof(material.Diffuse));
+        key.append((const char*)&material.Opacity, sizeof(material.Opacity));
+        return key;
+    }
+
+    MaterialHandle MaterialRegistry::Intern(const Material& material)
+    {
+        auto [it, added] = m_Handles.try_emplace(GetKey(material), (MaterialHandle)m_Materials.size());
+        if (added)
+            m_Materials.push_back(material);
+        return it->second;
+    }
+
+    const Material& MaterialRegistry::Get(MaterialHandle handle) const
+    {
+        return handle < m_Materials.size() ? m_Materials[handle] : m_Materials[Default];
+    }
+
+    void MaterialRegistry::Set(MaterialHandle handle, const Material& material)
+    {
+        if (handle >= m_Materials.size())
+            return;
+
+        // Edits can leave two handles with equal materials, the key then
+        // belongs to whichever was interned first
+        auto it = m_Handles.find(GetKey(m_Materials[handle]));
+        if (it != m_Handles.end() && it->second == handle)
+            m_Handles.erase(it);
+
+        m_Materials[handle] = material;
+        m_Handles.try_emplace(GetKey(material), handle);
+    }
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Base.h"
+#include "Core/Loaders/ImportData.h"
+
+namespace GLMV {
+
+    // Index of a material in the registry of its scene
+    using MaterialHandle = uint32_t;
+
+    // Materials of a scene, each one stored once. Entities refer to them by
+    // handle, so thousands of parts sharing a dozen materials hold a dozen
+    // materials, and the renderer gets an id it can sort draws by.
+    // Main thread only, like the registry of the scene.
+    class MaterialRegistry
+    {
+        public:
+            // Always valid, used by entities without a material of their own
+            static constexpr MaterialHandle Default = 0;
+
+            MaterialRegistry();
+
+            // Returns the handle of an equal material, adding it if there is none
+            MaterialHandle Intern(const Material& material);
+
+            const Material& Get(MaterialHandle handle) const;
+            // Changes the material for every entity using it
+            void Set(MaterialHandle handle, const Material& material);
+
+            const std::vector<Material>& GetMaterials() const { return m_Materials; }
+            size_t GetCount() const { return m_Materials.size(); }
+        private:
+            static std::string GetKey(const Material& material);
+
+            std::vector<Material> m_Materials;
+            std::unordered_map<std::string, MaterialHandle> m_Handles;
+    };
+
+}
@@ -2,13 +2,50 @@
 
 #include "Components.h"
 #include "Core/Renderer/Renderer.h"
+#include "Core/Renderer/MeshCache.h"
+#include "Core/Geometry/Extents.h"
+#include "Core/Geometry/Meshlets.h"
+#include "Core/Geometry/VertexQuantizer.h"
+#include "Core/ThreadPool.h"
 
 #include <glm/glm.hpp>
+#include <cmath>
 
 #include "Entity.h"
 
 namespace GLMV {
 
+    // Height on screen, as a share of the viewport, below which LOD 1 is used.
+    // Every further halving of the size moves one level coarser.
+    static constexpr float s_LodFullDetail = 0.5f;
+    // Levels the size has to move past a switch point before the LOD
+    // changes, so it does not flicker while the camera sits near one
+    static constexpr float s_LodHysteresis = 0.2f;
+
+    static void SelectLod(LodComponent& lod, const Mesh& mesh, const TransformComponent& transform, const Camera& camera)
+    {
+        // Bounding sphere in world space against the vertical field of view
+        const auto& box = *mesh.BoundingBox;
+        glm::vec3 center = glm::vec3(transform.GetTransform() * glm::vec4((box.first + box.second) * 0.5f, 1.0f));
+        float radius = glm::length(box.second - box.first) * 0.5f * glm::compMax(glm::abs(transform.Scale));
+        float distance = glm::length(center - camera.GetPosition());
+
+        uint32_t active = 0;
+        if (distance > radius)
+        {
+            float size = radius * camera.GetProjection()[1][1] / distance;
+            float level = size > 0.0f ? std::log2(s_LodFullDetail / size) + 1.0f : (float)lod.GetLevelCount();
+
+            active = std::min(lod.Active, lod.GetLevelCount() - 1);
+            while (active + 1 < lod.GetLevelCount() && level >= active + 1 + s_LodHysteresis)
+                active++;
+            while (active > 0 && level < active - s_LodHysteresis)
+                active--;
+        }
+
+        lod.Active = active;
+    }
+
     Scene::Scene()
     {
     }
@@ -46,17 +83,68 @@ namespace GLMV {
 
     void Scene::OnUpdate(Timestep ts, Camera& camera)
     {
+        // Streamed meshes for this view, before anything is drawn
+        m_Pager.OnUpdate(m_Registry, camera);
+
         Renderer::BeginScene(camera);
+        m_Stats = {};
 
         auto group = m_Registry.group<TransformComponent, MeshComponent, MaterialComponent>();
         for (auto entity : group)
         {
             auto [transform, mesh, material] = group.get<TransformComponent, MeshComponent, MaterialComponent>(entity);
 
-            Renderer::DrawMesh(mesh.GetMesh(), transform.GetTransform(), material.Color, (uint32_t)entity);
+            // streamed chunks that are not paged in
+            if (mesh.MeshVertex->Indexes->empty())
+                continue;
+
+            const Ref<Mesh>* drawn = &mesh.MeshVertex;
+            if (auto* lod = m_Registry.try_get<LodComponent>(entity))
+            {
+                SelectLod(*lod, *mesh.MeshVertex, transform, camera);
+                if (lod->Active > 0)
+                    drawn = &lod->Levels[lod->Active - 1];
+            }
+
+            m_Stats.Meshes++;
+            m_Stats.FullTriangles += mesh.MeshVertex->Indexes->size() / 3;
+
+            glm::mat4 model = transform.GetTransform();
+            const Material& drawnMaterial = m_Materials.Get(material.Material);
+            glm::vec4 color = glm::vec4(drawnMaterial.Diffuse, drawnMaterial.Opacity);
+
+            const Mesh& drawnMesh = **drawn;
+            // Packed positions are fractions of the box, culling stays in mesh space
+            glm::mat4 draw = model * VertexQuantizer::GetPositionDecode(drawnMesh);
+            if (drawnMesh.Meshlets->empty())
+            {
+                m_Stats.Triangles += drawnMesh.Indexes->size() / 3;
+                Renderer::DrawMesh(*drawn, draw, color, (uint32_t)entity, material.Material);
+                continue;
+            }
+
+            // Culled in mesh space. Mirroring transforms turn the winding
+            // around, their backfaces are left to the GPU.
+            glm::vec3 eye = glm::vec3(glm::inverse(model) * glm::vec4(camera.GetPosition(), 1.0f));
+            bool backfaces = Renderer::GetBackfaceCulling() && Renderer::GetFill() && glm::determinant(glm::mat3(model)) > 0.0f;
+            size_t visible = Meshlets::Cull(drawnMesh, camera.GetViewProjection() * model, eye, backfaces, m_Ranges, &ThreadPool::Get());
+
+            m_Stats.Meshlets += drawnMesh.Meshlets->size();
+            m_Stats.MeshletsDrawn += visible;
+            for (const auto& range : m_Ranges)
+                m_Stats.Triangles += range.Count / 3;
+
+            if (!m_Ranges.empty())
+                Renderer::DrawMesh(*drawn, draw, color, (uint32_t)entity, material.Material, m_Ranges);
         }
 
         Renderer::EndScene();
+        m_Stats.MeshDraws = Renderer::GetStats().MeshDraws;
+        m_Stats.DrawCalls = Renderer::GetStats().DrawCalls;
+        m_Stats.Binds = Renderer::GetStats().Binds;
+
+        // Release GPU buffers of meshes dropped since last frame
+        MeshCache::Collect();
     }
 
     void Scene::OnViewportResize(uint32_t width, uint32_t height)
@@ -4,6 +4,8 @@
 #include "Core/Renderer/Camera.h"
 #include "Core/Renderer/Shader.h"
 #include "Core/UUID.h"
+#include "ChunkPager.h"
+#include "MaterialRegistry.h"
 
 #include "entt.hpp"
 
@@ -11,6 +13,24 @@ namespace GLMV {
 
     class Entity;
 
+    // Counters of the last frame drawn
+    struct SceneStats
+    {
+        uint32_t Meshes = 0;
+        // As drawn, after LOD selection
+        uint64_t Triangles = 0;
+        // Had every mesh been drawn at full resolution
+        uint64_t FullTriangles = 0;
+        // Meshlets of the meshes drawn, and how many were in view
+        uint64_t Meshlets = 0;
+        uint64_t MeshletsDrawn = 0;
+        // Draw calls without batching, and as issued
+        uint32_t MeshDraws = 0;
+        uint32_t DrawCalls = 0;
+        // Vertex arrays bound by the render queue
+        uint32_t Binds = 0;
+    };
+
     class Scene
     {
         public:
@@ -24,10 +44,19 @@ namespace GLMV {
 
             void OnUpdate(Timestep ts, Camera& camera);
             void OnViewportResize(uint32_t width, uint32_t height);
+
+            ChunkPager& GetChunkPager() { return m_Pager; }
+            MaterialRegistry& GetMaterials() { return m_Materials; }
+            const SceneStats& GetStats() const { return m_Stats; }
         private:
             entt::registry m_Registry;
             uint32_t m_ViewportWidth = 0, m_ViewportHeight = 0;
             Ref<Shader> m_shader;
+            ChunkPager m_Pager;
+            MaterialRegistry m_Materials;
+            SceneStats m_Stats;
+            // Scratch for the visible meshlets of one mesh
+            std::vector<IndexRange> m_Ranges;
 
             friend class Entity;
             friend class SceneSerializer;
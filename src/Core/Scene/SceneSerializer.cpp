@@ -177,8 +177,7 @@ namespace GLMV {
             out << YAML::BeginMap; // MaterialComponent
 
             auto& tc = entity.GetComponent<MaterialComponent>();
-            out << YAML::Key << "Name" << YAML::Value << tc.Name;
-            out << YAML::Key << "Color" << YAML::Value << tc.Color;
+            out << YAML::Key << "Material" << YAML::Value << tc.Material;
             out << YAML::EndMap; // MaterialComponent
         }
 
@@ -190,6 +189,18 @@ namespace GLMV {
         YAML::Emitter out;
         out << YAML::BeginMap;
 
+        // Entities refer to these by index
+        out << YAML::Key << "Materials" << YAML::Value << YAML::BeginSeq;
+        for (const Material& material : m_Scene->m_Materials.GetMaterials())
+        {
+            out << YAML::BeginMap;
+            out << YAML::Key << "Name" << YAML::Value << material.Name;
+            out << YAML::Key << "Diffuse" << YAML::Value << material.Diffuse;
+            out << YAML::Key << "Opacity" << YAML::Value << material.Opacity;
+            out << YAML::EndMap;
+        }
+        out << YAML::EndSeq;
+
         out << YAML::Key << "Entities" << YAML::Value << YAML::BeginSeq;
         m_Scene->m_Registry.each([&](auto entityID)
         {
@@ -220,6 +231,21 @@ namespace GLMV {
             return false;
         }
 
+        // Handles in the file, to handles in the registry of the scene
+        std::vector<MaterialHandle> materials;
+        auto materialsNode = data["Materials"];
+        if (materialsNode)
+        {
+            for (auto node : materialsNode)
+            {
+                Material material;
+                material.Name = node["Name"].as<std::string>();
+                material.Diffuse = node["Diffuse"].as<glm::vec3>();
+                material.Opacity = node["Opacity"].as<float>(1.0f);
+                materials.push_back(m_Scene->m_Materials.Intern(material));
+            }
+        }
+
         auto entities = data["Entities"];
         if (entities)
         {
@@ -276,8 +302,22 @@ namespace GLMV {
                 if (materialComponent)
                 {
                     auto& tc = deserializedEntity.AddComponent<MaterialComponent>();
-                    tc.Name = materialComponent["Name"].as<std::string>();
-                    tc.Color = materialComponent["Color"].as<glm::vec4>();
+                    if (materialComponent["Material"])
+                    {
+                        uint32_t index = materialComponent["Material"].as<uint32_t>();
+                        if (index < materials.size())
+                            tc.Material = materials[index];
+                    }
+                    else if (materialComponent["Color"])
+                    {
+                        // Scenes saved before the registry carry the material inline
+                        Material material;
+                        material.Name = materialComponent["Name"].as<std::string>("");
+                        glm::vec4 color = materialComponent["Color"].as<glm::vec4>();
+                        material.Diffuse = glm::vec3(color);
+                        material.Opacity = color.a;
+                        tc.Material = m_Scene->m_Materials.Intern(material);
+                    }
                 }
 
             }
@@ -0,0 +1,117 @@
+#include "ThreadPool.h"
+
+namespace GLMV {
+
+    ThreadPool::ThreadPool(uint32_t threads)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+
+        m_Workers.reserve(threads);
+        for (uint32_t i = 0; i < threads; ++i)
+            m_Workers.emplace_back([this]() { WorkerLoop(); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Condition.notify_all();
+
+        for (auto& worker : m_Workers)
+            worker.join();
+    }
+
+    void ThreadPool::Submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Jobs.push_back(std::move(job));
+        }
+        m_Condition.notify_one();
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Condition.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+                if (m_Stop && m_Jobs.empty())
+                    return;
+
+                job = std::move(m_Jobs.front());
+                m_Jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn)
+    {
+        if (count == 0)
+            return;
+
+        if (count == 1)
+        {
+            fn(0);
+            return;
+        }
+
+        // Helpers that start after every index was claimed return right away,
+        // so the caller only waits for the ones that are actually running.
+        struct State
+        {
+            std::atomic<size_t> Next{ 0 };
+            size_t Count = 0;
+            const std::function<void(size_t)>* Fn = nullptr;
+            std::mutex Mutex;
+            std::condition_variable Done;
+            uint32_t Active = 0;
+        };
+
+        auto state = CreateRef<State>();
+        state->Count = count;
+        state->Fn = &fn;
+
+        auto run = [](State& s) {
+            for (size_t i = s.Next++; i < s.Count; i = s.Next++)
+                (*s.Fn)(i);
+        };
+
+        size_t helpers = std::min<size_t>(GetThreadCount(), count - 1);
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            Submit([state, run]() {
+                {
+                    std::lock_guard<std::mutex> lock(state->Mutex);
+                    if (state->Next >= state->Count)
+                        return;
+                    state->Active++;
+                }
+
+                run(*state);
+
+                std::lock_guard<std::mutex> lock(state->Mutex);
+                if (--state->Active == 0)
+                    state->Done.notify_all();
+            });
+        }
+
+        run(*state);
+
+        std::unique_lock<std::mutex> lock(state->Mutex);
+        state->Done.wait(lock, [&]() { return state->Active == 0; });
+    }
+
+    ThreadPool& ThreadPool::Get()
+    {
+        static ThreadPool s_Pool;
+        return s_Pool;
+    }
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Base.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace GLMV {
+
+    class ThreadPool
+    {
+        public:
+            // 0 threads means one per hardware thread
+            ThreadPool(uint32_t threads = 0);
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            void Submit(std::function<void()> job);
+
+            // Runs fn(i) for every i in [0, count) and returns when all are done.
+            // The calling thread takes part, so it is safe to nest.
+            void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+            uint32_t GetThreadCount() const { return (uint32_t)m_Workers.size(); }
+
+            // Shared pool used by the loaders
+            static ThreadPool& Get();
+
+        private:
+            void WorkerLoop();
+
+            std::vector<std::thread> m_Workers;
+            std::deque<std::function<void()>> m_Jobs;
+            std::mutex m_Mutex;
+            std::condition_variable m_Condition;
+            bool m_Stop = false;
+    };
+
+    // Splits [0, count) in blocks of blockSize and runs fn(begin, end) for
+    // each, on the pool when one is given and there is more than one block
+    template<typename Fn>
+    void ParallelForBlocks(ThreadPool* pool, size_t count, size_t blockSize, const Fn& fn)
+    {
+        size_t blocks = (count + blockSize - 1) / blockSize;
+        auto run = [&](size_t block) {
+            size_t begin = block * blockSize;
+            fn(begin, std::min(count, begin + blockSize));
+        };
+
+        if (pool && blocks > 1)
+        {
+            pool->ParallelFor(blocks, run);
+        }
+        else
+        {
+            for (size_t block = 0; block < blocks; ++block)
+                run(block);
+        }
+    }
+
+}
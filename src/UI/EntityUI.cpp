@@ -6,11 +6,11 @@
 
 #include "Core/Scene/Components.h"
 #include <tinyfiledialogs.h>
-#include "Core/Loaders/Obj.h"
+#include "Core/Loaders/Importer.h"
 
 namespace GLMV {
 
-    static char const* lFilterPatterns[1] = { "*.obj" };
+    static char const* lFilterPatterns[5] = { "*.obj", "*.ply", "*.stl", "*.gltf", "*.glb" };
 
     EntityUI::EntityUI(const Ref<Scene>& context)
     {
@@ -19,10 +19,19 @@ namespace GLMV {
 
     void EntityUI::SetScene(const Ref<Scene>& context)
     {
+        // Entities of an unfinished import belong to the old scene
+        m_Importer.Cancel();
+
         m_Context = context;
         m_SelectionContext = {};
     }
 
+    void EntityUI::OnUpdate()
+    {
+        if (m_Context)
+            m_Importer.OnUpdate(m_Context);
+    }
+
     void EntityUI::Render()
     {
         ImGui::Begin("Scene Entities");
@@ -42,8 +51,18 @@ namespace GLMV {
             // Right-click on blank space
             if (ImGui::BeginPopupContextWindow(0, 1))
             {
-                if (ImGui::MenuItem("Add Entity"))
+                if (ImGui::MenuItem("Add Entity", NULL, false, !m_Importer.IsBusy() && !m_Importer.IsStopping()))
                     ImportMesh();
+                if (ImGui::MenuItem("Add Directory", NULL, false, !m_Importer.IsBusy() && !m_Importer.IsStopping()))
+                    ImportDirectory();
+
+                ImGui::Separator();
+
+                if (ImGui::BeginMenu("Import Settings"))
+                {
+                    DrawImportSettings();
+                    ImGui::EndMenu();
+                }
 
                 ImGui::EndPopup();
             }
@@ -52,6 +71,8 @@ namespace GLMV {
 
         ImGui::End();
 
+        DrawImportProgress();
+
         ImGui::Begin("Properties");
         if (m_SelectionContext)
         {
@@ -114,19 +135,60 @@ namespace GLMV {
             ImGui::InputFloat3("Scale", glm::value_ptr(component.Scale));
         }
 
+        if (entity.HasComponent<VertexCacheComponent>())
+        {
+            auto& component = entity.GetComponent<VertexCacheComponent>();
+            ImGui::Text("ACMR: %.3f -> %.3f", component.Before.ACMR, component.After.ACMR);
+            ImGui::Text("ATVR: %.3f -> %.3f", component.Before.ATVR, component.After.ATVR);
+        }
+
+        if (entity.HasComponent<QuantizationComponent>())
+        {
+            auto& component = entity.GetComponent<QuantizationComponent>();
+            ImGui::Text("Vertex format: %s", component.Format == VertexFormat::Octahedral16 ? "16 bit, octahedral normals" : "16 bit, 10:10:10:2 normals");
+            ImGui::Text("Position error: %g", component.Error.Position);
+            ImGui::Text("Normal error: %.3f degrees", component.Error.Normal);
+        }
+
         if (entity.HasComponent<MaterialComponent>())
         {
             auto& component = entity.GetComponent<MaterialComponent>();
-            auto& tag = component.Name;
+            MaterialRegistry& materials = m_Context->GetMaterials();
+
+            if (ImGui::BeginCombo("Material", materials.Get(component.Material).Name.c_str()))
+            {
+                for (MaterialHandle handle = 0; handle < materials.GetCount(); ++handle)
+                {
+                    ImGui::PushID((int)handle);
+                    if (ImGui::Selectable(materials.Get(handle).Name.c_str(), handle == component.Material))
+                        component.Material = handle;
+                    ImGui::PopID();
+                }
+                ImGui::EndCombo();
+            }
+
+            // Edits apply to every entity sharing the material
+            Material material = materials.Get(component.Material);
+            bool changed = false;
 
             char buffer[256];
             memset(buffer, 0, sizeof(buffer));
-            std::strncpy(buffer, tag.c_str(), sizeof(buffer));
+            std::strncpy(buffer, material.Name.c_str(), sizeof(buffer) - 1);
             if (ImGui::InputText("Material Name##Material Tag", buffer, sizeof(buffer)))
             {
-                tag = std::string(buffer);
+                material.Name = std::string(buffer);
+                changed = true;
+            }
+            glm::vec4 color(material.Diffuse, material.Opacity);
+            if (ImGui::ColorEdit4("Color", glm::value_ptr(color)))
+            {
+                material.Diffuse = glm::vec3(color);
+                material.Opacity = color.a;
+                changed = true;
             }
-            ImGui::ColorEdit4("Color", glm::value_ptr(component.Color));
+
+            if (changed)
+                materials.Set(component.Material, material);
         }
     }
     void EntityUI::ImportMesh()
@@ -134,15 +196,121 @@ namespace GLMV {
         auto filepath = tinyfd_openFileDialog(
             "Load mesh...",
             NULL,
-            1,
+            5,
             lFilterPatterns,
             NULL,
-            false
+            true
         );
 
         if (!filepath)
             return;
 
-        ObjLoader::Load(std::string(filepath), m_Context);
+        // Multiple selections come back separated by '|'
+        std::vector<std::string> paths;
+        std::istringstream selection(filepath);
+        std::string path;
+        while (std::getline(selection, path, '|'))
+        {
+            if (!path.empty())
+                paths.push_back(path);
+        }
+
+        m_Importer.Import(paths, m_ImportOptions);
+    }
+
+    void EntityUI::ImportDirectory()
+    {
+        auto directory = tinyfd_selectFolderDialog("Load meshes from...", NULL);
+        if (!directory)
+            return;
+
+        std::vector<std::string> paths = Importer::FindModels(directory);
+        if (paths.empty())
+        {
+            LOG_WARN("No model files found in '%s'", directory);
+            return;
+        }
+
+        m_Importer.Import(paths, m_ImportOptions);
+    }
+
+    void EntityUI::DrawImportSettings()
+    {
+        ImGui::Checkbox("Split Large Meshes", &m_ImportOptions.SplitLargeMeshes);
+        ImGui::Checkbox("Optimize Vertex Cache", &m_ImportOptions.OptimizeVertexCache);
+        if (m_ImportOptions.OptimizeVertexCache)
+        {
+            ImGui::Checkbox("Optimize Overdraw", &m_ImportOptions.OptimizeOverdraw);
+            if (m_ImportOptions.OptimizeOverdraw)
+                ImGui::DragFloat("Overdraw Threshold", &m_ImportOptions.OverdrawThreshold, 0.01f, 1.0f, 2.0f);
+        }
+
+        ImGui::Checkbox("Generate LODs", &m_ImportOptions.GenerateLods);
+        if (m_ImportOptions.GenerateLods)
+        {
+            int levels = (int)m_ImportOptions.LodLevels;
+            if (ImGui::SliderInt("LOD Levels", &levels, 1, 8))
+                m_ImportOptions.LodLevels = (uint32_t)levels;
+            ImGui::SliderFloat("LOD Ratio", &m_ImportOptions.LodRatio, 0.05f, 0.9f);
+        }
+
+        ImGui::Checkbox("Build Meshlets", &m_ImportOptions.BuildMeshlets);
+
+        // In VertexFormat order
+        const char* formats[] = { "32 bit floats", "16 bit, octahedral normals", "16 bit, 10:10:10:2 normals" };
+        int format = (int)m_ImportOptions.GpuFormat;
+        if (ImGui::Combo("Vertex Format", &format, formats, IM_ARRAYSIZE(formats)))
+            m_ImportOptions.GpuFormat = (VertexFormat)format;
+    }
+
+    void EntityUI::DrawImportProgress()
+    {
+        if (!m_Importer.IsBusy())
+            return;
+
+        const ImportProgress& progress = m_Importer.GetProgress();
+
+        ImGui::Begin("Import");
+        ImGui::TextUnformatted(m_Importer.GetPath().c_str());
+
+        uint64_t total = progress.BytesTotal;
+        uint64_t read = progress.BytesRead;
+        char overlay[64];
+
+        uint64_t files = progress.Files;
+        if (files > 1 && progress.Stage != ImportStage::Uploading)
+        {
+            snprintf(overlay, sizeof(overlay), "%llu / %llu files", (unsigned long long)progress.FilesDone.load(), (unsigned long long)files);
+            ImGui::ProgressBar((float)progress.FilesDone / files, ImVec2(-1, 0), overlay);
+        }
+
+        switch (progress.Stage.load())
+        {
+            case ImportStage::Reading:
+            {
+                snprintf(overlay, sizeof(overlay), "%.1f / %.1f MB", read / 1048576.0, total / 1048576.0);
+                ImGui::ProgressBar(total ? (float)read / total : 0.0f, ImVec2(-1, 0), overlay);
+                break;
+            }
+            case ImportStage::Processing:
+            {
+                ImGui::ProgressBar(1.0f, ImVec2(-1, 0), "Processing meshes");
+                break;
+            }
+            default:
+            {
+                size_t count = m_Importer.GetMeshCount();
+                snprintf(overlay, sizeof(overlay), "%zu / %zu meshes", m_Importer.GetMeshesCreated(), count);
+                ImGui::ProgressBar(count ? (float)m_Importer.GetMeshesCreated() / count : 1.0f, ImVec2(-1, 0), overlay);
+                break;
+            }
+        }
+
+        ImGui::Text("Triangles: %llu", (unsigned long long)progress.Triangles.load());
+
+        if (ImGui::Button("Cancel"))
+            m_Importer.Cancel();
+
+        ImGui::End();
     }
 }
@@ -3,6 +3,7 @@
 #include "Core/Core.h"
 #include "Core/Scene/Scene.h"
 #include "Core/Scene/Entity.h"
+#include "Core/Loaders/AsyncImporter.h"
 
 namespace GLMV {
 
@@ -14,6 +15,7 @@ namespace GLMV {
 
             void SetScene(const Ref<Scene>& scene);
 
+            void OnUpdate();
             void Render();
 
             Entity GetSelectedEntity() const { return m_SelectionContext; }
@@ -22,9 +24,15 @@ namespace GLMV {
             void DrawEntity(Entity entity);
             void DrawComponents(Entity entity);
             void ImportMesh();
+            void ImportDirectory();
+            void DrawImportProgress();
+            void DrawImportSettings();
         private:
             Ref<Scene> m_Context;
             Entity m_SelectionContext;
+            AsyncImporter m_Importer;
+            // Applied to every import started from this panel
+            ImportOptions m_ImportOptions;
     };
 
 }
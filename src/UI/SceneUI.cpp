@@ -4,6 +4,7 @@
 #include "Core/Input.h"
 #include "Core/Renderer/Renderer.h"
 #include "Core/Scene/SceneSerializer.h"
+#include "Core/Loaders/ImportCache.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -113,6 +114,7 @@ namespace GLMV {
         Renderer::SetZBuffer(m_Zbuffer);
         Renderer::SetMultiSample(m_Multisample);
         Renderer::SetBackfaceCulling(m_BackfaceCulling);
+        Renderer::SetMultiDrawIndirect(m_MultiDrawIndirect);
         Renderer::SetPointSize(m_PointSize);
         Renderer::SetLineSize(m_LineSize);
     }
@@ -205,6 +207,9 @@ namespace GLMV {
 
     void SceneUI::OnUpdate(Timestep ts)
     {
+        // Finish background imports a slice at a time
+        m_SceneEntitiesPanel.OnUpdate();
+
         // Resize
         if (FramebufferSpecification spec = m_Framebuffer->GetSpecification();
                 m_ViewportSize.x > 0.0f && m_ViewportSize.y > 0.0f && // zero sized framebuffer is invalid
@@ -409,6 +414,8 @@ namespace GLMV {
                     Renderer::SetMultiSample(m_Multisample);
                 if (ImGui::Checkbox("Back Face Culling", &m_BackfaceCulling))
                     Renderer::SetBackfaceCulling(m_BackfaceCulling);
+                if (ImGui::Checkbox("Multi Draw Indirect", &m_MultiDrawIndirect))
+                    Renderer::SetMultiDrawIndirect(m_MultiDrawIndirect);
                 if (ImGui::DragFloat("Point Size", &m_PointSize, 1.0f, 1.0f, 100.0f))
                     Renderer::SetPointSize(m_PointSize);
                 if (ImGui::DragFloat("Line Size", &m_LineSize, 1.0f, 1.0f, 100.0f))
@@ -450,6 +457,27 @@ namespace GLMV {
         if (m_HoveredEntity)
             id_name = std::to_string(m_HoveredEntity.GetComponent<IDComponent>().ID);
         ImGui::Text("Hovered Entity ID: %s", id_name.c_str());
+
+        if (m_ActiveScene)
+        {
+            const SceneStats& stats = m_ActiveScene->GetStats();
+            ImGui::Text("Meshes: %u", stats.Meshes);
+            ImGui::Text("Triangles: %llu of %llu", (unsigned long long)stats.Triangles, (unsigned long long)stats.FullTriangles);
+            if (stats.Meshlets)
+                ImGui::Text("Meshlets: %llu of %llu", (unsigned long long)stats.MeshletsDrawn, (unsigned long long)stats.Meshlets);
+            ImGui::Text("Draw Calls: %u for %u mesh draws", stats.DrawCalls, stats.MeshDraws);
+            ImGui::Text("Vertex Array Binds: %u", stats.Binds);
+        }
+
+        Entity selected = m_SceneEntitiesPanel.GetSelectedEntity();
+        if (selected && selected.HasComponent<LodComponent>())
+        {
+            auto& lod = selected.GetComponent<LodComponent>();
+            ImGui::Text("Selected LOD: %u of %u", lod.Active, lod.GetLevelCount() - 1);
+        }
+
+        ImportCacheStats cache = ImportCache::GetStats();
+        ImGui::Text("Import Cache: %u hits, %u misses, %u evicted", cache.Hits, cache.Misses, cache.Evictions);
         
         ImGui::End();
     }
@@ -73,6 +73,7 @@ namespace GLMV {
             bool m_Zbuffer = true;
             bool m_Multisample = true;
             bool m_BackfaceCulling = true;
+            bool m_MultiDrawIndirect = false;
 
             bool m_ShowBoundingBox = false;
             bool m_ShowWireFrame = false;